@@ -76,6 +76,7 @@
 #include "avconv.h"
 #include "cmdutils.h"
 
+#include "libavutil/atomic.h"
 #include "libavutil/avassert.h"
 
 const char program_name[] = "avconv";
@@ -1269,7 +1270,7 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output)
             fb->buf->priv           = buf;
             fb->buf->free           = filter_release_buffer;
 
-            buf->refcount++;
+            avpriv_atomic_int_add_and_fetch(&buf->refcount, 1);
             av_buffersrc_buffer(ist->filters[i]->filter, fb);
         } else
             av_buffersrc_write_frame(ist->filters[i]->filter, decoded_frame);
@@ -2387,6 +2388,60 @@ static int64_t getmaxrss(void)
 #endif
 }
 
+/* the CPU time is -1 without a per thread CPU clock */
+static const char *format_cpu_time(char *buf, int64_t cpu)
+{
+    if (cpu < 0)
+        return "n/a";
+    snprintf(buf, 16, "%.3fs", cpu / 1000000.0);
+    return buf;
+}
+
+static void print_filter_stats(void)
+{
+    static const char *const callback_names[AVFILTER_STATS_NB_CALLBACKS] = {
+        [AVFILTER_STATS_START_FRAME]    = "start_frame",
+        [AVFILTER_STATS_DRAW_SLICE]     = "draw_slice",
+        [AVFILTER_STATS_END_FRAME]      = "end_frame",
+        [AVFILTER_STATS_FILTER_SAMPLES] = "filter_samples",
+        [AVFILTER_STATS_REQUEST_FRAME]  = "request_frame",
+    };
+    char buf[16];
+    int i, j, k;
+
+    for (i = 0; i < nb_filtergraphs; i++) {
+        AVFilterGraph *graph = filtergraphs[i]->graph;
+
+        if (!graph)
+            continue;
+        av_log(NULL, AV_LOG_INFO, "Filtergraph #%d:\n", i);
+        for (j = 0; j < graph->filter_count; j++) {
+            AVFilterContext *f = graph->filters[j];
+            const AVFilterStats *s = avfilter_get_stats(f);
+            int64_t wall = 0, cpu = 0;
+
+            if (!s)
+                continue;
+            for (k = 0; k < AVFILTER_STATS_NB_CALLBACKS; k++) {
+                wall += s->wall_time[k];
+                cpu   = cpu < 0 || s->cpu_time[k] < 0 ? -1 : cpu + s->cpu_time[k];
+            }
+            av_log(NULL, AV_LOG_INFO, "  %s (%s): frames in:%"PRId64" out:%"PRId64
+                   " max queued:%d wall:%.3fs cpu:%s\n",
+                   f->name, f->filter->name, s->frames_in, s->frames_out,
+                   s->max_queued, wall / 1000000.0, format_cpu_time(buf, cpu));
+            for (k = 0; k < AVFILTER_STATS_NB_CALLBACKS; k++) {
+                if (!s->calls[k])
+                    continue;
+                av_log(NULL, AV_LOG_INFO, "    %-14s calls:%-8"PRId64
+                       " wall:%.3fs cpu:%s\n", callback_names[k], s->calls[k],
+                       s->wall_time[k] / 1000000.0,
+                       format_cpu_time(buf, s->cpu_time[k]));
+            }
+        }
+    }
+}
+
 static void parse_cpuflags(int argc, char **argv, const OptionDef *options)
 {
     int idx = locate_option(argc, argv, options, "cpuflags");
@@ -2439,6 +2494,8 @@ int main(int argc, char **argv)
         int maxrss = getmaxrss() / 1024;
         printf("bench: utime=%0.3fs maxrss=%ikB\n", ti / 1000000.0, maxrss);
     }
+    if (filter_stats)
+        print_filter_stats();
 
     exit_program(0);
     return 0;
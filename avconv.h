@@ -338,6 +338,9 @@ extern int exit_on_error;
 extern int print_stats;
 extern int qp_hist;
 extern int same_quant;
+extern int filter_nbthreads;
+extern int filter_frame_threads;
+extern int filter_stats;
 
 extern const AVIOInterruptCB int_cb;
 
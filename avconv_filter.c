@@ -498,6 +498,10 @@ int configure_filtergraph(FilterGraph *fg)
     avfilter_graph_free(&fg->graph);
     if (!(fg->graph = avfilter_graph_alloc()))
         return AVERROR(ENOMEM);
+    fg->graph->nb_threads    = filter_nbthreads;
+    if (filter_frame_threads)
+        fg->graph->thread_type |= AVFILTER_THREAD_FRAME;
+    fg->graph->collect_stats = filter_stats;
 
     if (simple) {
         OutputStream *ost = fg->outputs[0]->ost;
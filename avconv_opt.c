@@ -74,6 +74,9 @@ int exit_on_error     = 0;
 int print_stats       = 1;
 int qp_hist           = 0;
 int same_quant        = 0;
+int filter_nbthreads  = 0;
+int filter_frame_threads = 0;
+int filter_stats      = 0;
 
 static int file_overwrite     = 0;
 static int video_discard      = 0;
@@ -1846,6 +1849,9 @@ const OptionDef options[] = {
     { "qscale", HAS_ARG | OPT_EXPERT | OPT_DOUBLE | OPT_SPEC, {.off = OFFSET(qscale)}, "use fixed quality scale (VBR)", "q" },
     { "filter", HAS_ARG | OPT_STRING | OPT_SPEC, {.off = OFFSET(filters)}, "set stream filterchain", "filter_list" },
     { "filter_complex", HAS_ARG | OPT_EXPERT, {(void*)opt_filter_complex}, "create a complex filtergraph", "graph_description" },
+    { "filter_threads", HAS_ARG | OPT_INT | OPT_EXPERT, {(void*)&filter_nbthreads}, "number of threads for each filtergraph, 0 for auto", "count" },
+    { "filter_frame_threads", OPT_BOOL | OPT_EXPERT, {(void*)&filter_frame_threads}, "run the filters supporting it on their own threads" },
+    { "filter_stats", OPT_BOOL | OPT_EXPERT, {(void*)&filter_stats}, "print the statistics of each filter at the end" },
     { "stats", OPT_BOOL, {&print_stats}, "print progress report during encoding", },
     { "attach", HAS_ARG | OPT_FUNC2, {(void*)opt_attach}, "add an attachment to the output file", "filename" },
     { "dump_attachment", HAS_ARG | OPT_STRING | OPT_SPEC, {.off = OFFSET(dump_attachment)}, "extract an attachment into a file", "filename" },
@@ -34,6 +34,7 @@
 #include "libavdevice/avdevice.h"
 #include "libavresample/avresample.h"
 #include "libswscale/swscale.h"
+#include "libavutil/atomic.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/mathematics.h"
@@ -1095,17 +1096,44 @@ static int alloc_buffer(FrameBuffer **pool, AVCodecContext *s, FrameBuffer **pbu
     return 0;
 }
 
+/*
+ * The buffers handed to the filters may be released on the threads of the
+ * filter graph, so the pool is a lock-free list. Only the decoding thread
+ * takes buffers out of it, so the head can not be taken and put back in
+ * between the two atomic operations of pop_buffer().
+ */
+static void push_buffer(FrameBuffer **pool, FrameBuffer *buf)
+{
+    FrameBuffer *cur = NULL, *prev;
+
+    buf->next = NULL;
+    while ((prev = avpriv_atomic_ptr_cas((void * volatile *)pool,
+                                         cur, buf)) != cur) {
+        cur       = prev;
+        buf->next = cur;
+    }
+}
+
+static FrameBuffer *pop_buffer(FrameBuffer **pool)
+{
+    FrameBuffer *buf = avpriv_atomic_ptr_cas((void * volatile *)pool, NULL, NULL);
+    FrameBuffer *prev;
+
+    while (buf && (prev = avpriv_atomic_ptr_cas((void * volatile *)pool,
+                                                buf, buf->next)) != buf)
+        buf = prev;
+    return buf;
+}
+
 int codec_get_buffer(AVCodecContext *s, AVFrame *frame)
 {
     FrameBuffer **pool = s->opaque;
     FrameBuffer *buf;
     int ret, i;
 
-    if (!*pool && (ret = alloc_buffer(pool, s, pool)) < 0)
+    if (!(buf = pop_buffer(pool)) && (ret = alloc_buffer(pool, s, &buf)) < 0)
         return ret;
 
-    buf              = *pool;
-    *pool            = buf->next;
     buf->next        = NULL;
     if (buf->w != s->width || buf->h != s->height || buf->pix_fmt != s->pix_fmt) {
         av_freep(&buf->base[0]);
@@ -1113,7 +1141,7 @@ int codec_get_buffer(AVCodecContext *s, AVFrame *frame)
         if ((ret = alloc_buffer(pool, s, &buf)) < 0)
             return ret;
     }
-    buf->refcount++;
+    avpriv_atomic_int_add_and_fetch(&buf->refcount, 1);
 
     frame->opaque        = buf;
     frame->type          = FF_BUFFER_TYPE_USER;
@@ -1135,14 +1163,11 @@ int codec_get_buffer(AVCodecContext *s, AVFrame *frame)
 
 static void unref_buffer(FrameBuffer *buf)
 {
-    FrameBuffer **pool = buf->pool;
+    int refcount = avpriv_atomic_int_add_and_fetch(&buf->refcount, -1);
 
-    av_assert0(buf->refcount);
-    buf->refcount--;
-    if (!buf->refcount) {
-        buf->next = *pool;
-        *pool = buf;
-    }
+    av_assert0(refcount >= 0);
+    if (!refcount)
+        push_buffer(buf->pool, buf);
 }
 
 void codec_release_buffer(AVCodecContext *s, AVFrame *frame)
@@ -416,7 +416,8 @@ int codec_get_buffer(AVCodecContext *s, AVFrame *frame);
 void codec_release_buffer(AVCodecContext *s, AVFrame *frame);
 
 /**
- * A callback to be used for AVFilterBuffer.free.
+ * A callback to be used for AVFilterBuffer.free. It may be called from any
+ * thread, the buffer is returned to the pool of codec_get_buffer().
  * @param fb buffer to free. fb->priv must be a pointer to the FrameBuffer
  *           containing the buffer data.
  */
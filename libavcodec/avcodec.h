@@ -2875,6 +2875,20 @@ typedef struct AVCodecContext {
      * - decoding: unused.
      */
     uint64_t vbv_delay;
+
+    /**
+     * Thread pool to run slice and frame threading jobs on, instead of
+     * starting dedicated threads for this context. The same pool may be
+     * shared by any number of codec contexts; jobs of different contexts
+     * are scheduled in turn. thread_count still sets the number of slices
+     * or frames processed concurrently; when it is 0 (auto) it is derived
+     * from the number of threads in the pool.
+     * The pool must not be freed before all the contexts using it are closed.
+     * @see avcodec_thread_pool_alloc()
+     * - encoding: Set by user before avcodec_open2().
+     * - decoding: Set by user before avcodec_open2().
+     */
+    struct AVCodecThreadPool *thread_pool;
 } AVCodecContext;
 
 /**
@@ -4325,6 +4339,28 @@ int avcodec_default_execute(AVCodecContext *c, int (*func)(AVCodecContext *c2, v
 int avcodec_default_execute2(AVCodecContext *c, int (*func)(AVCodecContext *c2, void *arg2, int, int),void *arg, int *ret, int count);
 //FIXME func typedef
 
+/**
+ * A set of worker threads which can be shared by several codec contexts.
+ * @see AVCodecContext.thread_pool
+ */
+typedef struct AVCodecThreadPool AVCodecThreadPool;
+
+/**
+ * Allocate a thread pool and start its worker threads.
+ *
+ * @param nb_threads number of worker threads, 0 to use one per logical CPU
+ * @return the new pool, NULL on failure or if threading is not supported
+ */
+AVCodecThreadPool *avcodec_thread_pool_alloc(int nb_threads);
+
+/**
+ * Stop the worker threads of a pool and free it.
+ * All the codec contexts using the pool must have been closed before.
+ *
+ * @param pool pointer to the pool to free, set to NULL afterwards
+ */
+void avcodec_thread_pool_free(AVCodecThreadPool **pool);
+
 /**
  * Fill audio frame data and linesize.
  * AVFrame extended_data channel pointers are allocated if necessary for
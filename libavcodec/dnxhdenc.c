@@ -311,14 +311,14 @@ static int dnxhd_encode_init(AVCodecContext *avctx)
     ctx->frame.pict_type = AV_PICTURE_TYPE_I;
     ctx->m.avctx->coded_frame = &ctx->frame;
 
-    if (avctx->thread_count > MAX_THREADS) {
-        av_log(avctx, AV_LOG_ERROR, "too many threads\n");
-        return -1;
-    }
+    FF_ALLOCZ_OR_GOTO(ctx->m.avctx, ctx->thread,
+                      FFMAX(avctx->thread_count, 1) * sizeof(*ctx->thread), fail);
 
     ctx->thread[0] = ctx;
     for (i = 1; i < avctx->thread_count; i++) {
         ctx->thread[i] =  av_malloc(sizeof(DNXHDEncContext));
+        if (!ctx->thread[i])
+            goto fail;
         memcpy(ctx->thread[i], ctx, sizeof(DNXHDEncContext));
     }
 
@@ -991,8 +991,11 @@ static int dnxhd_encode_end(AVCodecContext *avctx)
     av_freep(&ctx->qmatrix_c16);
     av_freep(&ctx->qmatrix_l16);
 
-    for (i = 1; i < avctx->thread_count; i++)
-        av_freep(&ctx->thread[i]);
+    if (ctx->thread) {
+        for (i = 1; i < avctx->thread_count; i++)
+            av_freep(&ctx->thread[i]);
+        av_freep(&ctx->thread);
+    }
 
     return 0;
 }
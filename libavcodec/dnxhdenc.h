@@ -50,7 +50,7 @@ typedef struct DNXHDEncContext {
     uint32_t *slice_size;
     uint32_t *slice_offs;
 
-    struct DNXHDEncContext *thread[MAX_THREADS];
+    struct DNXHDEncContext **thread; ///< per-thread contexts, avctx->thread_count entries
 
     // Because our samples are either 8 or 16 bits for 8-bit and 10-bit
     // encoding respectively, these refer either to bytes or to two-byte words.
@@ -768,7 +768,7 @@ static void free_tables(H264Context *h, int free_rbsp)
     av_freep(&h->mb2b_xy);
     av_freep(&h->mb2br_xy);
 
-    for (i = 0; i < MAX_THREADS; i++) {
+    for (i = 0; i < h->nb_thread_contexts; i++) {
         hx = h->thread_context[i];
         if (!hx)
             continue;
@@ -1034,6 +1034,18 @@ int ff_h264_decode_extradata(H264Context *h)
     return 0;
 }
 
+static int alloc_thread_contexts(H264Context *h)
+{
+    int count = FFMAX(h->s.avctx->thread_count, 1);
+
+    h->thread_context = av_mallocz(count * sizeof(*h->thread_context));
+    if (!h->thread_context)
+        return AVERROR(ENOMEM);
+    h->nb_thread_contexts = count;
+    h->thread_context[0]  = h;
+    return 0;
+}
+
 av_cold int ff_h264_decode_init(AVCodecContext *avctx)
 {
     H264Context *h = avctx->priv_data;
@@ -1061,7 +1073,9 @@ av_cold int ff_h264_decode_init(AVCodecContext *avctx)
     h->pixel_shift = 0;
     h->sps.bit_depth_luma = avctx->bits_per_raw_sample = 8;
 
-    h->thread_context[0] = h;
+    if (alloc_thread_contexts(h) < 0)
+        return AVERROR(ENOMEM);
+
     h->outputed_poc      = h->next_outputed_poc = INT_MIN;
     for (i = 0; i < MAX_DELAYED_PIC_COUNT; i++)
         h->last_pocs[i] = INT_MIN;
@@ -1128,6 +1142,10 @@ static int decode_init_thread_copy(AVCodecContext *avctx)
     memset(h->sps_buffers, 0, sizeof(h->sps_buffers));
     memset(h->pps_buffers, 0, sizeof(h->pps_buffers));
 
+    /* the copied array belongs to the source context */
+    if (alloc_thread_contexts(h) < 0)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -1152,6 +1170,9 @@ static int decode_update_thread_context(AVCodecContext *dst,
 
     // FIXME handle width/height changing
     if (!inited) {
+        H264Context **thread_context;
+        int nb_thread_contexts;
+
         for (i = 0; i < MAX_SPS_COUNT; i++)
             av_freep(h->sps_buffers + i);
 
@@ -1159,8 +1180,12 @@ static int decode_update_thread_context(AVCodecContext *dst,
             av_freep(h->pps_buffers + i);
 
         // copy all fields after MpegEnc
+        thread_context     = h->thread_context;
+        nb_thread_contexts = h->nb_thread_contexts;
         memcpy(&h->s + 1, &h1->s + 1,
                sizeof(H264Context) - sizeof(MpegEncContext));
+        h->thread_context     = thread_context;
+        h->nb_thread_contexts = nb_thread_contexts;
         memset(h->sps_buffers, 0, sizeof(h->sps_buffers));
         memset(h->pps_buffers, 0, sizeof(h->pps_buffers));
         if (ff_h264_alloc_tables(h) < 0) {
@@ -4048,6 +4073,8 @@ av_cold void ff_h264_free_context(H264Context *h)
     int i;
 
     free_tables(h, 1); // FIXME cleanup init stuff perhaps
+    av_freep(&h->thread_context);
+    h->nb_thread_contexts = 0;
 
     for (i = 0; i < MAX_SPS_COUNT; i++)
         av_freep(h->sps_buffers + i);
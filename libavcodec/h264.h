@@ -507,7 +507,8 @@ typedef struct H264Context {
      * @name Members for slice based multithreading
      * @{
      */
-    struct H264Context *thread_context[MAX_THREADS];
+    struct H264Context **thread_context;
+    int nb_thread_contexts;   ///< allocated entries of thread_context
 
     /**
      * current slice number, used to initalize slice_num of each thread/context
@@ -336,7 +336,11 @@ static void close(AVCodecParserContext *s)
 static int init(AVCodecParserContext *s)
 {
     H264Context *h = s->priv_data;
-    h->thread_context[0] = h;
+    h->thread_context = av_mallocz(sizeof(*h->thread_context));
+    if (!h->thread_context)
+        return AVERROR(ENOMEM);
+    h->nb_thread_contexts = 1;
+    h->thread_context[0]  = h;
     h->s.slice_context_count = 1;
     return 0;
 }
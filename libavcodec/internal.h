@@ -26,6 +26,7 @@
 
 #include <stdint.h>
 
+#include "libavutil/buffer.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/pixfmt.h"
 #include "avcodec.h"
@@ -34,14 +35,29 @@ typedef struct InternalBuffer {
     uint8_t *base[AV_NUM_DATA_POINTERS];
     uint8_t *data[AV_NUM_DATA_POINTERS];
     int linesize[AV_NUM_DATA_POINTERS];
-    int width;
-    int height;
-    enum PixelFormat pix_fmt;
+    /**
+     * pool references backing the video planes in base[]
+     */
+    AVBufferRef *buf[AV_NUM_DATA_POINTERS];
     uint8_t **extended_data;
     int audio_data_size;
     int nb_channels;
 } InternalBuffer;
 
+/**
+ * Per-plane buffer pools used by the default video get_buffer().
+ * The pools are recreated whenever the frame geometry changes, so each pool
+ * only ever hands out buffers of a single size.
+ */
+typedef struct FramePool {
+    AVBufferPool *pools[4];
+    int pool_size[4];
+    int linesize[4];
+    int stride_align[AV_NUM_DATA_POINTERS];
+    int format;
+    int width, height;
+} FramePool;
+
 typedef struct AVCodecInternal {
     /**
      * internal buffer count
@@ -49,12 +65,23 @@ typedef struct AVCodecInternal {
      */
     int buffer_count;
 
+    /**
+     * number of entries allocated in buffer
+     * used by default get/release/reget_buffer().
+     */
+    int buffer_size;
+
     /**
      * internal buffers
      * used by default get/release/reget_buffer().
      */
     InternalBuffer *buffer;
 
+    /**
+     * buffer pools backing the internal video buffers
+     */
+    FramePool pool;
+
     /**
      * Whether the parent AVCodecContext is a copy of the context which had
      * init() called on it.
@@ -40,6 +40,7 @@
 #include "mjpeg.h"
 #include "mjpegdec.h"
 #include "jpeglsdec.h"
+#include "thread.h"
 
 
 static int build_vlc(VLC *vlc, const uint8_t *bits_table,
@@ -65,20 +66,53 @@ static int build_vlc(VLC *vlc, const uint8_t *bits_table,
                               huff_code, 2, 2, huff_sym, 2, 2, use_static);
 }
 
+/* (re)build the VLCs of one huffman table from huff_bits/huff_vals */
+static int init_huffman_table(MJpegDecodeContext *s, int class, int index)
+{
+    const uint8_t *bits_table = s->huff_bits[class][index];
+    const uint8_t *val_table  = s->huff_vals[class][index];
+    int i, n = 0, code_max = 0;
+
+    for (i = 1; i <= 16; i++)
+        n += bits_table[i];
+    for (i = 0; i < n; i++)
+        code_max = FFMAX(code_max, val_table[i]);
+
+    ff_free_vlc(&s->vlcs[class][index]);
+    av_log(s->avctx, AV_LOG_DEBUG, "class=%d index=%d nb_codes=%d\n",
+           class, index, code_max + 1);
+    if (build_vlc(&s->vlcs[class][index], bits_table, val_table,
+                  code_max + 1, 0, class > 0) < 0)
+        return -1;
+
+    if (class > 0) {
+        ff_free_vlc(&s->vlcs[2][index]);
+        if (build_vlc(&s->vlcs[2][index], bits_table, val_table,
+                      code_max + 1, 0, 0) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static void set_basic_huffman_table(MJpegDecodeContext *s, int class,
+                                    int index, const uint8_t *bits_table,
+                                    const uint8_t *val_table, int nb_vals)
+{
+    memcpy(s->huff_bits[class][index], bits_table, 17);
+    memcpy(s->huff_vals[class][index], val_table, nb_vals);
+    init_huffman_table(s, class, index);
+}
+
 static void build_basic_mjpeg_vlc(MJpegDecodeContext *s)
 {
-    build_vlc(&s->vlcs[0][0], ff_mjpeg_bits_dc_luminance,
-              ff_mjpeg_val_dc, 12, 0, 0);
-    build_vlc(&s->vlcs[0][1], ff_mjpeg_bits_dc_chrominance,
-              ff_mjpeg_val_dc, 12, 0, 0);
-    build_vlc(&s->vlcs[1][0], ff_mjpeg_bits_ac_luminance,
-              ff_mjpeg_val_ac_luminance, 251, 0, 1);
-    build_vlc(&s->vlcs[1][1], ff_mjpeg_bits_ac_chrominance,
-              ff_mjpeg_val_ac_chrominance, 251, 0, 1);
-    build_vlc(&s->vlcs[2][0], ff_mjpeg_bits_ac_luminance,
-              ff_mjpeg_val_ac_luminance, 251, 0, 0);
-    build_vlc(&s->vlcs[2][1], ff_mjpeg_bits_ac_chrominance,
-              ff_mjpeg_val_ac_chrominance, 251, 0, 0);
+    set_basic_huffman_table(s, 0, 0, ff_mjpeg_bits_dc_luminance,
+                            ff_mjpeg_val_dc, 12);
+    set_basic_huffman_table(s, 0, 1, ff_mjpeg_bits_dc_chrominance,
+                            ff_mjpeg_val_dc, 12);
+    set_basic_huffman_table(s, 1, 0, ff_mjpeg_bits_ac_luminance,
+                            ff_mjpeg_val_ac_luminance, 162);
+    set_basic_huffman_table(s, 1, 1, ff_mjpeg_bits_ac_chrominance,
+                            ff_mjpeg_val_ac_chrominance, 162);
 }
 
 av_cold int ff_mjpeg_decode_init(AVCodecContext *avctx)
@@ -156,8 +190,8 @@ int ff_mjpeg_decode_dqt(MJpegDecodeContext *s)
 /* decode huffman tables and build VLC decoders */
 int ff_mjpeg_decode_dht(MJpegDecodeContext *s)
 {
-    int len, index, i, class, n, v, code_max;
-    uint8_t bits_table[17];
+    int len, index, i, class, n;
+    uint8_t bits_table[17] = { 0 };
     uint8_t val_table[256];
 
     len = get_bits(&s->gb, 16) - 2;
@@ -180,29 +214,15 @@ int ff_mjpeg_decode_dht(MJpegDecodeContext *s)
         if (len < n || n > 256)
             return -1;
 
-        code_max = 0;
-        for (i = 0; i < n; i++) {
-            v = get_bits(&s->gb, 8);
-            if (v > code_max)
-                code_max = v;
-            val_table[i] = v;
-        }
+        for (i = 0; i < n; i++)
+            val_table[i] = get_bits(&s->gb, 8);
         len -= n;
 
         /* build VLC and flush previous vlc if present */
-        ff_free_vlc(&s->vlcs[class][index]);
-        av_log(s->avctx, AV_LOG_DEBUG, "class=%d index=%d nb_codes=%d\n",
-               class, index, code_max + 1);
-        if (build_vlc(&s->vlcs[class][index], bits_table, val_table,
-                      code_max + 1, 0, class > 0) < 0)
+        memcpy(s->huff_bits[class][index], bits_table, 17);
+        memcpy(s->huff_vals[class][index], val_table, n);
+        if (init_huffman_table(s, class, index) < 0)
             return -1;
-
-        if (class > 0) {
-            ff_free_vlc(&s->vlcs[2][index]);
-            if (build_vlc(&s->vlcs[2][index], bits_table, val_table,
-                          code_max + 1, 0, 0) < 0)
-                return -1;
-        }
     }
     return 0;
 }
@@ -349,9 +369,9 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     }
 
     if (s->picture_ptr->data[0])
-        s->avctx->release_buffer(s->avctx, s->picture_ptr);
+        ff_thread_release_buffer(s->avctx, s->picture_ptr);
 
-    if (s->avctx->get_buffer(s->avctx, s->picture_ptr) < 0) {
+    if (ff_thread_get_buffer(s->avctx, s->picture_ptr) < 0) {
         av_log(s->avctx, AV_LOG_ERROR, "get_buffer() failed\n");
         return -1;
     }
@@ -387,10 +407,11 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     return 0;
 }
 
-static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
+static inline int mjpeg_decode_dc(MJpegDecodeContext *s, GetBitContext *gb,
+                                  int dc_index)
 {
     int code;
-    code = get_vlc2(&s->gb, s->vlcs[0][dc_index].table, 9, 2);
+    code = get_vlc2(gb, s->vlcs[0][dc_index].table, 9, 2);
     if (code < 0) {
         av_log(s->avctx, AV_LOG_WARNING,
                "mjpeg_decode_dc: bad vlc: %d:%d (%p)\n",
@@ -399,46 +420,47 @@ static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
     }
 
     if (code)
-        return get_xbits(&s->gb, code);
+        return get_xbits(gb, code);
     else
         return 0;
 }
 
 /* decode block and dequantize */
-static int decode_block(MJpegDecodeContext *s, DCTELEM *block, int component,
+static int decode_block(MJpegDecodeContext *s, GetBitContext *gb,
+                        DCTELEM *block, int *last_dc,
                         int dc_index, int ac_index, int16_t *quant_matrix)
 {
     int code, i, j, level, val;
 
     /* DC coef */
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, gb, dc_index);
     if (val == 0xffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return -1;
     }
-    val = val * quant_matrix[0] + s->last_dc[component];
-    s->last_dc[component] = val;
+    val = val * quant_matrix[0] + *last_dc;
+    *last_dc = val;
     block[0] = val;
     /* AC coefs */
     i = 0;
-    {OPEN_READER(re, &s->gb);
+    {OPEN_READER(re, gb);
     do {
-        UPDATE_CACHE(re, &s->gb);
-        GET_VLC(code, re, &s->gb, s->vlcs[1][ac_index].table, 9, 2);
+        UPDATE_CACHE(re, gb);
+        GET_VLC(code, re, gb, s->vlcs[1][ac_index].table, 9, 2);
 
         i += ((unsigned)code) >> 4;
             code &= 0xf;
         if (code) {
             if (code > MIN_CACHE_BITS - 16)
-                UPDATE_CACHE(re, &s->gb);
+                UPDATE_CACHE(re, gb);
 
             {
-                int cache = GET_CACHE(re, &s->gb);
+                int cache = GET_CACHE(re, gb);
                 int sign  = (~cache) >> 31;
                 level     = (NEG_USR32(sign ^ cache,code) ^ sign) - sign;
             }
 
-            LAST_SKIP_BITS(re, &s->gb, code);
+            LAST_SKIP_BITS(re, gb, code);
 
             if (i > 63) {
                 av_log(s->avctx, AV_LOG_ERROR, "error count: %d\n", i);
@@ -448,7 +470,7 @@ static int decode_block(MJpegDecodeContext *s, DCTELEM *block, int component,
             block[j] = level * quant_matrix[j];
         }
     } while (i < 63);
-    CLOSE_READER(re, &s->gb);}
+    CLOSE_READER(re, gb);}
 
     return 0;
 }
@@ -459,7 +481,7 @@ static int decode_dc_progressive(MJpegDecodeContext *s, DCTELEM *block,
 {
     int val;
     s->dsp.clear_block(block);
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, &s->gb, dc_index);
     if (val == 0xffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return -1;
@@ -673,7 +695,7 @@ static int ljpeg_decode_rgb_scan(MJpegDecodeContext *s, int predictor,
                 PREDICT(pred, topleft[i], top[i], left[i], modified_predictor);
 
                 left[i] = buffer[mb_x][i] =
-                    mask & (pred + (mjpeg_decode_dc(s, s->dc_index[i]) << point_transform));
+                    mask & (pred + (mjpeg_decode_dc(s, &s->gb, s->dc_index[i]) << point_transform));
             }
 
             if (s->restart_interval && !--s->restart_count) {
@@ -749,7 +771,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
 
                         if (s->interlaced && s->bottom_field)
                             ptr += linesize >> 1;
-                        *ptr = pred + (mjpeg_decode_dc(s, s->dc_index[i]) << point_transform);
+                        *ptr = pred + (mjpeg_decode_dc(s, &s->gb, s->dc_index[i]) << point_transform);
 
                         if (++x == h) {
                             x = 0;
@@ -778,7 +800,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                               (h * mb_x + x);
                         PREDICT(pred, ptr[-linesize - 1],
                                 ptr[-linesize], ptr[-1], predictor);
-                        *ptr = pred + (mjpeg_decode_dc(s, s->dc_index[i]) << point_transform);
+                        *ptr = pred + (mjpeg_decode_dc(s, &s->gb, s->dc_index[i]) << point_transform);
                         if (++x == h) {
                             x = 0;
                             y++;
@@ -795,6 +817,116 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
     return 0;
 }
 
+typedef struct MJpegScanSlices {
+    int nb_components;
+    uint8_t **data;
+    const int *linesize;
+    int nb_intervals;
+    int nb_jobs;
+} MJpegScanSlices;
+
+/**
+ * Decode a run of restart intervals of a sequential scan.
+ * Every interval starts byte aligned after its RSTn marker with reset DC
+ * predictors, so the runs of different jobs are independent.
+ */
+static int decode_restart_intervals(AVCodecContext *avctx, void *arg,
+                                    int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    MJpegScanSlices *sl   = arg;
+    const int nb_mbs      = s->mb_width * s->mb_height;
+    int interval          = sl->nb_intervals *  jobnr      / sl->nb_jobs;
+    int end_interval      = sl->nb_intervals * (jobnr + 1) / sl->nb_jobs;
+    LOCAL_ALIGNED_16(DCTELEM, block, [64]);
+    GetBitContext gb;
+
+    for (; interval < end_interval; interval++) {
+        int last_dc[MAX_COMPONENTS];
+        int mb     = interval * s->restart_interval;
+        int end_mb = FFMIN(mb + s->restart_interval, nb_mbs);
+        int i;
+
+        gb = s->gb;
+        if (interval)
+            skip_bits_long(&gb, s->restart_offsets[interval - 1] * 8 -
+                                get_bits_count(&gb));
+        for (i = 0; i < sl->nb_components; i++)
+            last_dc[i] = 1024;
+
+        for (; mb < end_mb; mb++) {
+            int mb_x = mb % s->mb_width;
+            int mb_y = mb / s->mb_width;
+
+            if (get_bits_left(&gb) < 0) {
+                av_log(avctx, AV_LOG_ERROR, "overread %d\n",
+                       -get_bits_left(&gb));
+                return -1;
+            }
+            for (i = 0; i < sl->nb_components; i++) {
+                int c = s->comp_index[i];
+                int h = s->h_scount[i];
+                int v = s->v_scount[i];
+                int x = 0, y = 0, j;
+
+                for (j = 0; j < s->nb_blocks[i]; j++) {
+                    int block_offset = sl->linesize[c] * (v * mb_y + y) * 8 +
+                                       (h * mb_x + x) * 8;
+
+                    if (s->interlaced && s->bottom_field)
+                        block_offset += sl->linesize[c] >> 1;
+                    s->dsp.clear_block(block);
+                    if (decode_block(s, &gb, block, &last_dc[i],
+                                     s->dc_index[i], s->ac_index[i],
+                                     s->quant_matrixes[s->quant_index[c]]) < 0) {
+                        av_log(avctx, AV_LOG_ERROR,
+                               "error y=%d x=%d\n", mb_y, mb_x);
+                        return -1;
+                    }
+                    s->dsp.idct_put(sl->data[c] + block_offset,
+                                    sl->linesize[c], block);
+                    if (++x == h) {
+                        x = 0;
+                        y++;
+                    }
+                }
+            }
+        }
+    }
+    emms_c();
+    return 0;
+}
+
+static int mjpeg_decode_scan_slices(MJpegDecodeContext *s, int nb_components,
+                                    uint8_t **data, const int *linesize,
+                                    int nb_intervals)
+{
+    MJpegScanSlices sl;
+    int i, ret = 0;
+
+    sl.nb_components = nb_components;
+    sl.data          = data;
+    sl.linesize      = linesize;
+    sl.nb_intervals  = nb_intervals;
+    sl.nb_jobs       = FFMIN(nb_intervals, s->avctx->thread_count);
+
+    av_fast_malloc(&s->slice_ret, &s->slice_ret_size,
+                   sl.nb_jobs * sizeof(*s->slice_ret));
+    if (!s->slice_ret)
+        return AVERROR(ENOMEM);
+
+    s->avctx->execute2(s->avctx, decode_restart_intervals, &sl,
+                       s->slice_ret, sl.nb_jobs);
+    for (i = 0; i < sl.nb_jobs; i++)
+        if (s->slice_ret[i] < 0)
+            ret = -1;
+
+    /* the marker parser resumes from the start of the last interval */
+    skip_bits_long(&s->gb, s->restart_offsets[nb_intervals - 2] * 8 -
+                           get_bits_count(&s->gb));
+    return ret;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
                              const AVFrame *reference)
@@ -830,6 +962,18 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
         }
     }
 
+    if (s->restart_interval && !s->progressive && !mb_bitmask &&
+        s->avctx->active_thread_type & FF_THREAD_SLICE) {
+        int nb_intervals = (s->mb_width * s->mb_height +
+                            s->restart_interval - 1) / s->restart_interval;
+
+        /* only split scans whose RSTn markers were all found */
+        if (nb_intervals > 1 && s->nb_restarts >= nb_intervals - 1 &&
+            s->restart_offsets[0] * 8 >= get_bits_count(&s->gb))
+            return mjpeg_decode_scan_slices(s, nb_components, data, linesize,
+                                            nb_intervals);
+    }
+
     for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
         for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
             const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
@@ -865,7 +1009,7 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                                         linesize[c], linesize[c], 8);
                         else {
                             s->dsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
+                            if (decode_block(s, &s->gb, s->block, &s->last_dc[i],
                                              s->dc_index[i], s->ac_index[i],
                                              s->quant_matrixes[s->quant_index[c]]) < 0) {
                                 av_log(s->avctx, AV_LOG_ERROR,
@@ -1349,21 +1493,42 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
     if (start_code == SOS && !s->ls) {
         const uint8_t *src = *buf_ptr;
         uint8_t *dst = s->buffer;
+        int record_restarts = s->avctx->active_thread_type & FF_THREAD_SLICE;
 
-        while (src < buf_end) {
-            uint8_t x = *(src++);
-
-            *(dst++) = x;
-            if (s->avctx->codec_id != AV_CODEC_ID_THP) {
-                if (x == 0xff) {
-                    while (src < buf_end && x == 0xff)
-                        x = *(src++);
+        s->nb_restarts = 0;
+        if (s->avctx->codec_id == AV_CODEC_ID_THP) {
+            memcpy(dst, src, buf_end - src);
+            dst += buf_end - src;
+        } else {
+            /* copy the runs between 0xff bytes in bulk */
+            while (src < buf_end) {
+                const uint8_t *ff = memchr(src, 0xff, buf_end - src);
+                int run = ff ? ff + 1 - src : buf_end - src;
+                uint8_t x = 0xff;
+
+                memcpy(dst, src, run);
+                dst += run;
+                src += run;
+                if (!ff)
+                    break;
 
-                    if (x >= 0xd0 && x <= 0xd7)
-                        *(dst++) = x;
-                    else if (x)
-                        break;
-                }
+                while (src < buf_end && x == 0xff)
+                    x = *(src++);
+
+                if (x >= 0xd0 && x <= 0xd7) {
+                    *(dst++) = x;
+                    if (record_restarts) {
+                        int *offsets = av_fast_realloc(s->restart_offsets,
+                                                       &s->restart_offsets_size,
+                                                       (s->nb_restarts + 1) *
+                                                       sizeof(*offsets));
+                        if (!offsets)
+                            return AVERROR(ENOMEM);
+                        s->restart_offsets = offsets;
+                        s->restart_offsets[s->nb_restarts++] = dst - s->buffer;
+                    }
+                } else if (x)
+                    break;
             }
         }
         *unescaped_buf_ptr  = s->buffer;
@@ -1417,6 +1582,20 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
     return start_code;
 }
 
+/* return 1 if the only markers in the buffer are SOS, RSTn and EOI */
+static int only_scans_follow(const uint8_t *buf_ptr, const uint8_t *buf_end)
+{
+    while ((buf_ptr = memchr(buf_ptr, 0xff, buf_end - buf_ptr)) &&
+           ++buf_ptr < buf_end) {
+        int code = *buf_ptr;
+
+        if (code >= 0xc0 && code <= 0xfe && code != SOS && code != EOI &&
+            (code < RST0 || code > RST7))
+            return 0;
+    }
+    return 1;
+}
+
 int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *data_size,
                           AVPacket *avpkt)
 {
@@ -1427,6 +1606,7 @@ int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *data_size,
     const uint8_t *unescaped_buf_ptr;
     int unescaped_buf_size;
     int start_code;
+    int setup_finished = 0;
     AVFrame *picture = data;
 
     s->got_picture = 0; // picture from previous image can not be reused
@@ -1553,6 +1733,14 @@ eoi_parser:
                            "Can not process SOS before SOF, skipping\n");
                     break;
                     }
+                /* the state inherited by the next frame thread is final
+                 * once only scan data follows */
+                if (!setup_finished &&
+                    avctx->active_thread_type & FF_THREAD_FRAME &&
+                    only_scans_follow(buf_ptr, buf_end)) {
+                    ff_thread_finish_setup(avctx);
+                    setup_finished = 1;
+                }
                 if (ff_mjpeg_decode_sos(s, NULL, NULL) < 0 &&
                     (avctx->err_recognition & AV_EF_EXPLODE))
                     return AVERROR_INVALIDDATA;
@@ -1603,18 +1791,114 @@ the_end:
     return buf_ptr - buf;
 }
 
+static int mjpeg_decode_init_thread_copy(AVCodecContext *avctx)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    int class, index;
+
+    s->avctx       = avctx;
+    s->picture_ptr = &s->picture;
+    memset(&s->picture, 0, sizeof(s->picture));
+    s->buffer               = NULL;
+    s->buffer_size          = 0;
+    s->qscale_table         = NULL;
+    s->ljpeg_buffer         = NULL;
+    s->ljpeg_buffer_size    = 0;
+    s->restart_offsets      = NULL;
+    s->restart_offsets_size = 0;
+    s->slice_ret            = NULL;
+    s->slice_ret_size       = 0;
+    memset(s->blocks,   0, sizeof(s->blocks));
+    memset(s->last_nnz, 0, sizeof(s->last_nnz));
+
+    /* the VLC tables still belong to the first thread */
+    for (class = 0; class < 2; class++) {
+        for (index = 0; index < 4; index++) {
+            int built = !!s->vlcs[class][index].table;
+
+            memset(&s->vlcs[class][index], 0, sizeof(VLC));
+            if (class)
+                memset(&s->vlcs[2][index], 0, sizeof(VLC));
+            if (built && init_huffman_table(s, class, index) < 0)
+                return AVERROR(ENOMEM);
+        }
+    }
+    return 0;
+}
+
+#define copy_fields(to, from, start_field, end_field)                   \
+    memcpy(&to->start_field, &from->start_field,                        \
+           (char *)&to->end_field - (char *)&to->start_field)
+
+static int mjpeg_decode_update_thread_context(AVCodecContext *dst,
+                                              const AVCodecContext *src)
+{
+    MJpegDecodeContext *s  = dst->priv_data;
+    MJpegDecodeContext *s1 = src->priv_data;
+    int class, index;
+
+    if (dst == src)
+        return 0;
+
+    /* tables may be inherited from previous pictures */
+    for (class = 0; class < 2; class++) {
+        for (index = 0; index < 4; index++) {
+            if (!memcmp(s->huff_bits[class][index], s1->huff_bits[class][index],
+                        sizeof(s->huff_bits[class][index])) &&
+                !memcmp(s->huff_vals[class][index], s1->huff_vals[class][index],
+                        sizeof(s->huff_vals[class][index])))
+                continue;
+            memcpy(s->huff_bits[class][index], s1->huff_bits[class][index],
+                   sizeof(s->huff_bits[class][index]));
+            memcpy(s->huff_vals[class][index], s1->huff_vals[class][index],
+                   sizeof(s->huff_vals[class][index]));
+            if (!s1->vlcs[class][index].table) {
+                ff_free_vlc(&s->vlcs[class][index]);
+                if (class)
+                    ff_free_vlc(&s->vlcs[2][index]);
+            } else if (init_huffman_table(s, class, index) < 0)
+                return AVERROR(ENOMEM);
+        }
+    }
+    memcpy(s->quant_matrixes, s1->quant_matrixes, sizeof(s->quant_matrixes));
+    memcpy(s->qscale,         s1->qscale,         sizeof(s->qscale));
+
+    if (s->width != s1->width || s->height != s1->height) {
+        av_freep(&s->qscale_table);
+        if (s1->qscale_table) {
+            s->qscale_table = av_mallocz((s1->width + 15) / 16);
+            if (!s->qscale_table)
+                return AVERROR(ENOMEM);
+        }
+    }
+    copy_fields(s, s1, org_height, mb_width);
+
+    s->restart_interval   = s1->restart_interval;
+    s->restart_count      = s1->restart_count;
+    s->buggy_avid         = s1->buggy_avid;
+    s->cs_itu601          = s1->cs_itu601;
+    s->interlace_polarity = s1->interlace_polarity;
+
+    s->picture_ptr->interlaced_frame = s1->picture_ptr->interlaced_frame;
+    s->picture_ptr->top_field_first  = s1->picture_ptr->top_field_first;
+
+    return 0;
+}
+
 av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
 {
     MJpegDecodeContext *s = avctx->priv_data;
     int i, j;
 
     if (s->picture_ptr && s->picture_ptr->data[0])
-        avctx->release_buffer(avctx, s->picture_ptr);
+        ff_thread_release_buffer(avctx, s->picture_ptr);
 
     av_free(s->buffer);
     av_free(s->qscale_table);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
+    av_freep(&s->restart_offsets);
+    av_freep(&s->slice_ret);
 
     for (i = 0; i < 3; i++) {
         for (j = 0; j < 4; j++)
@@ -1650,7 +1934,10 @@ AVCodec ff_mjpeg_decoder = {
     .init           = ff_mjpeg_decode_init,
     .close          = ff_mjpeg_decode_end,
     .decode         = ff_mjpeg_decode_frame,
-    .capabilities   = CODEC_CAP_DR1,
+    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_FRAME_THREADS |
+                      CODEC_CAP_SLICE_THREADS,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(mjpeg_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(mjpeg_decode_update_thread_context),
     .long_name      = NULL_IF_CONFIG_SMALL("MJPEG (Motion JPEG)"),
     .priv_class     = &mjpegdec_class,
 };
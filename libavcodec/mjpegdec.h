@@ -48,6 +48,8 @@ typedef struct MJpegDecodeContext {
 
     int16_t quant_matrixes[4][64];
     VLC vlcs[3][4];
+    uint8_t huff_bits[2][4][17]; ///< DHT code length counts, kept to rebuild vlcs in frame threads
+    uint8_t huff_vals[2][4][256];
     int qscale[4];      ///< quantizer scale calculated from quant_matrixes
 
     int org_height;  /* size given at codec init */
@@ -97,6 +99,11 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *restart_offsets;           ///< byte offsets of the data following each RSTn of the current scan
+    unsigned int restart_offsets_size;
+    int nb_restarts;
+    int *slice_ret;
+    unsigned int slice_ret_size;
 
     int buggy_avid;
     int cs_itu601;
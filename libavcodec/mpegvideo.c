@@ -672,21 +672,21 @@ av_cold int ff_MPV_common_init(MpegEncContext *s)
         return -1;
     }
 
-    if (nb_slices > MAX_THREADS || (nb_slices > s->mb_height && s->mb_height)) {
-        int max_slices;
-        if (s->mb_height)
-            max_slices = FFMIN(MAX_THREADS, s->mb_height);
-        else
-            max_slices = MAX_THREADS;
+    if (nb_slices > s->mb_height && s->mb_height) {
         av_log(s->avctx, AV_LOG_WARNING, "too many threads/slices (%d),"
-               " reducing to %d\n", nb_slices, max_slices);
-        nb_slices = max_slices;
+               " reducing to %d\n", nb_slices, s->mb_height);
+        nb_slices = s->mb_height;
     }
 
     if ((s->width || s->height) &&
         av_image_check_size(s->width, s->height, 0, s->avctx))
         return -1;
 
+    /* allocated first, a context copied for frame threading still points
+     * to the array of its source before this */
+    FF_ALLOCZ_OR_GOTO(s->avctx, s->thread_context,
+                      nb_slices * sizeof(*s->thread_context), fail);
+
     ff_dct_common_init(s);
 
     s->flags  = s->avctx->flags;
@@ -896,6 +896,8 @@ av_cold int ff_MPV_common_init(MpegEncContext *s)
         if (nb_slices > 1) {
             for (i = 1; i < nb_slices; i++) {
                 s->thread_context[i] = av_malloc(sizeof(MpegEncContext));
+                if (!s->thread_context[i])
+                    goto fail;
                 memcpy(s->thread_context[i], s, sizeof(MpegEncContext));
             }
 
@@ -936,6 +938,7 @@ void ff_MPV_common_end(MpegEncContext *s)
         }
         s->slice_context_count = 1;
     } else free_duplicate_context(s);
+    av_freep(&s->thread_context);
 
     av_freep(&s->parse_context.buffer);
     s->parse_context.buffer_size = 0;
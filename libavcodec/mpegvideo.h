@@ -57,8 +57,6 @@ enum OutputFormat {
 #define MAX_FCODE 7
 #define MAX_MV 2048
 
-#define MAX_THREADS 16
-
 #define MAX_PICTURE_COUNT 32
 
 #define ME_MAP_SIZE 64
@@ -277,7 +275,7 @@ typedef struct MpegEncContext {
 
     int start_mb_y;            ///< start mb_y of this thread (so current thread should process start_mb_y <= row < end_mb_y)
     int end_mb_y;              ///< end   mb_y of this thread (so current thread should process start_mb_y <= row < end_mb_y)
-    struct MpegEncContext *thread_context[MAX_THREADS];
+    struct MpegEncContext **thread_context; ///< slice contexts, slice_context_count entries
     int slice_context_count;   ///< number of used thread_contexts
 
     /**
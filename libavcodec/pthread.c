@@ -31,28 +31,13 @@
 
 #include "config.h"
 
-#if HAVE_SCHED_GETAFFINITY
-#define _GNU_SOURCE
-#include <sched.h>
-#endif
-#if HAVE_GETPROCESSAFFINITYMASK
-#include <windows.h>
-#endif
-#if HAVE_SYSCTL
-#if HAVE_SYS_PARAM_H
-#include <sys/param.h>
-#endif
-#include <sys/types.h>
-#include <sys/sysctl.h>
-#endif
-#if HAVE_SYSCONF
-#include <unistd.h>
-#endif
-
 #include "avcodec.h"
 #include "internal.h"
 #include "thread.h"
+#include "libavutil/atomic.h"
 #include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/internal.h"
 
 #if HAVE_PTHREADS
 #include <pthread.h>
@@ -63,21 +48,81 @@
 typedef int (action_func)(AVCodecContext *c, void *arg);
 typedef int (action_func2)(AVCodecContext *c, void *arg, int jobnr, int threadnr);
 
+/**
+ * A job queued on a shared thread pool.
+ */
+typedef struct PoolTask {
+    void (*run)(void *opaque);
+    void *opaque;
+    struct PoolTask *next;
+} PoolTask;
+
+/**
+ * Task queue of one codec context using a shared thread pool.
+ * Clients with queued tasks are served in turn, one task at a time, so that
+ * a context submitting many jobs cannot starve the others.
+ */
+typedef struct PoolClient {
+    PoolTask *first_task, *last_task;
+    struct PoolClient *next;        ///< next client in the pool's ready list
+    int ready;                      ///< set while the client is in the ready list
+} PoolClient;
+
+struct AVCodecThreadPool {
+    pthread_t *threads;
+    int nb_threads;
+
+    pthread_mutex_t lock;           ///< protects all the queues and die
+    pthread_cond_t  cond;           ///< signalled when a task is queued
+    PoolClient *first_ready;        ///< clients with queued tasks, in serving order
+    PoolClient *last_ready;
+    int die;
+};
+
+/**
+ * A slice threading worker. Each worker owns a contiguous range of the jobs
+ * of the current execute() call, which it consumes from the front. Workers
+ * that run out of jobs steal from the back of the other workers' ranges.
+ */
+typedef struct SliceWorker {
+    struct ThreadContext *c;
+    pthread_t thread;
+    int       id;                   ///< threadnr passed to execute2() callbacks
+    PoolTask  task;                 ///< used to run this worker on a shared pool
+
+    /**
+     * Jobs still queued on this worker, packed as (first << 16) | end, so
+     * that both ends can be claimed with a single compare-and-swap.
+     */
+    volatile int range;
+} SliceWorker;
+
+/* largest job count that fits in SliceWorker.range */
+#define MAX_JOBS_PER_BATCH 0x7FFF
+
 typedef struct ThreadContext {
-    pthread_t *workers;
+    AVCodecContext *avctx;
+    SliceWorker *workers;           ///< worker 0 is the thread calling execute()
+    int nb_workers;
     action_func *func;
     action_func2 *func2;
     void *args;
     int *rets;
     int rets_count;
-    int job_count;
     int job_size;
+    int job_offset;                 ///< jobnr of the first job of the current batch
 
-    pthread_cond_t last_job_cond;
-    pthread_cond_t current_job_cond;
-    pthread_mutex_t current_job_lock;
-    int current_job;
+    volatile int jobs_left;         ///< jobs of the current batch not finished yet
+
+    pthread_mutex_t lock;           ///< protects generation, done and the conditions
+    pthread_cond_t  work_cond;      ///< signalled when a new batch is queued
+    pthread_cond_t  done_cond;      ///< signalled when the last job of a batch finishes
+    int generation;                 ///< incremented for each queued batch
     int done;
+
+    AVCodecThreadPool *pool;        ///< shared pool running the workers, if any
+    PoolClient client;
+    int helpers_left;               ///< workers queued on the pool and not finished yet
 } ThreadContext;
 
 /// Max number of frame buffers that can be allocated when using frame threads.
@@ -131,6 +176,8 @@ typedef struct PerThreadContext {
     uint8_t progress_used[MAX_BUFFERS];
 
     AVFrame *requested_frame;       ///< AVFrame the codec passed to get_buffer()
+
+    PoolTask task;                  ///< decodes avpkt on a shared pool
 } PerThreadContext;
 
 /**
@@ -151,84 +198,297 @@ typedef struct FrameThreadContext {
                                     */
 
     int die;                       ///< Set when threads should exit.
-} FrameThreadContext;
 
+    AVCodecThreadPool *pool;       ///< Shared pool decoding the packets, if any.
+    PoolClient client;
+} FrameThreadContext;
 
-/* H264 slice threading seems to be buggy with more than 16 threads,
- * limit the number of threads to 16 for automatic detection */
-#define MAX_AUTO_THREADS 16
 
 static int get_logical_cpus(AVCodecContext *avctx)
 {
-    int ret, nb_cpus = 1;
-#if HAVE_SCHED_GETAFFINITY && defined(CPU_COUNT)
-    cpu_set_t cpuset;
+    int nb_cpus = av_cpu_count();
+    av_log(avctx, AV_LOG_DEBUG, "detected %d logical cores\n", nb_cpus);
+    return nb_cpus;
+}
+
+static int get_auto_thread_count(AVCodecContext *avctx)
+{
+    int nb_cpus;
+
+    // use as many jobs as pool threads plus the calling thread
+    if (avctx->thread_pool)
+        return FFMIN(avctx->thread_pool->nb_threads + 1, FF_MAX_AUTO_THREADS);
+
+    nb_cpus = get_logical_cpus(avctx);
+    // use number of cores + 1 as thread count if there is more than one
+    if (nb_cpus > 1)
+        return FFMIN(nb_cpus + 1, FF_MAX_AUTO_THREADS);
+    return 1;
+}
+
+static void* attribute_align_arg pool_worker(void *arg)
+{
+    AVCodecThreadPool *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        PoolClient *client;
+        PoolTask *task;
+
+        while (!pool->first_ready && !pool->die)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        if (pool->die)
+            break;
+
+        client = pool->first_ready;
+        pool->first_ready = client->next;
+        if (!pool->first_ready)
+            pool->last_ready = NULL;
+
+        task = client->first_task;
+        client->first_task = task->next;
+        if (client->first_task) {
+            // requeue the client behind the others
+            client->next = NULL;
+            if (pool->last_ready)
+                pool->last_ready->next = client;
+            else
+                pool->first_ready = client;
+            pool->last_ready = client;
+        } else {
+            client->last_task = NULL;
+            client->ready     = 0;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        /* The task may be reused as soon as it has run,
+         * it must not be accessed afterwards. */
+        task->run(task->opaque);
+
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
 
-    CPU_ZERO(&cpuset);
+static void pool_submit(AVCodecThreadPool *pool, PoolClient *client, PoolTask *task)
+{
+    pthread_mutex_lock(&pool->lock);
+    task->next = NULL;
+    if (client->last_task)
+        client->last_task->next = task;
+    else
+        client->first_task = task;
+    client->last_task = task;
+
+    if (!client->ready) {
+        client->ready = 1;
+        client->next  = NULL;
+        if (pool->last_ready)
+            pool->last_ready->next = client;
+        else
+            pool->first_ready = client;
+        pool->last_ready = client;
+    }
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+}
 
-    ret = sched_getaffinity(0, sizeof(cpuset), &cpuset);
-    if (!ret) {
-        nb_cpus = CPU_COUNT(&cpuset);
+/**
+ * Remove all the tasks of a client which have not been started yet.
+ * @return number of removed tasks
+ */
+static int pool_cancel(AVCodecThreadPool *pool, PoolClient *client)
+{
+    PoolClient **c;
+    PoolTask *task;
+    int nb_tasks = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    if (client->ready) {
+        for (task = client->first_task; task; task = task->next)
+            nb_tasks++;
+        client->first_task = client->last_task = NULL;
+        client->ready = 0;
+
+        pool->last_ready = NULL;
+        for (c = &pool->first_ready; *c; c = &(*c)->next) {
+            if (*c == client)
+                *c = client->next;
+            if (!*c)
+                break;
+            pool->last_ready = *c;
+        }
     }
-#elif HAVE_GETPROCESSAFFINITYMASK
-    DWORD_PTR proc_aff, sys_aff;
-    ret = GetProcessAffinityMask(GetCurrentProcess(), &proc_aff, &sys_aff);
-    if (ret)
-        nb_cpus = av_popcount64(proc_aff);
-#elif HAVE_SYSCTL && defined(HW_NCPU)
-    int mib[2] = { CTL_HW, HW_NCPU };
-    size_t len = sizeof(nb_cpus);
-
-    ret = sysctl(mib, 2, &nb_cpus, &len, NULL, 0);
-    if (ret == -1)
-        nb_cpus = 0;
-#elif HAVE_SYSCONF && defined(_SC_NPROC_ONLN)
-    nb_cpus = sysconf(_SC_NPROC_ONLN);
-#elif HAVE_SYSCONF && defined(_SC_NPROCESSORS_ONLN)
-    nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    pthread_mutex_unlock(&pool->lock);
+
+    return nb_tasks;
+}
+
+AVCodecThreadPool *avcodec_thread_pool_alloc(int nb_threads)
+{
+    AVCodecThreadPool *pool;
+    int i;
+
+#if HAVE_W32THREADS
+    w32thread_init();
 #endif
-    av_log(avctx, AV_LOG_DEBUG, "detected %d logical cores\n", nb_cpus);
-    return nb_cpus;
+
+    if (!nb_threads)
+        nb_threads = FFMIN(get_logical_cpus(NULL), FF_MAX_AUTO_THREADS);
+    if (nb_threads <= 0)
+        return NULL;
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return NULL;
+    pool->threads = av_malloc(sizeof(*pool->threads) * nb_threads);
+    if (!pool->threads) {
+        av_free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+
+    for (i = 0; i < nb_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool)) {
+            avcodec_thread_pool_free(&pool);
+            return NULL;
+        }
+        pool->nb_threads++;
+    }
+
+    return pool;
+}
+
+void avcodec_thread_pool_free(AVCodecThreadPool **ppool)
+{
+    AVCodecThreadPool *pool = *ppool;
+    int i;
+
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->die = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->nb_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->cond);
+    av_free(pool->threads);
+    av_freep(ppool);
 }
 
 
-static void* attribute_align_arg worker(void *v)
+/**
+ * Take the first job queued on a worker.
+ * @return job index within the batch, or -1 if the worker has none left
+ */
+static int claim_own_job(SliceWorker *w)
 {
-    AVCodecContext *avctx = v;
-    ThreadContext *c = avctx->thread_opaque;
-    int our_job = c->job_count;
-    int thread_count = avctx->thread_count;
-    int self_id;
+    int range, first, end;
 
-    pthread_mutex_lock(&c->current_job_lock);
-    self_id = c->current_job++;
-    for (;;){
-        while (our_job >= c->job_count) {
-            if (c->current_job == thread_count + c->job_count)
-                pthread_cond_signal(&c->last_job_cond);
+    do {
+        range = avpriv_atomic_int_get(&w->range);
+        first = range >> 16;
+        end   = range & 0xFFFF;
+        if (first >= end)
+            return -1;
+    } while (avpriv_atomic_int_cas(&w->range, range,
+                                   ((first + 1) << 16) | end) != range);
+
+    return first;
+}
 
-            pthread_cond_wait(&c->current_job_cond, &c->current_job_lock);
-            our_job = self_id;
+/**
+ * Take the last job queued on another worker.
+ * @return job index within the batch, or -1 if the victim has none left
+ */
+static int steal_job(SliceWorker *victim)
+{
+    int range, first, end;
 
-            if (c->done) {
-                pthread_mutex_unlock(&c->current_job_lock);
-                return NULL;
-            }
+    do {
+        range = avpriv_atomic_int_get(&victim->range);
+        first = range >> 16;
+        end   = range & 0xFFFF;
+        if (first >= end)
+            return -1;
+    } while (avpriv_atomic_int_cas(&victim->range, range,
+                                   (first << 16) | (end - 1)) != range);
+
+    return end - 1;
+}
+
+/**
+ * Run jobs of the current batch until there are none left to claim.
+ * Own jobs are taken first, then jobs are stolen from the other workers,
+ * starting with the following one so that thieves spread over the victims.
+ */
+static void run_jobs(ThreadContext *c, SliceWorker *w)
+{
+    AVCodecContext *avctx = c->avctx;
+    int i, job;
+
+    for (;;) {
+        job = claim_own_job(w);
+        for (i = 1; job < 0 && i < c->nb_workers; i++)
+            job = steal_job(&c->workers[(w->id + i) % c->nb_workers]);
+        if (job < 0)
+            return;
+
+        /* A claimed job keeps the batch from completing, so the batch
+         * parameters cannot change until it is reported as finished. */
+        job += c->job_offset;
+        c->rets[job % c->rets_count] =
+            c->func ? c->func(avctx, (char*)c->args + job * c->job_size) :
+                      c->func2(avctx, c->args, job, w->id);
+
+        if (!avpriv_atomic_int_add_and_fetch(&c->jobs_left, -1)) {
+            pthread_mutex_lock(&c->lock);
+            pthread_cond_signal(&c->done_cond);
+            pthread_mutex_unlock(&c->lock);
         }
-        pthread_mutex_unlock(&c->current_job_lock);
+    }
+}
 
-        c->rets[our_job%c->rets_count] = c->func ? c->func(avctx, (char*)c->args + our_job*c->job_size):
-                                                   c->func2(avctx, c->args, our_job, self_id);
+static void* attribute_align_arg worker(void *v)
+{
+    SliceWorker *w = v;
+    ThreadContext *c = w->c;
+    int generation = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&c->lock);
+        while (c->generation == generation && !c->done)
+            pthread_cond_wait(&c->work_cond, &c->lock);
+        generation = c->generation;
+        if (c->done) {
+            pthread_mutex_unlock(&c->lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&c->lock);
 
-        pthread_mutex_lock(&c->current_job_lock);
-        our_job = c->current_job++;
+        run_jobs(c, w);
     }
 }
 
-static av_always_inline void avcodec_thread_park_workers(ThreadContext *c, int thread_count)
+static void pool_slice_worker(void *arg)
 {
-    pthread_cond_wait(&c->last_job_cond, &c->current_job_lock);
-    pthread_mutex_unlock(&c->current_job_lock);
+    SliceWorker *w = arg;
+    ThreadContext *c = w->c;
+
+    run_jobs(c, w);
+
+    pthread_mutex_lock(&c->lock);
+    if (!--c->helpers_left)
+        pthread_cond_signal(&c->done_cond);
+    pthread_mutex_unlock(&c->lock);
 }
 
 static void thread_free(AVCodecContext *avctx)
@@ -236,25 +496,78 @@ static void thread_free(AVCodecContext *avctx)
     ThreadContext *c = avctx->thread_opaque;
     int i;
 
-    pthread_mutex_lock(&c->current_job_lock);
-    c->done = 1;
-    pthread_cond_broadcast(&c->current_job_cond);
-    pthread_mutex_unlock(&c->current_job_lock);
+    if (!c->pool) {
+        pthread_mutex_lock(&c->lock);
+        c->done = 1;
+        pthread_cond_broadcast(&c->work_cond);
+        pthread_mutex_unlock(&c->lock);
 
-    for (i=0; i<avctx->thread_count; i++)
-         pthread_join(c->workers[i], NULL);
+        for (i = 1; i < c->nb_workers; i++)
+             pthread_join(c->workers[i].thread, NULL);
+    }
 
-    pthread_mutex_destroy(&c->current_job_lock);
-    pthread_cond_destroy(&c->current_job_cond);
-    pthread_cond_destroy(&c->last_job_cond);
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->work_cond);
+    pthread_cond_destroy(&c->done_cond);
     av_free(c->workers);
     av_freep(&avctx->thread_opaque);
 }
 
+/**
+ * Distribute job_count jobs starting at job_offset over the workers,
+ * run them and wait for all of them to finish.
+ */
+static void execute_batch(ThreadContext *c, int job_offset, int job_count)
+{
+    int i;
+
+    c->job_offset = job_offset;
+    avpriv_atomic_int_set(&c->jobs_left, job_count);
+    /* Worker i starts with job i, so that each job gets its own thread when
+     * there are no more jobs than threads; the rest is split into
+     * contiguous ranges. */
+    for (i = 0; i < c->nb_workers; i++) {
+        int first, end;
+        if (job_count <= c->nb_workers) {
+            first = FFMIN(i, job_count);
+            end   = FFMIN(i + 1, job_count);
+        } else {
+            first = (int64_t)job_count *  i      / c->nb_workers;
+            end   = (int64_t)job_count * (i + 1) / c->nb_workers;
+        }
+        avpriv_atomic_int_set(&c->workers[i].range, (first << 16) | end);
+    }
+
+    if (c->pool) {
+        /* Pool threads may be busy with other contexts, so the helpers
+         * might start late or not at all; the jobs they have not claimed
+         * yet are stolen like any others. */
+        int nb_helpers = FFMIN(job_count, c->nb_workers) - 1;
+
+        c->helpers_left = nb_helpers;
+        for (i = 1; i <= nb_helpers; i++)
+            pool_submit(c->pool, &c->client, &c->workers[i].task);
+    } else {
+        pthread_mutex_lock(&c->lock);
+        c->generation++;
+        pthread_cond_broadcast(&c->work_cond);
+        pthread_mutex_unlock(&c->lock);
+    }
+
+    run_jobs(c, &c->workers[0]);
+
+    pthread_mutex_lock(&c->lock);
+    if (c->pool)
+        c->helpers_left -= pool_cancel(c->pool, &c->client);
+    while (avpriv_atomic_int_get(&c->jobs_left) || c->helpers_left)
+        pthread_cond_wait(&c->done_cond, &c->lock);
+    pthread_mutex_unlock(&c->lock);
+}
+
 static int avcodec_thread_execute(AVCodecContext *avctx, action_func* func, void *arg, int *ret, int job_count, int job_size)
 {
     ThreadContext *c= avctx->thread_opaque;
-    int dummy_ret;
+    int dummy_ret, i;
 
     if (!(avctx->active_thread_type&FF_THREAD_SLICE) || avctx->thread_count <= 1)
         return avcodec_default_execute(avctx, func, arg, ret, job_count, job_size);
@@ -262,10 +575,6 @@ static int avcodec_thread_execute(AVCodecContext *avctx, action_func* func, void
     if (job_count <= 0)
         return 0;
 
-    pthread_mutex_lock(&c->current_job_lock);
-
-    c->current_job = avctx->thread_count;
-    c->job_count = job_count;
     c->job_size = job_size;
     c->args = arg;
     c->func = func;
@@ -276,9 +585,9 @@ static int avcodec_thread_execute(AVCodecContext *avctx, action_func* func, void
         c->rets = &dummy_ret;
         c->rets_count = 1;
     }
-    pthread_cond_broadcast(&c->current_job_cond);
 
-    avcodec_thread_park_workers(c, avctx->thread_count);
+    for (i = 0; i < job_count; i += MAX_JOBS_PER_BATCH)
+        execute_batch(c, i, FFMIN(job_count - i, MAX_JOBS_PER_BATCH));
 
     return 0;
 }
@@ -296,14 +605,8 @@ static int thread_init(AVCodecContext *avctx)
     ThreadContext *c;
     int thread_count = avctx->thread_count;
 
-    if (!thread_count) {
-        int nb_cpus = get_logical_cpus(avctx);
-        // use number of cores + 1 as thread count if there is more than one
-        if (nb_cpus > 1)
-            thread_count = avctx->thread_count = FFMIN(nb_cpus + 1, MAX_AUTO_THREADS);
-        else
-            thread_count = avctx->thread_count = 1;
-    }
+    if (!thread_count)
+        thread_count = avctx->thread_count = get_auto_thread_count(avctx);
 
     if (thread_count <= 1) {
         avctx->active_thread_type = 0;
@@ -314,51 +617,82 @@ static int thread_init(AVCodecContext *avctx)
     if (!c)
         return -1;
 
-    c->workers = av_mallocz(sizeof(pthread_t)*thread_count);
+    c->workers = av_mallocz(sizeof(*c->workers) * thread_count);
     if (!c->workers) {
         av_free(c);
         return -1;
     }
 
     avctx->thread_opaque = c;
-    c->current_job = 0;
-    c->job_count = 0;
-    c->job_size = 0;
-    c->done = 0;
-    pthread_cond_init(&c->current_job_cond, NULL);
-    pthread_cond_init(&c->last_job_cond, NULL);
-    pthread_mutex_init(&c->current_job_lock, NULL);
-    pthread_mutex_lock(&c->current_job_lock);
-    for (i=0; i<thread_count; i++) {
-        if(pthread_create(&c->workers[i], NULL, worker, avctx)) {
+    c->avctx = avctx;
+    pthread_cond_init(&c->work_cond, NULL);
+    pthread_cond_init(&c->done_cond, NULL);
+    pthread_mutex_init(&c->lock, NULL);
+
+    /* the thread calling execute() acts as worker 0 */
+    for (i = 0; i < thread_count; i++) {
+        c->workers[i].c  = c;
+        c->workers[i].id = i;
+        c->workers[i].task.run    = pool_slice_worker;
+        c->workers[i].task.opaque = &c->workers[i];
+    }
+
+    c->pool = avctx->thread_pool;
+    c->nb_workers = c->pool ? thread_count : 1;
+    for (i = c->nb_workers; i < thread_count; i++) {
+        if (pthread_create(&c->workers[i].thread, NULL, worker, &c->workers[i])) {
            avctx->thread_count = i;
-           pthread_mutex_unlock(&c->current_job_lock);
            ff_thread_free(avctx);
            return -1;
         }
+        c->nb_workers++;
     }
 
-    avcodec_thread_park_workers(c, thread_count);
-
     avctx->execute = avcodec_thread_execute;
     avctx->execute2 = avcodec_thread_execute2;
     return 0;
 }
 
 /**
- * Codec worker thread.
+ * Decode the packet submitted to a codec thread.
  *
  * Automatically calls ff_thread_finish_setup() if the codec does
  * not provide an update_thread_context method, or if the codec returns
  * before calling it.
  */
-static attribute_align_arg void *frame_worker_thread(void *arg)
+static void frame_decode_packet(void *arg)
 {
     PerThreadContext *p = arg;
-    FrameThreadContext *fctx = p->parent;
     AVCodecContext *avctx = p->avctx;
     AVCodec *codec = avctx->codec;
 
+    if (!codec->update_thread_context && avctx->thread_safe_callbacks)
+        ff_thread_finish_setup(avctx);
+
+    pthread_mutex_lock(&p->mutex);
+    avcodec_get_frame_defaults(&p->frame);
+    p->got_frame = 0;
+    p->result = codec->decode(avctx, &p->frame, &p->got_frame, &p->avpkt);
+
+    if (p->state == STATE_SETTING_UP) ff_thread_finish_setup(avctx);
+
+    p->state = STATE_INPUT_READY;
+
+    pthread_mutex_lock(&p->progress_mutex);
+    pthread_cond_signal(&p->output_cond);
+    pthread_mutex_unlock(&p->progress_mutex);
+
+    pthread_mutex_unlock(&p->mutex);
+}
+
+/**
+ * Codec worker thread, used when no shared thread pool is set.
+ */
+static attribute_align_arg void *frame_worker_thread(void *arg)
+{
+    PerThreadContext *p = arg;
+    FrameThreadContext *fctx = p->parent;
+
     while (1) {
         if (p->state == STATE_INPUT_READY && !fctx->die) {
             pthread_mutex_lock(&p->mutex);
@@ -369,23 +703,7 @@ static attribute_align_arg void *frame_worker_thread(void *arg)
 
         if (fctx->die) break;
 
-        if (!codec->update_thread_context && avctx->thread_safe_callbacks)
-            ff_thread_finish_setup(avctx);
-
-        pthread_mutex_lock(&p->mutex);
-        avcodec_get_frame_defaults(&p->frame);
-        p->got_frame = 0;
-        p->result = codec->decode(avctx, &p->frame, &p->got_frame, &p->avpkt);
-
-        if (p->state == STATE_SETTING_UP) ff_thread_finish_setup(avctx);
-
-        p->state = STATE_INPUT_READY;
-
-        pthread_mutex_lock(&p->progress_mutex);
-        pthread_cond_signal(&p->output_cond);
-        pthread_mutex_unlock(&p->progress_mutex);
-
-        pthread_mutex_unlock(&p->mutex);
+        frame_decode_packet(p);
     }
 
     return NULL;
@@ -549,7 +867,12 @@ static int submit_packet(PerThreadContext *p, AVPacket *avpkt)
     memset(buf + avpkt->size, 0, FF_INPUT_BUFFER_PADDING_SIZE);
 
     p->state = STATE_SETTING_UP;
-    pthread_cond_signal(&p->input_cond);
+    /* Packets of a context are queued in decoding order, so a frame is
+     * never started before the frames it may wait on. */
+    if (fctx->pool)
+        pool_submit(fctx->pool, &fctx->client, &p->task);
+    else
+        pthread_cond_signal(&p->input_cond);
     pthread_mutex_unlock(&p->mutex);
 
     /*
@@ -782,14 +1105,8 @@ static int frame_thread_init(AVCodecContext *avctx)
     FrameThreadContext *fctx;
     int i, err = 0;
 
-    if (!thread_count) {
-        int nb_cpus = get_logical_cpus(avctx);
-        // use number of cores + 1 as thread count if there is more than one
-        if (nb_cpus > 1)
-            thread_count = avctx->thread_count = FFMIN(nb_cpus + 1, MAX_AUTO_THREADS);
-        else
-            thread_count = avctx->thread_count = 1;
-    }
+    if (!thread_count)
+        thread_count = avctx->thread_count = get_auto_thread_count(avctx);
 
     if (thread_count <= 1) {
         avctx->active_thread_type = 0;
@@ -801,6 +1118,7 @@ static int frame_thread_init(AVCodecContext *avctx)
     fctx->threads = av_mallocz(sizeof(PerThreadContext) * thread_count);
     pthread_mutex_init(&fctx->buffer_mutex, NULL);
     fctx->delaying = 1;
+    fctx->pool     = avctx->thread_pool;
 
     for (i = 0; i < thread_count; i++) {
         AVCodecContext *copy = av_malloc(sizeof(AVCodecContext));
@@ -814,6 +1132,8 @@ static int frame_thread_init(AVCodecContext *avctx)
 
         p->parent = fctx;
         p->avctx  = copy;
+        p->task.run    = frame_decode_packet;
+        p->task.opaque = p;
 
         if (!copy) {
             err = AVERROR(ENOMEM);
@@ -852,7 +1172,7 @@ static int frame_thread_init(AVCodecContext *avctx)
 
         if (err) goto error;
 
-        if (!pthread_create(&p->thread, NULL, frame_worker_thread, p))
+        if (!fctx->pool && !pthread_create(&p->thread, NULL, frame_worker_thread, p))
             p->thread_init = 1;
     }
 
@@ -1018,10 +1338,10 @@ static void validate_thread_parameters(AVCodecContext *avctx)
         avctx->active_thread_type = 0;
     }
 
-    if (avctx->thread_count > MAX_AUTO_THREADS)
+    if (avctx->thread_count > FF_MAX_AUTO_THREADS)
         av_log(avctx, AV_LOG_WARNING,
                "Application has requested %d threads. Using a thread count greater than %d is not recommended.\n",
-               avctx->thread_count, MAX_AUTO_THREADS);
+               avctx->thread_count, FF_MAX_AUTO_THREADS);
 }
 
 int ff_thread_init(AVCodecContext *avctx)
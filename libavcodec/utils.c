@@ -147,8 +147,6 @@ void avcodec_set_dimensions(AVCodecContext *s, int width, int height){
     s->height = height;
 }
 
-#define INTERNAL_BUFFER_SIZE (32+1)
-
 void avcodec_align_dimensions2(AVCodecContext *s, int *width, int *height,
                                int linesize_align[AV_NUM_DATA_POINTERS])
 {
@@ -367,108 +365,132 @@ static int audio_get_buffer(AVCodecContext *avctx, AVFrame *frame)
     return 0;
 }
 
-static int video_get_buffer(AVCodecContext *s, AVFrame *pic)
+static AVBufferRef *pool_alloc_gray(int size)
 {
-    int i;
-    int w= s->width;
-    int h= s->height;
-    InternalBuffer *buf;
-    AVCodecInternal *avci = s->internal;
+    AVBufferRef *ref = av_buffer_alloc(size);
+    /* XXX this shouldn't be needed, but some decoders read from freshly
+     * allocated buffers before writing them */
+    if (ref)
+        memset(ref->data, 128, size);
+    return ref;
+}
 
-    if(pic->data[0]!=NULL) {
-        av_log(s, AV_LOG_ERROR, "pic->data[0]!=NULL in avcodec_default_get_buffer\n");
-        return -1;
-    }
-    if(avci->buffer_count >= INTERNAL_BUFFER_SIZE) {
-        av_log(s, AV_LOG_ERROR, "buffer_count overflow (missing release_buffer?)\n");
-        return -1;
-    }
+static int update_frame_pool(AVCodecContext *s)
+{
+    FramePool *pool = &s->internal->pool;
+    int w = s->width, h = s->height;
+    int size[4] = { 0 };
+    int tmpsize, unaligned, i;
+    AVPicture picture;
+
+    if (pool->format == s->pix_fmt && pool->width == s->width &&
+        pool->height == s->height && pool->pools[0])
+        return 0;
 
-    if(av_image_check_size(w, h, 0, s))
-        return -1;
+    avcodec_align_dimensions2(s, &w, &h, pool->stride_align);
 
-    if (!avci->buffer) {
-        avci->buffer = av_mallocz((INTERNAL_BUFFER_SIZE+1) *
-                                  sizeof(InternalBuffer));
+    if (!(s->flags & CODEC_FLAG_EMU_EDGE)) {
+        w += EDGE_WIDTH * 2;
+        h += EDGE_WIDTH * 2;
     }
 
-    buf = &avci->buffer[avci->buffer_count];
+    do {
+        // NOTE: do not align linesizes individually, this breaks e.g. assumptions
+        // that linesize[0] == 2*linesize[1] in the MPEG-encoder for 4:2:2
+        av_image_fill_linesizes(picture.linesize, s->pix_fmt, w);
+        // increase alignment of w for next try (rhs gives the lowest bit set in w)
+        w += w & ~(w - 1);
 
-    if(buf->base[0] && (buf->width != w || buf->height != h || buf->pix_fmt != s->pix_fmt)){
-        for (i = 0; i < AV_NUM_DATA_POINTERS; i++) {
-            av_freep(&buf->base[i]);
-            buf->data[i]= NULL;
+        unaligned = 0;
+        for (i = 0; i < 4; i++)
+            unaligned |= picture.linesize[i] % pool->stride_align[i];
+    } while (unaligned);
+
+    tmpsize = av_image_fill_pointers(picture.data, s->pix_fmt, h, NULL,
+                                     picture.linesize);
+    if (tmpsize < 0)
+        return -1;
+
+    for (i = 0; i < 3 && picture.data[i + 1]; i++)
+        size[i] = picture.data[i + 1] - picture.data[i];
+    size[i] = tmpsize - (picture.data[i] - picture.data[0]);
+
+    for (i = 0; i < 4; i++) {
+        av_buffer_pool_uninit(&pool->pools[i]);
+        pool->linesize[i]  = picture.linesize[i];
+        pool->pool_size[i] = size[i];
+        if (size[i]) {
+            pool->pools[i] = av_buffer_pool_init(size[i] + 16, pool_alloc_gray);
+            if (!pool->pools[i]) {
+                pool->format = -1;
+                return AVERROR(ENOMEM);
+            }
         }
     }
+    pool->format = s->pix_fmt;
+    pool->width  = s->width;
+    pool->height = s->height;
 
-    if (!buf->base[0]) {
-        int h_chroma_shift, v_chroma_shift;
-        int size[4] = {0};
-        int tmpsize;
-        int unaligned;
-        AVPicture picture;
-        int stride_align[AV_NUM_DATA_POINTERS];
-        const int pixel_size = av_pix_fmt_descriptors[s->pix_fmt].comp[0].step_minus1+1;
-
-        avcodec_get_chroma_sub_sample(s->pix_fmt, &h_chroma_shift, &v_chroma_shift);
+    return 0;
+}
 
-        avcodec_align_dimensions2(s, &w, &h, stride_align);
+static int video_get_buffer(AVCodecContext *s, AVFrame *pic)
+{
+    int i;
+    InternalBuffer *buf;
+    AVCodecInternal *avci = s->internal;
+    FramePool *pool = &avci->pool;
+    int h_chroma_shift, v_chroma_shift;
+    const int pixel_size = av_pix_fmt_descriptors[s->pix_fmt].comp[0].step_minus1+1;
 
-        if(!(s->flags&CODEC_FLAG_EMU_EDGE)){
-            w+= EDGE_WIDTH*2;
-            h+= EDGE_WIDTH*2;
-        }
+    if(pic->data[0]!=NULL) {
+        av_log(s, AV_LOG_ERROR, "pic->data[0]!=NULL in avcodec_default_get_buffer\n");
+        return -1;
+    }
 
-        do {
-            // NOTE: do not align linesizes individually, this breaks e.g. assumptions
-            // that linesize[0] == 2*linesize[1] in the MPEG-encoder for 4:2:2
-            av_image_fill_linesizes(picture.linesize, s->pix_fmt, w);
-            // increase alignment of w for next try (rhs gives the lowest bit set in w)
-            w += w & ~(w-1);
+    if(av_image_check_size(s->width, s->height, 0, s))
+        return -1;
 
-            unaligned = 0;
-            for (i=0; i<4; i++){
-                unaligned |= picture.linesize[i] % stride_align[i];
-            }
-        } while (unaligned);
+    if (avci->buffer_count >= avci->buffer_size) {
+        int new_size = FFMAX(2 * avci->buffer_size, 8);
+        InternalBuffer *tmp = av_realloc(avci->buffer,
+                                         new_size * sizeof(*avci->buffer));
+        if (!tmp)
+            return AVERROR(ENOMEM);
+        memset(tmp + avci->buffer_size, 0,
+               (new_size - avci->buffer_size) * sizeof(*tmp));
+        avci->buffer      = tmp;
+        avci->buffer_size = new_size;
+    }
 
-        tmpsize = av_image_fill_pointers(picture.data, s->pix_fmt, h, NULL, picture.linesize);
-        if (tmpsize < 0)
-            return -1;
+    if (update_frame_pool(s) < 0)
+        return -1;
 
-        for (i=0; i<3 && picture.data[i+1]; i++)
-            size[i] = picture.data[i+1] - picture.data[i];
-        size[i] = tmpsize - (picture.data[i] - picture.data[0]);
+    buf = &avci->buffer[avci->buffer_count];
+    memset(buf, 0, sizeof(*buf));
 
-        memset(buf->base, 0, sizeof(buf->base));
-        memset(buf->data, 0, sizeof(buf->data));
+    avcodec_get_chroma_sub_sample(s->pix_fmt, &h_chroma_shift, &v_chroma_shift);
 
-        for(i=0; i<4 && size[i]; i++){
-            const int h_shift= i==0 ? 0 : h_chroma_shift;
-            const int v_shift= i==0 ? 0 : v_chroma_shift;
+    for (i = 0; i < 4 && pool->pools[i]; i++) {
+        const int h_shift= i==0 ? 0 : h_chroma_shift;
+        const int v_shift= i==0 ? 0 : v_chroma_shift;
 
-            buf->linesize[i]= picture.linesize[i];
+        buf->buf[i] = av_buffer_pool_get(pool->pools[i]);
+        if (!buf->buf[i])
+            goto fail;
 
-            buf->base[i]= av_malloc(size[i]+16); //FIXME 16
-            if(buf->base[i]==NULL) return -1;
-            memset(buf->base[i], 128, size[i]);
+        buf->linesize[i] = pool->linesize[i];
+        buf->base[i]     = buf->buf[i]->data;
 
-            // no edge if EDGE EMU or not planar YUV
-            if((s->flags&CODEC_FLAG_EMU_EDGE) || !size[2])
-                buf->data[i] = buf->base[i];
-            else
-                buf->data[i] = buf->base[i] + FFALIGN((buf->linesize[i]*EDGE_WIDTH>>v_shift) + (pixel_size*EDGE_WIDTH>>h_shift), stride_align[i]);
-        }
-        for (; i < AV_NUM_DATA_POINTERS; i++) {
-            buf->base[i] = buf->data[i] = NULL;
-            buf->linesize[i] = 0;
-        }
-        if(size[1] && !size[2])
-            ff_set_systematic_pal2((uint32_t*)buf->data[1], s->pix_fmt);
-        buf->width  = s->width;
-        buf->height = s->height;
-        buf->pix_fmt= s->pix_fmt;
+        // no edge if EDGE EMU or not planar YUV
+        if((s->flags&CODEC_FLAG_EMU_EDGE) || !pool->pool_size[2])
+            buf->data[i] = buf->base[i];
+        else
+            buf->data[i] = buf->base[i] + FFALIGN((buf->linesize[i]*EDGE_WIDTH>>v_shift) + (pixel_size*EDGE_WIDTH>>h_shift), pool->stride_align[i]);
     }
+    if (pool->pool_size[1] && !pool->pool_size[2])
+        ff_set_systematic_pal2((uint32_t*)buf->data[1], s->pix_fmt);
+
     pic->type= FF_BUFFER_TYPE_INTERNAL;
 
     for (i = 0; i < AV_NUM_DATA_POINTERS; i++) {
@@ -478,9 +500,9 @@ static int video_get_buffer(AVCodecContext *s, AVFrame *pic)
     }
     pic->extended_data = pic->data;
     avci->buffer_count++;
-    pic->width  = buf->width;
-    pic->height = buf->height;
-    pic->format = buf->pix_fmt;
+    pic->width  = s->width;
+    pic->height = s->height;
+    pic->format = s->pix_fmt;
     pic->sample_aspect_ratio = s->sample_aspect_ratio;
 
     if(s->pkt) pic->pkt_pts= s->pkt->pts;
@@ -492,6 +514,10 @@ static int video_get_buffer(AVCodecContext *s, AVFrame *pic)
                "buffers used\n", pic, avci->buffer_count);
 
     return 0;
+fail:
+    for (i = 0; i < AV_NUM_DATA_POINTERS; i++)
+        av_buffer_unref(&buf->buf[i]);
+    return AVERROR(ENOMEM);
 }
 
 int avcodec_default_get_buffer(AVCodecContext *avctx, AVFrame *frame)
@@ -527,6 +553,9 @@ void avcodec_default_release_buffer(AVCodecContext *s, AVFrame *pic){
         avci->buffer_count--;
         last = &avci->buffer[avci->buffer_count];
 
+        for (i = 0; i < AV_NUM_DATA_POINTERS; i++)
+            av_buffer_unref(&buf->buf[i]);
+
         if (buf != last)
             FFSWAP(InternalBuffer, *buf, *last);
     }
@@ -1670,16 +1699,17 @@ static void video_free_buffers(AVCodecContext *s)
     if (avci->buffer_count)
         av_log(s, AV_LOG_WARNING, "Found %i unreleased buffers!\n",
                avci->buffer_count);
-    for(i=0; i<INTERNAL_BUFFER_SIZE; i++){
+    for (i = 0; i < avci->buffer_count; i++) {
         InternalBuffer *buf = &avci->buffer[i];
-        for(j=0; j<4; j++){
-            av_freep(&buf->base[j]);
-            buf->data[j]= NULL;
-        }
+        for (j = 0; j < AV_NUM_DATA_POINTERS; j++)
+            av_buffer_unref(&buf->buf[j]);
     }
+    for (i = 0; i < FF_ARRAY_ELEMS(avci->pool.pools); i++)
+        av_buffer_pool_uninit(&avci->pool.pools[i]);
     av_freep(&avci->buffer);
 
-    avci->buffer_count=0;
+    avci->buffer_count = 0;
+    avci->buffer_size  = 0;
 }
 
 static void audio_free_buffers(AVCodecContext *avctx)
@@ -1925,6 +1955,16 @@ int av_get_audio_frame_duration(AVCodecContext *avctx, int frame_bytes)
 int ff_thread_init(AVCodecContext *s){
     return -1;
 }
+
+AVCodecThreadPool *avcodec_thread_pool_alloc(int nb_threads)
+{
+    return NULL;
+}
+
+void avcodec_thread_pool_free(AVCodecThreadPool **pool)
+{
+    *pool = NULL;
+}
 #endif
 
 unsigned int av_xiphlacing(unsigned char *s, unsigned int v)
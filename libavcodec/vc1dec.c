@@ -37,6 +37,7 @@
 #include "msmpeg4data.h"
 #include "unary.h"
 #include "mathops.h"
+#include "thread.h"
 #include "vdpau_internal.h"
 
 #undef NDEBUG
@@ -4305,6 +4306,48 @@ static void vc1_decode_b_mb_intfi(VC1Context *v)
     }
 }
 
+/** Tell the threads decoding frames which reference the current picture
+ * that the MB rows above the current one are done.
+ * The overlap and loop filters trail the decoding loop by up to two rows
+ * and also modify the bottom lines of the row above those.
+ */
+static void vc1_report_decode_progress(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+    int row = s->mb_y - 3;
+
+    if (s->pict_type == AV_PICTURE_TYPE_B || row < 0)
+        return;
+    if (v->field_mode) {
+        // field MB rows cover two frame MB rows, and both fields are needed
+        if (!v->second_field)
+            return;
+        row = 2 * row + 1;
+    }
+    ff_thread_report_progress(&s->current_picture_ptr->f, row, 0);
+}
+
+/** Wait until the reference pictures are decoded down to the lowest line
+ * the motion compensation of the current MB row can read.
+ * Vertical MVs are limited to range_y quarter samples, so using range_y as a
+ * number of frame lines also covers field MVs.
+ */
+static void vc1_await_references(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+    int y;
+
+    if (v->field_mode)
+        y = 2 * (s->mb_y + 1) * 16 + v->range_y + 8;
+    else
+        y = (s->mb_y + 1) * 16 + v->range_y + 4;
+
+    if (s->last_picture_ptr)
+        ff_thread_await_progress(&s->last_picture_ptr->f, y >> 4, 0);
+    if (s->pict_type == AV_PICTURE_TYPE_B && s->next_picture_ptr)
+        ff_thread_await_progress(&s->next_picture_ptr->f, y >> 4, 0);
+}
+
 /** Decode blocks of I-frame
  */
 static void vc1_decode_i_blocks(VC1Context *v)
@@ -4434,6 +4477,7 @@ static void vc1_decode_i_blocks(VC1Context *v)
             ff_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_decode_progress(v);
 
         s->first_slice_line = 0;
     }
@@ -4559,6 +4603,7 @@ static void vc1_decode_i_blocks_adv(VC1Context *v)
             ff_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_draw_horiz_band(s, (s->mb_y-1) * 16, 16);
+        vc1_report_decode_progress(v);
         s->first_slice_line = 0;
     }
 
@@ -4613,6 +4658,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         ff_init_block_index(s);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -4636,6 +4682,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
         memmove(v->is_intra_base, v->is_intra, sizeof(v->is_intra_base[0]) * s->mb_stride);
         memmove(v->luma_mv_base,  v->luma_mv,  sizeof(v->luma_mv_base[0])  * s->mb_stride);
         if (s->mb_y != s->start_mb_y) ff_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_decode_progress(v);
         s->first_slice_line = 0;
     }
     if (apply_loop_filter) {
@@ -4685,6 +4732,7 @@ static void vc1_decode_b_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         ff_init_block_index(s);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -4723,10 +4771,12 @@ static void vc1_decode_skip_blocks(VC1Context *v)
         s->mb_x = 0;
         ff_init_block_index(s);
         ff_update_block_index(s);
+        ff_thread_await_progress(&s->last_picture_ptr->f, s->mb_y, 0);
         memcpy(s->dest[0], s->last_picture.f.data[0] + s->mb_y * 16 * s->linesize,   s->linesize   * 16);
         memcpy(s->dest[1], s->last_picture.f.data[1] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         memcpy(s->dest[2], s->last_picture.f.data[2] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         ff_draw_horiz_band(s, s->mb_y * 16, 16);
+        ff_thread_report_progress(&s->current_picture_ptr->f, s->mb_y, 0);
         s->first_slice_line = 0;
     }
     s->pict_type = AV_PICTURE_TYPE_P;
@@ -5046,6 +5096,15 @@ static void vc1_sprite_flush(AVCodecContext *avctx)
 
 #endif
 
+/** Point mv_f to the field MV flags stored in one of the mv_f_base buffers */
+static void vc1_set_mv_f(VC1Context *v, uint8_t *mv_f[2], int buf)
+{
+    MpegEncContext *s = &v->s;
+
+    mv_f[0] = v->mv_f_base[buf] + s->b8_stride + 1;
+    mv_f[1] = mv_f[0] + (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2);
+}
+
 static av_cold int vc1_decode_init_alloc_tables(VC1Context *v)
 {
     MpegEncContext *s = &v->s;
@@ -5079,15 +5138,11 @@ static av_cold int vc1_decode_init_alloc_tables(VC1Context *v)
     /* allocate memory to store block level MV info */
     v->blk_mv_type_base = av_mallocz(     s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2);
     v->blk_mv_type      = v->blk_mv_type_base + s->b8_stride + 1;
-    v->mv_f_base        = av_mallocz(2 * (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2));
-    v->mv_f[0]          = v->mv_f_base + s->b8_stride + 1;
-    v->mv_f[1]          = v->mv_f[0] + (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2);
-    v->mv_f_last_base   = av_mallocz(2 * (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2));
-    v->mv_f_last[0]     = v->mv_f_last_base + s->b8_stride + 1;
-    v->mv_f_last[1]     = v->mv_f_last[0] + (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2);
-    v->mv_f_next_base   = av_mallocz(2 * (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2));
-    v->mv_f_next[0]     = v->mv_f_next_base + s->b8_stride + 1;
-    v->mv_f_next[1]     = v->mv_f_next[0] + (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2);
+    v->mv_f_base[0]     = av_mallocz(2 * (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2));
+    v->mv_f_base[1]     = av_mallocz(2 * (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2));
+    v->mv_f_anchor      = 1;
+    vc1_set_mv_f(v, v->mv_f,      0);
+    vc1_set_mv_f(v, v->mv_f_next, 1);
 
     /* Init coded blocks info */
     if (v->profile == PROFILE_ADVANCED) {
@@ -5106,7 +5161,7 @@ static av_cold int vc1_decode_init_alloc_tables(VC1Context *v)
 
     if (!v->mv_type_mb_plane || !v->direct_mb_plane || !v->acpred_plane || !v->over_flags_plane ||
         !v->block || !v->cbp_base || !v->ttblk_base || !v->is_intra_base || !v->luma_mv_base ||
-        !v->mb_type_base)
+        !v->mb_type_base || !v->mv_f_base[0] || !v->mv_f_base[1])
             return -1;
 
     return 0;
@@ -5280,9 +5335,8 @@ static av_cold int vc1_decode_end(AVCodecContext *avctx)
     av_freep(&v->over_flags_plane);
     av_freep(&v->mb_type_base);
     av_freep(&v->blk_mv_type_base);
-    av_freep(&v->mv_f_base);
-    av_freep(&v->mv_f_last_base);
-    av_freep(&v->mv_f_next_base);
+    av_freep(&v->mv_f_base[0]);
+    av_freep(&v->mv_f_base[1]);
     av_freep(&v->block);
     av_freep(&v->cbp_base);
     av_freep(&v->ttblk_base);
@@ -5306,7 +5360,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     AVFrame *pict = data;
     uint8_t *buf2 = NULL;
     const uint8_t *buf_start = buf;
-    int mb_height, n_slices1;
+    int mb_height, n_slices1 = -1;
     struct {
         uint8_t *buf;
         GetBitContext gb;
@@ -5326,6 +5380,9 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
         return 0;
     }
 
+    /* frame threads get the user flags copied in before each packet */
+    avctx->flags |= CODEC_FLAG_EMU_EDGE;
+
     if (s->avctx->codec->capabilities&CODEC_CAP_HWACCEL_VDPAU) {
         if (v->profile < PROFILE_ADVANCED)
             avctx->pix_fmt = PIX_FMT_VDPAU_WMV3;
@@ -5448,6 +5505,10 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     if (s->context_initialized &&
         (s->width  != avctx->coded_width ||
          s->height != avctx->coded_height)) {
+        if (HAVE_THREADS && (avctx->active_thread_type & FF_THREAD_FRAME)) {
+            av_log_missing_feature(avctx, "Width/height changing with frame threads is", 0);
+            goto err;
+        }
         vc1_decode_end(avctx);
     }
 
@@ -5534,32 +5595,47 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
         &&s->avctx->codec->capabilities&CODEC_CAP_HWACCEL_VDPAU)
         ff_vdpau_vc1_decode_picture(s, buf_start, (buf + buf_size) - buf_start);
     else if (avctx->hwaccel) {
-        if (avctx->hwaccel->start_frame(avctx, buf, buf_size) < 0)
-            goto err;
-        if (avctx->hwaccel->decode_slice(avctx, buf_start, (buf + buf_size) - buf_start) < 0)
-            goto err;
-        if (avctx->hwaccel->end_frame(avctx) < 0)
+        if (avctx->hwaccel->start_frame(avctx, buf, buf_size) < 0 ||
+            avctx->hwaccel->decode_slice(avctx, buf_start, (buf + buf_size) - buf_start) < 0 ||
+            avctx->hwaccel->end_frame(avctx) < 0) {
+            /* ff_MPV_frame_end() is skipped, unblock threads waiting on this
+             * picture as a reference */
+            ff_thread_report_progress(&s->current_picture_ptr->f, INT_MAX, 0);
             goto err;
+        }
     } else {
         ff_er_frame_start(s);
 
         v->bits = buf_size * 8;
+
+        /* The field MV flags of the last anchor picture may still be read by
+         * B-frames decoded in other threads, so they are not overwritten. */
+        vc1_set_mv_f(v, v->mv_f, !v->mv_f_anchor);
         if (v->field_mode) {
-            uint8_t *tmp[2];
             s->current_picture.f.linesize[0] <<= 1;
             s->current_picture.f.linesize[1] <<= 1;
             s->current_picture.f.linesize[2] <<= 1;
             s->linesize                      <<= 1;
             s->uvlinesize                    <<= 1;
-            tmp[0]          = v->mv_f_last[0];
-            tmp[1]          = v->mv_f_last[1];
-            v->mv_f_last[0] = v->mv_f_next[0];
-            v->mv_f_last[1] = v->mv_f_next[1];
-            v->mv_f_next[0] = v->mv_f[0];
-            v->mv_f_next[1] = v->mv_f[1];
-            v->mv_f[0] = tmp[0];
-            v->mv_f[1] = tmp[1];
+            if (s->pict_type != AV_PICTURE_TYPE_B) {
+                v->mv_f_anchor = !v->mv_f_anchor;
+                v->mv_f_next[0] = v->mv_f[0];
+                v->mv_f_next[1] = v->mv_f[1];
+            }
+            /* the frame is exported with the type of its second field, which
+             * must be set before other threads get a copy of the picture */
+            s->current_picture_ptr->f.pict_type = (v->fptype & 1) ? AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_I;
+            if (v->fptype & 4)
+                s->current_picture_ptr->f.pict_type = (v->fptype & 1) ? AV_PICTURE_TYPE_BI : AV_PICTURE_TYPE_B;
         }
+
+        /* The header of the second field sets state inherited by the next
+         * pictures (intensity compensation, refdist, mvrange), which is
+         * copied by vc1_update_thread_context(), so for field pictures the
+         * setup is only finished once it has been parsed. */
+        if (!v->field_mode || n_slices < n_slices1 + 2)
+            ff_thread_finish_setup(avctx);
+
         mb_height = s->mb_height >> v->field_mode;
         for (i = 0; i <= n_slices; i++) {
             if (i > 0 &&  slices[i - 1].mby_start >= mb_height) {
@@ -5580,7 +5656,9 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
             if (i) {
                 v->pic_header_flag = 0;
                 if (v->field_mode && i == n_slices1 + 2) {
-                    if (ff_vc1_parse_frame_header_adv(v, &s->gb) < 0) {
+                    int ret = ff_vc1_parse_frame_header_adv(v, &s->gb);
+                    ff_thread_finish_setup(avctx);
+                    if (ret < 0) {
                         av_log(v->s.avctx, AV_LOG_ERROR, "Field header damaged\n");
                         continue;
                     }
@@ -5603,10 +5681,6 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
         }
         if (v->field_mode) {
             v->second_field = 0;
-            if (s->pict_type == AV_PICTURE_TYPE_B) {
-                memcpy(v->mv_f_base, v->mv_f_next_base,
-                       2 * (s->b8_stride * (s->mb_height * 2 + 1) + s->mb_stride * (s->mb_height + 1) * 2));
-            }
             s->current_picture.f.linesize[0] >>= 1;
             s->current_picture.f.linesize[1] >>= 1;
             s->current_picture.f.linesize[2] >>= 1;
@@ -5661,6 +5735,62 @@ err:
 }
 
 
+#if HAVE_THREADS
+static int vc1_update_thread_context(AVCodecContext *dst,
+                                     const AVCodecContext *src)
+{
+    VC1Context *v = dst->priv_data, *v1 = src->priv_data;
+    MpegEncContext *s = &v->s;
+    int ret;
+
+    if (dst == src || !v1->s.context_initialized)
+        return 0;
+
+    if ((ret = ff_mpeg_update_thread_context(dst, src)) < 0)
+        return ret;
+    s->flags |= CODEC_FLAG_EMU_EDGE;
+    /* the source context has doubled strides while decoding a field picture */
+    if (s->current_picture_ptr) {
+        s->linesize   = s->current_picture_ptr->f.linesize[0];
+        s->uvlinesize = s->current_picture_ptr->f.linesize[1];
+    }
+    if (!v->mv_type_mb_plane && vc1_decode_init_alloc_tables(v) < 0)
+        return AVERROR(ENOMEM);
+
+    s->h_edge_pos  = v1->s.h_edge_pos;
+    s->v_edge_pos  = v1->s.v_edge_pos;
+    s->loop_filter = v1->s.loop_filter;
+
+    // sequence and entry point headers
+    memcpy(&v->res_sprite, &v1->res_sprite,
+           (char *) &v1->mv_mode - (char *) &v1->res_sprite);
+    v->hrd_num_leaky_buckets = v1->hrd_num_leaky_buckets;
+    v->range_mapy_flag       = v1->range_mapy_flag;
+    v->range_mapuv_flag      = v1->range_mapuv_flag;
+    v->range_mapy            = v1->range_mapy;
+    v->range_mapuv           = v1->range_mapuv;
+    v->broken_link           = v1->broken_link;
+    v->closed_entry          = v1->closed_entry;
+
+    // state inherited by the following pictures
+    v->mvrange = v1->mvrange;
+    v->rnd     = v1->rnd;
+    v->use_ic  = v1->use_ic;
+    v->refdist = v1->refdist;
+    memcpy(v->luty,   v1->luty,   sizeof(v->luty));
+    memcpy(v->lutuv,  v1->lutuv,  sizeof(v->lutuv));
+    memcpy(v->luty2,  v1->luty2,  sizeof(v->luty2));
+    memcpy(v->lutuv2, v1->lutuv2, sizeof(v->lutuv2));
+
+    /* B field pictures read the field MV flags of the last anchor picture
+     * from the context which decoded it, waiting for its progress. */
+    v->mv_f_next[0] = v1->mv_f_next[0];
+    v->mv_f_next[1] = v1->mv_f_next[1];
+
+    return 0;
+}
+#endif
+
 static const AVProfile profiles[] = {
     { FF_PROFILE_VC1_SIMPLE,   "Simple"   },
     { FF_PROFILE_VC1_MAIN,     "Main"     },
@@ -5677,7 +5807,8 @@ AVCodec ff_vc1_decoder = {
     .init           = vc1_decode_init,
     .close          = vc1_decode_end,
     .decode         = vc1_decode_frame,
-    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
+    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY | CODEC_CAP_FRAME_THREADS,
     .long_name      = NULL_IF_CONFIG_SMALL("SMPTE VC-1"),
     .pix_fmts       = ff_hwaccel_pixfmt_list_420,
     .profiles       = NULL_IF_CONFIG_SMALL(profiles)
@@ -5692,7 +5823,8 @@ AVCodec ff_wmv3_decoder = {
     .init           = vc1_decode_init,
     .close          = vc1_decode_end,
     .decode         = vc1_decode_frame,
-    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
+    .capabilities   = CODEC_CAP_DR1 | CODEC_CAP_DELAY | CODEC_CAP_FRAME_THREADS,
     .long_name      = NULL_IF_CONFIG_SMALL("Windows Media Video 9"),
     .pix_fmts       = ff_hwaccel_pixfmt_list_420,
     .profiles       = NULL_IF_CONFIG_SMALL(profiles)
@@ -1667,7 +1667,7 @@ static void vp8_decode_mb_row_no_filter(AVCodecContext *avctx, void *tdata,
                                         int jobnr, int threadnr)
 {
     VP8Context *s = avctx->priv_data;
-    VP8ThreadData *prev_td, *next_td, *td = &s->thread_data[threadnr];
+    VP8ThreadData *prev_td, *next_td, *td = &s->thread_data[jobnr];
     int mb_y = td->thread_mb_pos>>16;
     int i, y, mb_x, mb_xy = mb_y*s->mb_width;
     int num_jobs = s->num_jobs;
@@ -1777,7 +1777,7 @@ static void vp8_filter_mb_row(AVCodecContext *avctx, void *tdata,
                               int jobnr, int threadnr)
 {
     VP8Context *s = avctx->priv_data;
-    VP8ThreadData *td = &s->thread_data[threadnr];
+    VP8ThreadData *td = &s->thread_data[jobnr];
     int mb_x, mb_y = td->thread_mb_pos>>16, num_jobs = s->num_jobs;
     AVFrame *curframe = s->curframe;
     VP8Macroblock *mb;
@@ -1976,7 +1976,9 @@ static int vp8_decode_frame(AVCodecContext *avctx, void *data, int *data_size,
     if (s->mb_layout == 1)
         vp8_decode_mv_mb_modes(avctx, curframe, prev_frame);
 
-    if (avctx->active_thread_type == FF_THREAD_FRAME)
+    /* The row jobs wait on each other, which needs them all to run at
+     * once; this is not guaranteed on a shared thread pool. */
+    if (avctx->active_thread_type == FF_THREAD_FRAME || avctx->thread_pool)
         num_jobs = 1;
     else
         num_jobs = FFMIN(s->num_coeff_partitions, avctx->thread_count);
@@ -158,6 +158,8 @@ int ff_filter_samples(AVFilterLink *link, AVFilterBufferRef *samplesref)
     int (*filter_samples)(AVFilterLink *, AVFilterBufferRef *);
     AVFilterPad *dst = link->dstpad;
     AVFilterBufferRef *buf_out;
+    FFStatsTimer t;
+    int ret, timed;
 
     FF_DPRINTF_START(NULL, filter_samples); ff_dlog_link(NULL, link, 1);
 
@@ -190,6 +192,11 @@ int ff_filter_samples(AVFilterLink *link, AVFilterBufferRef *samplesref)
     } else
         buf_out = samplesref;
 
-    return filter_samples(link, buf_out);
+    ff_stats_count_frame(link);
+    timed = ff_stats_start(link->dst, &t);
+    ret = filter_samples(link, buf_out);
+    if (timed)
+        ff_stats_stop(link->dst, AVFILTER_STATS_FILTER_SAMPLES, &t);
+    return ret;
 }
 
@@ -21,14 +21,26 @@
 
 /* #define DEBUG */
 
+#include "config.h"
+
+#if HAVE_CLOCK_GETTIME
+#include <time.h>
+#elif HAVE_GETTHREADTIMES
+#include <windows.h>
+#endif
+
+#include "libavutil/buffer.h"
 #include "libavutil/common.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/rational.h"
 #include "libavutil/audioconvert.h"
+#include "libavutil/time.h"
 
 #include "avfilter.h"
+#include "avfiltergraph.h"
 #include "formats.h"
 #include "internal.h"
+#include "thread.h"
 
 unsigned avfilter_version(void) {
     return LIBAVFILTER_VERSION_INT;
@@ -232,13 +244,113 @@ void ff_dlog_link(void *ctx, AVFilterLink *link, int end)
     }
 }
 
+/**
+ * @return the CPU time used by the calling thread in microseconds, or -1
+ * if there is no per thread CPU clock; the CPU time of the process would
+ * also count decoders, encoders and I/O running in other threads
+ */
+static int64_t get_cpu_time(void)
+{
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0)
+        return -1;
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+#elif HAVE_GETTHREADTIMES
+    FILETIME c, e, k, u;
+
+    if (!GetThreadTimes(GetCurrentThread(), &c, &e, &k, &u))
+        return -1;
+    return (((int64_t)k.dwHighDateTime << 32 | k.dwLowDateTime) +
+            ((int64_t)u.dwHighDateTime << 32 | u.dwLowDateTime)) / 10;
+#else
+    return -1;
+#endif
+}
+
+static FFStatsNested *get_stats_nested(AVFilterGraph *graph)
+{
+    FFStatsNested *nested = ff_frame_thread_stats_nested(graph);
+    return nested ? nested : &graph->internal->stats_nested;
+}
+
+int ff_stats_start(AVFilterContext *ctx, FFStatsTimer *t)
+{
+    FFStatsNested *nested;
+
+    if (!ctx->graph || !ctx->graph->collect_stats)
+        return 0;
+    nested = get_stats_nested(ctx->graph);
+
+    t->nested_wall = nested->wall;
+    t->nested_cpu  = nested->cpu;
+    nested->wall = 0;
+    nested->cpu  = 0;
+    t->wall = av_gettime();
+    t->cpu  = get_cpu_time();
+    return 1;
+}
+
+void ff_stats_stop(AVFilterContext *ctx, enum AVFilterStatsCallback cb,
+                   FFStatsTimer *t)
+{
+    FFStatsNested *nested = get_stats_nested(ctx->graph);
+    AVFilterStats *stats = &ctx->internal->stats;
+    int64_t wall = av_gettime()   - t->wall;
+    int64_t now  = get_cpu_time();
+    int64_t cpu  = now - t->cpu;
+
+    stats->calls[cb]++;
+    stats->wall_time[cb] += wall - nested->wall;
+    if (now < 0 || t->cpu < 0)
+        stats->cpu_time[cb] = -1;
+    else if (stats->cpu_time[cb] >= 0)
+        stats->cpu_time[cb] += cpu - nested->cpu;
+
+    /* the caller, if timed too, does not own the time spent here */
+    nested->wall = t->nested_wall + wall;
+    nested->cpu  = t->nested_cpu  + cpu;
+}
+
+void ff_stats_count_frame(AVFilterLink *link)
+{
+    if (!link->dst->graph || !link->dst->graph->collect_stats)
+        return;
+    link->src->internal->stats.frames_out++;
+    link->dst->internal->stats.frames_in++;
+}
+
+void ff_stats_set_queued(AVFilterContext *ctx, int nb_queued)
+{
+    AVFilterStats *stats = &ctx->internal->stats;
+
+    if (!ctx->graph || !ctx->graph->collect_stats)
+        return;
+    stats->queued     = nb_queued;
+    stats->max_queued = FFMAX(stats->max_queued, nb_queued);
+}
+
+const AVFilterStats *avfilter_get_stats(AVFilterContext *filter)
+{
+    if (!filter->graph || !filter->graph->collect_stats)
+        return NULL;
+    return &filter->internal->stats;
+}
+
 int ff_request_frame(AVFilterLink *link)
 {
     FF_DPRINTF_START(NULL, request_frame); ff_dlog_link(NULL, link, 1);
 
-    if (link->srcpad->request_frame)
-        return link->srcpad->request_frame(link);
-    else if (link->src->inputs[0])
+    if (link->srcpad->request_frame) {
+        FFStatsTimer t;
+        int ret, timed = ff_stats_start(link->src, &t);
+
+        ret = link->srcpad->request_frame(link);
+        if (timed)
+            ff_stats_stop(link->src, AVFILTER_STATS_REQUEST_FRAME, &t);
+        return ret;
+    } else if (link->src->inputs[0])
         return ff_request_frame(link->src->inputs[0]);
     else return -1;
 }
@@ -319,6 +431,19 @@ static const AVClass avfilter_class = {
     LIBAVUTIL_VERSION_INT,
 };
 
+static int default_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                           void *arg, int *ret, int nb_jobs)
+{
+    int i;
+
+    for (i = 0; i < nb_jobs; i++) {
+        int r = func(ctx, arg, i, nb_jobs);
+        if (ret)
+            ret[i] = r;
+    }
+    return 0;
+}
+
 int avfilter_open(AVFilterContext **filter_ctx, AVFilter *filter, const char *inst_name)
 {
     AVFilterContext *ret;
@@ -340,6 +465,11 @@ int avfilter_open(AVFilterContext **filter_ctx, AVFilter *filter, const char *in
             goto err;
     }
 
+    ret->internal = av_mallocz(sizeof(*ret->internal));
+    if (!ret->internal)
+        goto err;
+    ret->internal->execute = default_execute;
+
     ret->nb_inputs = pad_count(filter->inputs);
     if (ret->nb_inputs ) {
         ret->input_pads   = av_malloc(sizeof(AVFilterPad) * ret->nb_inputs);
@@ -377,6 +507,7 @@ err:
     av_freep(&ret->output_pads);
     ret->nb_outputs = 0;
     av_freep(&ret->priv);
+    av_freep(&ret->internal);
     av_free(ret);
     return AVERROR(ENOMEM);
 }
@@ -399,6 +530,7 @@ void avfilter_free(AVFilterContext *filter)
             ff_formats_unref(&link->out_samplerates);
             ff_channel_layouts_unref(&link->in_channel_layouts);
             ff_channel_layouts_unref(&link->out_channel_layouts);
+            av_buffer_pool_uninit(&link->pool);
         }
         av_freep(&link);
     }
@@ -412,6 +544,7 @@ void avfilter_free(AVFilterContext *filter)
             ff_formats_unref(&link->out_samplerates);
             ff_channel_layouts_unref(&link->in_channel_layouts);
             ff_channel_layouts_unref(&link->out_channel_layouts);
+            av_buffer_pool_uninit(&link->pool);
         }
         av_freep(&link);
     }
@@ -422,6 +555,7 @@ void avfilter_free(AVFilterContext *filter)
     av_freep(&filter->inputs);
     av_freep(&filter->outputs);
     av_freep(&filter->priv);
+    av_freep(&filter->internal);
     av_free(filter);
 }
 
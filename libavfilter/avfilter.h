@@ -382,6 +382,19 @@ const char *avfilter_pad_get_name(AVFilterPad *pads, int pad_idx);
  */
 enum AVMediaType avfilter_pad_get_type(AVFilterPad *pads, int pad_idx);
 
+/**
+ * The filter supports multithreading by splitting frames into multiple parts
+ * and processing them concurrently.
+ */
+#define AVFILTER_FLAG_SLICE_THREADS         (1 << 0)
+
+/**
+ * The filter can run in its own thread, concurrently with the other filters
+ * of the graph. Its callbacks must not access any other filter, nor any state
+ * shared between its instances.
+ */
+#define AVFILTER_FLAG_FRAME_THREADS         (1 << 1)
+
 /**
  * Filter definition. This defines the pads a filter contains, and all the
  * callback functions used to interact with the filter.
@@ -398,6 +411,11 @@ typedef struct AVFilter {
     const AVFilterPad *inputs;  ///< NULL terminated list of inputs. NULL if none
     const AVFilterPad *outputs; ///< NULL terminated list of outputs. NULL if none
 
+    /**
+     * A combination of AVFILTER_FLAG_*
+     */
+    int flags;
+
     /*****************************************************************
      * All fields below this line are not part of the public API. They
      * may not be used outside of libavfilter and can be changed and
@@ -432,6 +450,48 @@ typedef struct AVFilter {
     int priv_size;      ///< size of private data to allocate for the filter
 } AVFilter;
 
+/**
+ * Process multiple parts of the frame concurrently.
+ */
+#define AVFILTER_THREAD_SLICE (1 << 0)
+
+/**
+ * Run each filter on its own thread, so that the filters of a chain work on
+ * different frames at the same time.
+ */
+#define AVFILTER_THREAD_FRAME (1 << 1)
+
+typedef struct AVFilterInternal AVFilterInternal;
+
+/**
+ * A function executed by an avfilter_execute_func, possibly concurrently
+ * with other calls to it.
+ *
+ * @param ctx     the filter context
+ * @param arg     the argument passed to the execute function
+ * @param jobnr   index of this job, in the range [0, nb_jobs)
+ * @param nb_jobs total number of jobs
+ * @return the value to store in the ret array of the execute function
+ */
+typedef int (avfilter_action_func)(AVFilterContext *ctx, void *arg, int jobnr,
+                                   int nb_jobs);
+
+/**
+ * A function executing multiple jobs, possibly in parallel. It returns once
+ * all the jobs have finished.
+ *
+ * @param ctx     the filter context the jobs belong to
+ * @param func    the function to call for each job
+ * @param arg     the argument passed to func
+ * @param ret     array of nb_jobs elements receiving the return values of
+ *                func, may be NULL
+ * @param nb_jobs the number of jobs
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+typedef int (avfilter_execute_func)(AVFilterContext *ctx,
+                                    avfilter_action_func *func, void *arg,
+                                    int *ret, int nb_jobs);
+
 /** An instance of a filter */
 struct AVFilterContext {
     const AVClass *av_class;              ///< needed for av_log()
@@ -455,6 +515,20 @@ struct AVFilterContext {
     unsigned    nb_outputs;         ///< number of output pads
 
     void *priv;                     ///< private data for use by the filter
+
+    struct AVFilterGraph *graph;    ///< filtergraph this filter belongs to
+
+    /**
+     * Type of multithreading used by this filter instance, a combination of
+     * AVFILTER_THREAD_* flags. Set by avfilter_graph_config() from the graph
+     * settings and the capabilities of the filter.
+     */
+    int thread_type;
+
+    /**
+     * An opaque struct for libavfilter internal use.
+     */
+    AVFilterInternal *internal;
 };
 
 /**
@@ -543,6 +617,14 @@ struct AVFilterLink {
 
     AVFilterBufferRef *cur_buf;
     AVFilterBufferRef *out_buf;
+
+    /**
+     * Pool of video buffers allocated by the default get_video_buffer()
+     * callback on this link, and the size of each of its buffers.
+     * Not part of the public API.
+     */
+    struct AVBufferPool *pool;
+    int pool_size;
 };
 
 /**
@@ -675,6 +757,56 @@ void avfilter_free(AVFilterContext *filter);
 int avfilter_insert_filter(AVFilterLink *link, AVFilterContext *filt,
                            unsigned filt_srcpad_idx, unsigned filt_dstpad_idx);
 
+/**
+ * The filter callbacks timed in AVFilterStats.
+ */
+enum AVFilterStatsCallback {
+    AVFILTER_STATS_START_FRAME,
+    AVFILTER_STATS_DRAW_SLICE,
+    AVFILTER_STATS_END_FRAME,
+    AVFILTER_STATS_FILTER_SAMPLES,
+    AVFILTER_STATS_REQUEST_FRAME,
+    AVFILTER_STATS_NB_CALLBACKS,
+};
+
+/**
+ * Statistics of a filter instance, collected when the filtergraph it belongs
+ * to has AVFilterGraph.collect_stats set.
+ *
+ * The time spent in a callback does not include the time spent in the
+ * callbacks of the other filters it calls, e.g. when a filter sends a frame
+ * to the next one from its end_frame().
+ */
+typedef struct AVFilterStats {
+    int64_t frames_in;      ///< video frames and audio buffers received on all inputs
+    int64_t frames_out;     ///< video frames and audio buffers sent on all outputs
+
+    int64_t calls    [AVFILTER_STATS_NB_CALLBACKS]; ///< number of calls of each callback
+    int64_t wall_time[AVFILTER_STATS_NB_CALLBACKS]; ///< wall clock time in each callback, in microseconds
+    /**
+     * CPU time of the calling thread in each callback, in microseconds, or
+     * -1 if the system has no per thread CPU clock. The time spent by the
+     * worker threads of slice threaded filters is not included.
+     */
+    int64_t cpu_time [AVFILTER_STATS_NB_CALLBACKS];
+
+    /**
+     * Frames currently buffered inside the filter and the highest value it
+     * reached. Only filters queueing frames, such as the buffer sources and
+     * fifo, report them, they are 0 for the other filters.
+     */
+    int queued;
+    int max_queued;
+} AVFilterStats;
+
+/**
+ * Get the statistics of a filter instance.
+ *
+ * @return the statistics, valid until the filter is freed, or NULL if they
+ * are not collected for this filter
+ */
+const AVFilterStats *avfilter_get_stats(AVFilterContext *filter);
+
 /**
  * Copy the frame properties of src to dst, without copying the actual
  * image data.
@@ -20,6 +20,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
 #include <ctype.h>
 #include <string.h>
 
@@ -27,15 +28,34 @@
 #include "avfiltergraph.h"
 #include "formats.h"
 #include "internal.h"
+#include "thread.h"
 
 #include "libavutil/audioconvert.h"
 #include "libavutil/avassert.h"
 #include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/internal.h"
 #include "libavutil/log.h"
+#include "libavutil/opt.h"
+
+#define OFFSET(x) offsetof(AVFilterGraph, x)
+#define F (AV_OPT_FLAG_AUDIO_PARAM | AV_OPT_FLAG_VIDEO_PARAM)
+static const AVOption filtergraph_options[] = {
+    { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
+        { .dbl = AVFILTER_THREAD_SLICE }, 0, INT_MAX, F, "thread_type" },
+        { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .dbl = AVFILTER_THREAD_SLICE }, .flags = F, .unit = "thread_type" },
+        { "frame", NULL, 0, AV_OPT_TYPE_CONST, { .dbl = AVFILTER_THREAD_FRAME }, .flags = F, .unit = "thread_type" },
+    { "threads",     "Maximum number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
+        { .dbl = 0 }, 0, INT_MAX, F },
+    { "stats",       "Collect per filter statistics", OFFSET(collect_stats), AV_OPT_TYPE_INT,
+        { .dbl = 0 }, 0, 1, F },
+    { NULL },
+};
 
 static const AVClass filtergraph_class = {
     .class_name = "AVFilterGraph",
     .item_name  = av_default_item_name,
+    .option     = filtergraph_options,
     .version    = LIBAVUTIL_VERSION_INT,
 };
 
@@ -45,6 +65,13 @@ AVFilterGraph *avfilter_graph_alloc(void)
     if (!ret)
         return NULL;
     ret->av_class = &filtergraph_class;
+    av_opt_set_defaults(ret);
+
+    ret->internal = av_mallocz(sizeof(*ret->internal));
+    if (!ret->internal) {
+        av_free(ret);
+        return NULL;
+    }
     return ret;
 }
 
@@ -52,8 +79,11 @@ void avfilter_graph_free(AVFilterGraph **graph)
 {
     if (!*graph)
         return;
+    ff_graph_frame_thread_free(*graph);
     for (; (*graph)->filter_count > 0; (*graph)->filter_count--)
         avfilter_free((*graph)->filters[(*graph)->filter_count - 1]);
+    ff_graph_thread_free(*graph);
+    av_freep(&(*graph)->internal);
     av_freep(&(*graph)->scale_sws_opts);
     av_freep(&(*graph)->filters);
     av_freep(graph);
@@ -68,6 +98,7 @@ int avfilter_graph_add_filter(AVFilterGraph *graph, AVFilterContext *filter)
 
     graph->filters = filters;
     graph->filters[graph->filter_count++] = filter;
+    filter->graph = graph;
 
     return 0;
 }
@@ -691,6 +722,80 @@ static int graph_insert_fifos(AVFilterGraph *graph, AVClass *log_ctx)
     return 0;
 }
 
+#if !HAVE_PTHREADS
+void ff_graph_thread_free(AVFilterGraph *graph)
+{
+}
+
+int ff_graph_thread_init(AVFilterGraph *graph)
+{
+    graph->nb_threads = 1;
+    return 0;
+}
+
+int ff_graph_frame_thread_init(AVFilterGraph *graph, AVClass *log_ctx)
+{
+    return 0;
+}
+
+int ff_graph_frame_thread_start(AVFilterGraph *graph)
+{
+    return 0;
+}
+
+void ff_graph_frame_thread_free(AVFilterGraph *graph)
+{
+}
+
+FFStatsNested *ff_frame_thread_stats_nested(AVFilterGraph *graph)
+{
+    return NULL;
+}
+#endif
+
+/**
+ * Select the number of threads and the threading type of each filter, and
+ * start the worker threads if needed.
+ */
+static int graph_config_threads(AVFilterGraph *graph, AVClass *log_ctx)
+{
+    avfilter_execute_func *execute = graph->execute;
+    int i, ret;
+
+    if (!graph->nb_threads)
+        graph->nb_threads = av_clip(av_cpu_count(), 1, FF_MAX_AUTO_THREADS);
+
+    if (!execute && graph->nb_threads > 1) {
+        if (!graph->internal->thread &&
+            (ret = ff_graph_thread_init(graph)) < 0)
+            return ret;
+        execute = graph->internal->thread_execute;
+    }
+    if (!execute)
+        graph->nb_threads = 1;
+
+    for (i = 0; i < graph->filter_count; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        filter->thread_type &= AVFILTER_THREAD_FRAME;
+        if (graph->nb_threads > 1 &&
+            filter->filter->flags & AVFILTER_FLAG_SLICE_THREADS)
+            filter->thread_type |= graph->thread_type & AVFILTER_THREAD_SLICE;
+        if (filter->thread_type & AVFILTER_THREAD_SLICE)
+            filter->internal->execute = execute;
+    }
+    av_log(log_ctx, AV_LOG_DEBUG, "using %d threads\n", graph->nb_threads);
+
+    return 0;
+}
+
+int ff_filter_get_nb_threads(AVFilterContext *ctx)
+{
+    if (ctx->thread_type & AVFILTER_THREAD_SLICE)
+        return ctx->graph->nb_threads;
+    return 1;
+}
+
 int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
 {
     int ret;
@@ -699,10 +804,16 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_insert_fifos(graphctx, log_ctx)) < 0)
         return ret;
+    if ((ret = ff_graph_frame_thread_init(graphctx, log_ctx)) < 0)
+        return ret;
     if ((ret = graph_config_formats(graphctx, log_ctx)))
         return ret;
+    if ((ret = graph_config_threads(graphctx, log_ctx)) < 0)
+        return ret;
     if ((ret = graph_config_links(graphctx, log_ctx)))
         return ret;
+    if ((ret = ff_graph_frame_thread_start(graphctx)) < 0)
+        return ret;
 
     return 0;
 }
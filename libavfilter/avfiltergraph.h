@@ -25,12 +25,73 @@
 #include "avfilter.h"
 #include "libavutil/log.h"
 
+typedef struct AVFilterGraphInternal AVFilterGraphInternal;
+
 typedef struct AVFilterGraph {
     const AVClass *av_class;
     unsigned filter_count;
     AVFilterContext **filters;
 
     char *scale_sws_opts; ///< sws options to use for the auto-inserted scale filters
+
+    /**
+     * Type of multithreading allowed for the filters in this graph, a
+     * combination of AVFILTER_THREAD_* flags. Only slice threading is allowed
+     * by default.
+     *
+     * With frame threading, the filters with the AVFILTER_FLAG_FRAME_THREADS
+     * capability run on their own threads when they are on a path of the
+     * graph that neither splits before them nor merges after them, so the
+     * output does not depend on the timing of the threads. Requesting a frame
+     * from the graph may then return AVERROR(EAGAIN) while the filters still
+     * work on earlier frames, in which case more input should be sent.
+     *
+     * May be set by the caller before avfilter_graph_config().
+     */
+    int thread_type;
+
+    /**
+     * Maximum number of threads used by each filter in this graph. 0 (the
+     * default) selects the number of CPUs.
+     *
+     * May be set by the caller before avfilter_graph_config(), which replaces
+     * it by the number of threads actually used.
+     */
+    int nb_threads;
+
+    /**
+     * Opaque object for libavfilter internal use.
+     */
+    AVFilterGraphInternal *internal;
+
+    /**
+     * Opaque user data. May be set by the caller to an arbitrary value, e.g. to
+     * be used from callbacks like @ref AVFilterGraph.execute.
+     * Libavfilter will not touch this field in any way.
+     */
+    void *opaque;
+
+    /**
+     * This callback may be set by the caller before avfilter_graph_config(),
+     * to provide a custom multithreading implementation, e.g. one sharing its
+     * threads with the decoders.
+     *
+     * If set, filters with slice threading capability will call this callback
+     * to execute multiple jobs in parallel, with up to nb_threads jobs at
+     * once. If NULL, libavfilter uses its own thread pool.
+     *
+     * @warning the jobs passed to this callback must all be run, and the
+     * callback must not return before they have all finished. With frame
+     * threading, it may be called from several threads at once.
+     */
+    avfilter_execute_func *execute;
+
+    /**
+     * Collect the statistics of the filters, see avfilter_get_stats().
+     *
+     * May be set by the caller before sending frames through the graph.
+     */
+    int collect_stats;
 } AVFilterGraph;
 
 /**
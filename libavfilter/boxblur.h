@@ -0,0 +1,62 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Libav; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_BOXBLUR_H
+#define AVFILTER_BOXBLUR_H
+
+#include <stdint.h>
+
+typedef struct {
+    int radius;
+    int power;
+} FilterParam;
+
+typedef struct {
+    FilterParam luma_param;
+    FilterParam chroma_param;
+    FilterParam alpha_param;
+    char luma_radius_expr  [256];
+    char chroma_radius_expr[256];
+    char alpha_radius_expr [256];
+
+    int hsub, vsub;
+    int radius[4];
+    int power[4];
+    uint8_t *temp[2]; ///< temporary buffers used in blur_power(), one line per job
+    int temp_size;    ///< size of one line of the temporary buffers
+    int nb_threads;
+
+    uint8_t *temp_plane[4];    ///< intermediate picture of the vertical pass
+    int temp_linesize[4];
+    uint16_t *sums;            ///< column sums of the vertical pass, one line per job
+
+    /**
+     * Advance the column sums of a box by one line and store the
+     * averages: sum[x] += add[x] - sub[x], dst[x] = sum[x] * inv >> 16
+     * rounded to nearest.
+     */
+    void (*vblur_line)(uint8_t *dst, uint16_t *sum, const uint8_t *add,
+                       const uint8_t *sub, int width, int inv);
+} BoxBlurContext;
+
+void ff_boxblur_init_x86(BoxBlurContext *boxblur);
+
+void ff_boxblur_vblur_line_c(uint8_t *dst, uint16_t *sum, const uint8_t *add,
+                             const uint8_t *sub, int width, int inv);
+
+#endif /* AVFILTER_BOXBLUR_H */
@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "libavutil/atomic.h"
 #include "libavutil/audioconvert.h"
 #include "libavutil/common.h"
 #include "libavcodec/avcodec.h"
@@ -23,7 +24,6 @@
 #include "avfilter.h"
 #include "internal.h"
 
-/* TODO: buffer pool.  see comment for avfilter_default_get_video_buffer() */
 void ff_avfilter_default_free_buffer(AVFilterBuffer *ptr)
 {
     if (ptr->extended_data != ptr->data)
@@ -68,7 +68,8 @@ AVFilterBufferRef *avfilter_ref_buffer(AVFilterBufferRef *ref, int pmask)
             ret->extended_data = ret->data;
     }
     ret->perms &= pmask;
-    ret->buf->refcount ++;
+    /* the references may be held by filters running on different threads */
+    avpriv_atomic_int_add_and_fetch((volatile int *)&ret->buf->refcount, 1);
     return ret;
 }
 
@@ -76,7 +77,7 @@ void avfilter_unref_buffer(AVFilterBufferRef *ref)
 {
     if (!ref)
         return;
-    if (!(--ref->buf->refcount))
+    if (!avpriv_atomic_int_add_and_fetch((volatile int *)&ref->buf->refcount, -1))
         ref->buf->free(ref->buf);
     if (ref->extended_data != ref->data)
         av_freep(&ref->extended_data);
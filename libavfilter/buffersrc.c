@@ -122,6 +122,7 @@ int av_buffersrc_write_frame(AVFilterContext *buffer_filter, AVFrame *frame)
         avfilter_unref_buffer(buf);
         return ret;
     }
+    ff_stats_set_queued(buffer_filter, av_fifo_size(c->fifo) / sizeof(buf));
 
     return 0;
 }
@@ -156,6 +157,7 @@ int av_buffersrc_buffer(AVFilterContext *s, AVFilterBufferRef *buf)
 
     if ((ret = av_fifo_generic_write(c->fifo, &buf, sizeof(buf), NULL)) < 0)
         return ret;
+    ff_stats_set_queued(s, av_fifo_size(c->fifo) / sizeof(buf));
 
     return 0;
 }
@@ -327,6 +329,7 @@ static int request_frame(AVFilterLink *link)
         return AVERROR(EAGAIN);
     }
     av_fifo_generic_read(c->fifo, &buf, sizeof(buf), NULL);
+    ff_stats_set_queued(link->src, av_fifo_size(c->fifo) / sizeof(buf));
 
     switch (link->type) {
     case AVMEDIA_TYPE_VIDEO:
@@ -42,6 +42,7 @@ typedef struct Buf {
 typedef struct {
     Buf  root;
     Buf *last;   ///< last buffered frame
+    int nb_queued;
 
     /**
      * When a specific number of output samples is requested, the partial
@@ -86,17 +87,19 @@ static int add_to_queue(AVFilterLink *inlink, AVFilterBufferRef *buf)
 
     fifo->last = fifo->last->next;
     fifo->last->buf = buf;
+    ff_stats_set_queued(inlink->dst, ++fifo->nb_queued);
 
     return 0;
 }
 
-static void queue_pop(FifoContext *s)
+static void queue_pop(AVFilterContext *ctx, FifoContext *s)
 {
     Buf *tmp = s->root.next->next;
     if (s->last == s->root.next)
         s->last = &s->root;
     av_freep(&s->root.next);
     s->root.next = tmp;
+    ff_stats_set_queued(ctx, --s->nb_queued);
 }
 
 static int end_frame(AVFilterLink *inlink)
@@ -167,7 +170,7 @@ static int return_audio_frame(AVFilterContext *ctx)
         calc_ptr_alignment(head) >= 32) {
         if (head->audio->nb_samples == link->request_samples) {
             buf_out = head;
-            queue_pop(s);
+            queue_pop(ctx, s);
         } else {
             buf_out = avfilter_ref_buffer(head, AV_PERM_READ);
             if (!buf_out)
@@ -205,7 +208,7 @@ static int return_audio_frame(AVFilterContext *ctx)
 
             if (len == head->audio->nb_samples) {
                 avfilter_unref_buffer(head);
-                queue_pop(s);
+                queue_pop(ctx, s);
 
                 if (!s->root.next &&
                     (ret = ff_request_frame(ctx->inputs[0])) < 0) {
@@ -250,14 +253,14 @@ static int request_frame(AVFilterLink *outlink)
             (ret = ff_end_frame(outlink)) < 0)
             return ret;
 
-        queue_pop(fifo);
+        queue_pop(outlink->src, fifo);
         break;
     case AVMEDIA_TYPE_AUDIO:
         if (outlink->request_samples) {
             return return_audio_frame(outlink->src);
         } else {
             ret = ff_filter_samples(outlink, fifo->root.next->buf);
-            queue_pop(fifo);
+            queue_pop(outlink->src, fifo);
         }
         break;
     default:
@@ -171,6 +171,72 @@ struct AVFilterPad {
 };
 #endif
 
+/**
+ * Wall clock and CPU time spent so far in the callbacks called from the
+ * callback currently timed, subtracted from its own time.
+ */
+typedef struct FFStatsNested {
+    int64_t wall;
+    int64_t cpu;
+} FFStatsNested;
+
+struct AVFilterGraphInternal {
+    void *thread;
+    avfilter_execute_func *thread_execute;
+
+    void *frame_thread;
+
+    /**
+     * Statistics nesting of the thread calling the graph, the frame threads
+     * have their own.
+     */
+    FFStatsNested stats_nested;
+};
+
+struct AVFilterInternal {
+    avfilter_execute_func *execute;
+    AVFilterStats stats;
+};
+
+typedef struct FFStatsTimer {
+    int64_t wall, cpu;
+    int64_t nested_wall, nested_cpu;
+} FFStatsTimer;
+
+/**
+ * Start timing a callback of a filter.
+ *
+ * @return nonzero if the filtergraph collects statistics, in which case
+ * ff_stats_stop() must be called once the callback returns
+ */
+int ff_stats_start(AVFilterContext *ctx, FFStatsTimer *t);
+
+/**
+ * Account the time elapsed since ff_stats_start() to the callback cb of
+ * the filter.
+ */
+void ff_stats_stop(AVFilterContext *ctx, enum AVFilterStatsCallback cb,
+                   FFStatsTimer *t);
+
+/**
+ * Count a frame sent on a link, in the statistics of both filters.
+ */
+void ff_stats_count_frame(AVFilterLink *link);
+
+/**
+ * Report the number of frames buffered inside a filter, for the filters
+ * queueing frames.
+ */
+void ff_stats_set_queued(AVFilterContext *ctx, int nb_queued);
+
+/**
+ * Get the number of jobs a slice threaded filter should split its work into.
+ *
+ * @return the number of threads of the filter graph if slice threading is
+ * used by this filter instance, 1 otherwise
+ */
+int ff_filter_get_nb_threads(AVFilterContext *ctx);
+
 /** default handler for freeing audio/video buffer when there are no references left */
 void ff_avfilter_default_free_buffer(AVFilterBuffer *buf);
 
@@ -0,0 +1,56 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_OVERLAY_H
+#define AVFILTER_OVERLAY_H
+
+#include "avfilter.h"
+
+typedef struct {
+    int x, y;                   ///< position of overlayed picture
+
+    AVFilterBufferRef *overpicref;
+
+    int max_plane_step[4];      ///< steps per pixel for each plane
+    int hsub, vsub;             ///< chroma subsampling values
+
+    char x_expr[256], y_expr[256];
+
+    /**
+     * Blend a row of pixels, each with its own alpha value.
+     */
+    void (*blend_row)(uint8_t *dst, const uint8_t *src, const uint8_t *alpha,
+                      int width);
+    /**
+     * Blend a row of 4:2:0 chroma pixels, the alpha of each pixel is the
+     * average of a 2x2 block of the alpha plane starting at alpha[2 * x].
+     */
+    void (*blend_row_yuv420)(uint8_t *dst, const uint8_t *src,
+                             const uint8_t *alpha, int alpha_linesize,
+                             int width);
+} OverlayContext;
+
+void ff_overlay_init_x86(OverlayContext *over);
+
+void ff_overlay_blend_row_c(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *alpha, int width);
+void ff_overlay_blend_row_yuv420_c(uint8_t *dst, const uint8_t *src,
+                                   const uint8_t *alpha, int alpha_linesize,
+                                   int width);
+
+#endif /* AVFILTER_OVERLAY_H */
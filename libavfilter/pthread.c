@@ -0,0 +1,649 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Slice and frame threading for the filters of a graph
+ */
+
+#include <pthread.h>
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/fifo.h"
+#include "libavutil/mem.h"
+
+#include "audio.h"
+#include "avfilter.h"
+#include "avfiltergraph.h"
+#include "internal.h"
+#include "thread.h"
+#include "video.h"
+
+typedef struct ThreadContext {
+    pthread_t *workers;
+    int nb_workers;                 ///< threads besides the one calling execute
+
+    AVFilterContext *ctx;
+    avfilter_action_func *func;
+    void *arg;
+    int *rets;
+    int nb_jobs;
+    int next_job;                   ///< index of the next job to be started
+
+    pthread_mutex_t execute_lock;   ///< held by the thread using the workers
+    pthread_mutex_t lock;
+    pthread_cond_t  work_cond;      ///< signalled when new jobs are queued
+    pthread_cond_t  done_cond;      ///< signalled when the last worker is done
+    int generation;                 ///< incremented for each execute() call
+    int nb_busy;                    ///< workers not done with this generation
+    int done;
+} ThreadContext;
+
+/* run queued jobs until there are none left, called with the lock held */
+static void run_jobs(ThreadContext *c)
+{
+    while (c->next_job < c->nb_jobs) {
+        int jobnr = c->next_job++;
+        int ret;
+
+        pthread_mutex_unlock(&c->lock);
+        ret = c->func(c->ctx, c->arg, jobnr, c->nb_jobs);
+        pthread_mutex_lock(&c->lock);
+        if (c->rets)
+            c->rets[jobnr] = ret;
+    }
+}
+
+static void *worker(void *arg)
+{
+    ThreadContext *c = arg;
+    int generation = 0;
+
+    pthread_mutex_lock(&c->lock);
+    for (;;) {
+        while (c->generation == generation && !c->done)
+            pthread_cond_wait(&c->work_cond, &c->lock);
+        if (c->done)
+            break;
+        generation = c->generation;
+
+        run_jobs(c);
+
+        if (!--c->nb_busy)
+            pthread_cond_signal(&c->done_cond);
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    return NULL;
+}
+
+static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                          void *arg, int *ret, int nb_jobs)
+{
+    ThreadContext *c = ctx->graph->internal->thread;
+    int i;
+
+    if (nb_jobs <= 0)
+        return 0;
+    /* with frame threading, the filters of several threads may try to use
+     * the workers at once; the late ones run their jobs by themselves */
+    if (nb_jobs == 1 || pthread_mutex_trylock(&c->execute_lock)) {
+        for (i = 0; i < nb_jobs; i++) {
+            int r = func(ctx, arg, i, nb_jobs);
+            if (ret)
+                ret[i] = r;
+        }
+        return 0;
+    }
+
+    pthread_mutex_lock(&c->lock);
+    c->ctx      = ctx;
+    c->func     = func;
+    c->arg      = arg;
+    c->rets     = ret;
+    c->nb_jobs  = nb_jobs;
+    c->next_job = 0;
+    c->nb_busy  = c->nb_workers;
+    c->generation++;
+    pthread_cond_broadcast(&c->work_cond);
+
+    run_jobs(c);
+
+    while (c->nb_busy)
+        pthread_cond_wait(&c->done_cond, &c->lock);
+    pthread_mutex_unlock(&c->lock);
+    pthread_mutex_unlock(&c->execute_lock);
+
+    return 0;
+}
+
+void ff_graph_thread_free(AVFilterGraph *graph)
+{
+    ThreadContext *c = graph->internal->thread;
+    int i;
+
+    if (!c)
+        return;
+
+    pthread_mutex_lock(&c->lock);
+    c->done = 1;
+    pthread_cond_broadcast(&c->work_cond);
+    pthread_mutex_unlock(&c->lock);
+
+    for (i = 0; i < c->nb_workers; i++)
+        pthread_join(c->workers[i], NULL);
+
+    pthread_mutex_destroy(&c->execute_lock);
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->work_cond);
+    pthread_cond_destroy(&c->done_cond);
+    av_free(c->workers);
+    av_freep(&graph->internal->thread);
+    graph->internal->thread_execute = NULL;
+}
+
+int ff_graph_thread_init(AVFilterGraph *graph)
+{
+    ThreadContext *c;
+    int i;
+
+    if (graph->nb_threads <= 1)
+        return 0;
+
+    c = av_mallocz(sizeof(*c));
+    if (!c)
+        return AVERROR(ENOMEM);
+    c->workers = av_mallocz(sizeof(*c->workers) * (graph->nb_threads - 1));
+    if (!c->workers) {
+        av_free(c);
+        return AVERROR(ENOMEM);
+    }
+
+    pthread_mutex_init(&c->execute_lock, NULL);
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->work_cond, NULL);
+    pthread_cond_init(&c->done_cond, NULL);
+    graph->internal->thread = c;
+
+    for (i = 0; i < graph->nb_threads - 1; i++) {
+        if (pthread_create(&c->workers[i], NULL, worker, c))
+            break;
+        c->nb_workers++;
+    }
+    if (!c->nb_workers) {
+        ff_graph_thread_free(graph);
+        graph->nb_threads = 1;
+        return 0;
+    }
+
+    graph->nb_threads               = c->nb_workers + 1;
+    graph->internal->thread_execute = thread_execute;
+
+    return 0;
+}
+
+/**
+ * Number of frames the filters feeding a queue may output ahead of the
+ * filters reading it.
+ */
+#define MAX_QUEUED_FRAMES 4
+
+typedef struct FrameThreadContext {
+    pthread_mutex_t lock;           ///< protects the queues of the graph
+    pthread_cond_t  cond;           ///< signalled when a queue changes
+    pthread_key_t   stats_key;      ///< statistics nesting of each thread
+    int done;                       ///< set to stop the threads
+} FrameThreadContext;
+
+typedef struct QueueContext {
+    AVFifoBuffer *fifo;             ///< queued buffer references
+    int status;                     ///< error or EOF met when feeding the queue
+
+    int threaded_input;             ///< the queue is fed by its own thread
+    int threaded_output;            ///< the queue is read by a frame thread
+
+    /**
+     * For the queues read by the thread calling the graph, the queue this
+     * thread fills while waiting for frames to be filtered.
+     */
+    AVFilterContext *feed;
+
+    pthread_t thread;
+    int thread_started;
+    FFStatsNested stats_nested;
+} QueueContext;
+
+static int nb_queued(QueueContext *s)
+{
+    return av_fifo_size(s->fifo) / sizeof(AVFilterBufferRef*);
+}
+
+static av_cold int queue_init(AVFilterContext *ctx, const char *args)
+{
+    QueueContext *s = ctx->priv;
+
+    if (!(s->fifo = av_fifo_alloc(MAX_QUEUED_FRAMES * sizeof(AVFilterBufferRef*))))
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static av_cold void queue_uninit(AVFilterContext *ctx)
+{
+    QueueContext *s = ctx->priv;
+    AVFilterBufferRef *buf;
+
+    while (s->fifo && av_fifo_size(s->fifo)) {
+        av_fifo_generic_read(s->fifo, &buf, sizeof(buf), NULL);
+        avfilter_unref_buffer(buf);
+    }
+    av_fifo_free(s->fifo);
+    s->fifo = NULL;
+}
+
+static int queue_add(AVFilterLink *inlink, AVFilterBufferRef *buf)
+{
+    AVFilterContext *ctx = inlink->dst;
+    FrameThreadContext *c = ctx->graph->internal->frame_thread;
+    QueueContext *s = ctx->priv;
+    int ret = 0;
+
+    pthread_mutex_lock(&c->lock);
+    if (!av_fifo_space(s->fifo))
+        ret = av_fifo_realloc2(s->fifo, av_fifo_size(s->fifo) + sizeof(buf));
+    if (ret >= 0) {
+        av_fifo_generic_write(s->fifo, &buf, sizeof(buf), NULL);
+        ff_stats_set_queued(ctx, nb_queued(s));
+        pthread_cond_broadcast(&c->cond);
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    if (ret < 0)
+        avfilter_unref_buffer(buf);
+    return ret;
+}
+
+static int queue_start_frame(AVFilterLink *inlink, AVFilterBufferRef *buf)
+{
+    return 0;
+}
+
+static int queue_draw_slice(AVFilterLink *inlink, int y, int h, int slice_dir)
+{
+    return 0;
+}
+
+/* the frame is only queued once complete, the filters reading it may not
+ * wait for its slices */
+static int queue_end_frame(AVFilterLink *inlink)
+{
+    AVFilterBufferRef *buf = inlink->cur_buf;
+
+    inlink->cur_buf = NULL;
+    return queue_add(inlink, buf);
+}
+
+static int queue_request_frame(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    FrameThreadContext *c = ctx->graph->internal->frame_thread;
+    QueueContext *s = ctx->priv;
+    AVFilterBufferRef *buf = NULL;
+    int ret = 0, eagain = 0;
+
+    pthread_mutex_lock(&c->lock);
+    for (;;) {
+        if (nb_queued(s)) {
+            av_fifo_generic_read(s->fifo, &buf, sizeof(buf), NULL);
+            ff_stats_set_queued(ctx, nb_queued(s));
+            pthread_cond_broadcast(&c->cond);
+            break;
+        }
+        if (s->status) {
+            ret = s->status;
+            break;
+        }
+        if (c->done) {
+            ret = AVERROR_EXIT;
+            break;
+        }
+        if (eagain) {
+            ret = AVERROR(EAGAIN);
+            break;
+        }
+
+        /* The thread calling the graph feeds the frame threads while they
+         * work. Its caller must send more input if the filters feeding them
+         * have none left, otherwise the frames are waited for. */
+        if (!s->threaded_output) {
+            QueueContext *feed = s->feed->priv;
+
+            if (!feed->status && nb_queued(feed) < MAX_QUEUED_FRAMES) {
+                pthread_mutex_unlock(&c->lock);
+                ret = ff_request_frame(s->feed->inputs[0]);
+                pthread_mutex_lock(&c->lock);
+
+                if (ret == AVERROR(EAGAIN)) {
+                    eagain = 1;
+                } else if (ret < 0) {
+                    feed->status = ret;
+                    pthread_cond_broadcast(&c->cond);
+                }
+                continue;
+            }
+        }
+        pthread_cond_wait(&c->cond, &c->lock);
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    if (!buf)
+        return ret;
+
+    if (outlink->type == AVMEDIA_TYPE_VIDEO) {
+        if ((ret = ff_start_frame(outlink, buf)) < 0 ||
+            (ret = ff_draw_slice(outlink, 0, outlink->h, 1)) < 0 ||
+            (ret = ff_end_frame(outlink)) < 0)
+            return ret;
+        return 0;
+    }
+    return ff_filter_samples(outlink, buf);
+}
+
+static int queue_poll_frame(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    FrameThreadContext *c = ctx->graph->internal->frame_thread;
+    QueueContext *s = ctx->priv;
+    int ret;
+
+    pthread_mutex_lock(&c->lock);
+    ret = nb_queued(s);
+    if (!ret && s->status == AVERROR_EOF)
+        ret = AVERROR_EOF;
+    pthread_mutex_unlock(&c->lock);
+
+    return ret;
+}
+
+static AVFilter video_queue = {
+    .name        = "framequeue",
+    .description = NULL_IF_CONFIG_SMALL("Pass frames between the threads of a graph."),
+
+    .init        = queue_init,
+    .uninit      = queue_uninit,
+
+    .priv_size   = sizeof(QueueContext),
+
+    .inputs      = (const AVFilterPad[]) {{ .name             = "default",
+                                            .type             = AVMEDIA_TYPE_VIDEO,
+                                            .start_frame      = queue_start_frame,
+                                            .draw_slice       = queue_draw_slice,
+                                            .end_frame        = queue_end_frame,
+                                            .rej_perms        = AV_PERM_REUSE2, },
+                                          { .name = NULL}},
+    .outputs     = (const AVFilterPad[]) {{ .name             = "default",
+                                            .type             = AVMEDIA_TYPE_VIDEO,
+                                            .request_frame    = queue_request_frame,
+                                            .poll_frame       = queue_poll_frame, },
+                                          { .name = NULL}},
+};
+
+static AVFilter audio_queue = {
+    .name        = "aframequeue",
+    .description = NULL_IF_CONFIG_SMALL("Pass frames between the threads of a graph."),
+
+    .init        = queue_init,
+    .uninit      = queue_uninit,
+
+    .priv_size   = sizeof(QueueContext),
+
+    .inputs      = (const AVFilterPad[]) {{ .name             = "default",
+                                            .type             = AVMEDIA_TYPE_AUDIO,
+                                            .filter_samples   = queue_add,
+                                            .rej_perms        = AV_PERM_REUSE2, },
+                                          { .name = NULL}},
+    .outputs     = (const AVFilterPad[]) {{ .name             = "default",
+                                            .type             = AVMEDIA_TYPE_AUDIO,
+                                            .request_frame    = queue_request_frame,
+                                            .poll_frame       = queue_poll_frame, },
+                                          { .name = NULL}},
+};
+
+static int is_queue(AVFilterContext *f)
+{
+    return f->filter == &video_queue || f->filter == &audio_queue;
+}
+
+/* the frames reaching the filter do not depend on other branches */
+static int single_path_up(AVFilterContext *f)
+{
+    int i;
+
+    for (i = 0; i < f->nb_inputs; i++) {
+        AVFilterContext *src = f->inputs[i]->src;
+        if (src->nb_outputs != 1 || !single_path_up(src))
+            return 0;
+    }
+    return 1;
+}
+
+/* the frames output by the filter do not meet those of other branches */
+static int single_path_down(AVFilterContext *f)
+{
+    int i;
+
+    for (i = 0; i < f->nb_outputs; i++) {
+        AVFilterContext *dst = f->outputs[i]->dst;
+        if (dst->nb_inputs != 1 || !single_path_down(dst))
+            return 0;
+    }
+    return 1;
+}
+
+static int insert_queue(AVFilterGraph *graph, AVFilterLink *link, int *count)
+{
+    AVFilterContext *queue;
+    char name[32];
+    int ret;
+
+    snprintf(name, sizeof(name), "auto-inserted queue %d", (*count)++);
+
+    ret = avfilter_graph_create_filter(&queue,
+                                       link->type == AVMEDIA_TYPE_VIDEO ?
+                                       &video_queue : &audio_queue,
+                                       name, NULL, NULL, graph);
+    if (ret < 0)
+        return ret;
+
+    return avfilter_insert_filter(link, queue, 0, 0);
+}
+
+int ff_graph_frame_thread_init(AVFilterGraph *graph, AVClass *log_ctx)
+{
+    int nb_threads = graph->nb_threads ? graph->nb_threads : av_cpu_count();
+    int i, ret, count = 0;
+
+    if (!(graph->thread_type & AVFILTER_THREAD_FRAME) || nb_threads <= 1)
+        return 0;
+
+    for (i = 0; i < graph->filter_count; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        if (!(f->filter->flags & AVFILTER_FLAG_FRAME_THREADS) ||
+            f->nb_inputs != 1 || f->nb_outputs != 1 ||
+            !single_path_up(f) || !single_path_down(f))
+            continue;
+
+        if (!is_queue(f->inputs[0]->src) &&
+            (ret = insert_queue(graph, f->inputs[0], &count)) < 0)
+            return ret;
+        if (!is_queue(f->outputs[0]->dst) &&
+            (ret = insert_queue(graph, f->outputs[0], &count)) < 0)
+            return ret;
+
+        f->thread_type |= AVFILTER_THREAD_FRAME;
+        av_log(log_ctx, AV_LOG_DEBUG, "running %s on its own thread\n",
+               f->name);
+    }
+
+    return 0;
+}
+
+/* the conversion filters inserted after the queues run on the thread of the
+ * filter they were inserted for */
+static AVFilterContext *queue_before(AVFilterContext *f)
+{
+    while (!is_queue(f->inputs[0]->src))
+        f = f->inputs[0]->src;
+    return f->inputs[0]->src;
+}
+
+static AVFilterContext *queue_after(AVFilterContext *f)
+{
+    while (!is_queue(f->outputs[0]->dst))
+        f = f->outputs[0]->dst;
+    return f->outputs[0]->dst;
+}
+
+static void *frame_worker(void *arg)
+{
+    AVFilterContext *ctx = arg;
+    FrameThreadContext *c = ctx->graph->internal->frame_thread;
+    QueueContext *s = ctx->priv;
+    int ret;
+
+    pthread_setspecific(c->stats_key, &s->stats_nested);
+
+    pthread_mutex_lock(&c->lock);
+    for (;;) {
+        while (!c->done && (s->status || nb_queued(s) >= MAX_QUEUED_FRAMES))
+            pthread_cond_wait(&c->cond, &c->lock);
+        if (c->done)
+            break;
+        pthread_mutex_unlock(&c->lock);
+
+        ret = ff_request_frame(ctx->inputs[0]);
+
+        pthread_mutex_lock(&c->lock);
+        if (ret < 0) {
+            s->status = ret;
+            pthread_cond_broadcast(&c->cond);
+        }
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    return NULL;
+}
+
+int ff_graph_frame_thread_start(AVFilterGraph *graph)
+{
+    FrameThreadContext *c;
+    int i, ret;
+
+    for (i = 0; i < graph->filter_count; i++)
+        if (is_queue(graph->filters[i]))
+            break;
+    if (i == graph->filter_count)
+        return 0;
+
+    c = av_mallocz(sizeof(*c));
+    if (!c)
+        return AVERROR(ENOMEM);
+    if ((ret = pthread_key_create(&c->stats_key, NULL))) {
+        av_free(c);
+        return AVERROR(ret);
+    }
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->cond, NULL);
+    graph->internal->frame_thread = c;
+
+    for (i = 0; i < graph->filter_count; i++) {
+        AVFilterContext *f = graph->filters[i];
+        QueueContext *in, *out;
+
+        if (!(f->thread_type & AVFILTER_THREAD_FRAME))
+            continue;
+        in  = queue_before(f)->priv;
+        out = queue_after(f)->priv;
+        in->threaded_output = 1;
+        out->threaded_input = 1;
+    }
+
+    for (i = 0; i < graph->filter_count; i++) {
+        AVFilterContext *f = graph->filters[i];
+        QueueContext *s = f->priv;
+
+        if (!is_queue(f) || s->threaded_output)
+            continue;
+        s->feed = f;
+        while (((QueueContext*)s->feed->priv)->threaded_input)
+            s->feed = queue_before(s->feed);
+    }
+
+    for (i = 0; i < graph->filter_count; i++) {
+        AVFilterContext *f = graph->filters[i];
+        QueueContext *s = f->priv;
+
+        if (!is_queue(f) || !s->threaded_input)
+            continue;
+        if ((ret = pthread_create(&s->thread, NULL, frame_worker, f))) {
+            ff_graph_frame_thread_free(graph);
+            return AVERROR(ret);
+        }
+        s->thread_started = 1;
+    }
+
+    return 0;
+}
+
+void ff_graph_frame_thread_free(AVFilterGraph *graph)
+{
+    FrameThreadContext *c = graph->internal->frame_thread;
+    int i;
+
+    if (!c)
+        return;
+
+    pthread_mutex_lock(&c->lock);
+    c->done = 1;
+    pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+
+    for (i = 0; i < graph->filter_count; i++) {
+        AVFilterContext *f = graph->filters[i];
+        QueueContext *s = f->priv;
+
+        if (is_queue(f) && s->thread_started) {
+            pthread_join(s->thread, NULL);
+            s->thread_started = 0;
+        }
+    }
+
+    pthread_key_delete(c->stats_key);
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->cond);
+    av_freep(&graph->internal->frame_thread);
+}
+
+FFStatsNested *ff_frame_thread_stats_nested(AVFilterGraph *graph)
+{
+    FrameThreadContext *c = graph->internal->frame_thread;
+
+    return c ? pthread_getspecific(c->stats_key) : NULL;
+}
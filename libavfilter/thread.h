@@ -0,0 +1,60 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_THREAD_H
+#define AVFILTER_THREAD_H
+
+#include "avfiltergraph.h"
+#include "internal.h"
+
+/**
+ * Start the worker threads of a graph and set its thread_execute callback.
+ * Updates nb_threads to the number of threads actually available.
+ */
+int ff_graph_thread_init(AVFilterGraph *graph);
+
+void ff_graph_thread_free(AVFilterGraph *graph);
+
+/**
+ * Select the filters of a graph which run on their own threads, and insert
+ * the queues passing the frames between the threads on their links. Must be
+ * called before the formats are negotiated.
+ */
+int ff_graph_frame_thread_init(AVFilterGraph *graph, AVClass *log_ctx);
+
+/**
+ * Start the threads of the filters selected by ff_graph_frame_thread_init(),
+ * once the links are configured.
+ */
+int ff_graph_frame_thread_start(AVFilterGraph *graph);
+
+/**
+ * Stop the threads started by ff_graph_frame_thread_start(). Must be called
+ * before the filters are freed.
+ */
+void ff_graph_frame_thread_free(AVFilterGraph *graph);
+
+/**
+ * Get the time spent in the nested callbacks of the statistics of the
+ * calling thread, if it is a frame thread of the graph.
+ *
+ * @return NULL if called from another thread
+ */
+FFStatsNested *ff_frame_thread_stats_nested(AVFilterGraph *graph);
+
+#endif /* AVFILTER_THREAD_H */
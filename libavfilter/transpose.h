@@ -0,0 +1,59 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_TRANSPOSE_H
+#define AVFILTER_TRANSPOSE_H
+
+#include <stdint.h>
+
+typedef struct TransVtable {
+    /**
+     * Transpose a block of 8x8 pixels, row y of dst is taken from
+     * column y of src.
+     */
+    void (*transpose_8x8)(uint8_t *src, int src_linesize,
+                          uint8_t *dst, int dst_linesize);
+    /**
+     * Transpose a block of any size, w and h are the dimensions of the
+     * destination block.
+     */
+    void (*transpose_block)(uint8_t *src, int src_linesize,
+                            uint8_t *dst, int dst_linesize,
+                            int w, int h);
+} TransVtable;
+
+typedef struct {
+    int hsub, vsub;
+    int pixsteps[4];
+
+    /* 0    Rotate by 90 degrees counterclockwise and vflip. */
+    /* 1    Rotate by 90 degrees clockwise.                  */
+    /* 2    Rotate by 90 degrees counterclockwise.           */
+    /* 3    Rotate by 90 degrees clockwise and vflip.        */
+    int dir;
+
+    TransVtable vtables[4];     ///< block functions for each plane
+} TransContext;
+
+/**
+ * Set the functions of vtable to the fastest available version for
+ * pixels of pixstep bytes, the C versions are already set.
+ */
+void ff_transpose_init_x86(TransVtable *v, int pixstep);
+
+#endif /* AVFILTER_TRANSPOSE_H */
@@ -0,0 +1,63 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_UNSHARP_H
+#define AVFILTER_UNSHARP_H
+
+#include <stdint.h>
+
+typedef struct FilterParam {
+    int msize_x;                             ///< matrix width
+    int msize_y;                             ///< matrix height
+    int amount;                              ///< effect amount
+    int steps_x;                             ///< horizontal step count
+    int steps_y;                             ///< vertical step count
+    int scalebits;                           ///< bits to shift pixel
+    int32_t halfscale;                       ///< amount to add to pixel
+    /**
+     * finite state machine storage, 2 * steps_y lines per job followed by
+     * one line holding the output of the horizontal pass
+     */
+    uint32_t **sc;
+} FilterParam;
+
+typedef struct {
+    FilterParam luma;   ///< luma parameters (width, height, amount)
+    FilterParam chroma; ///< chroma parameters (width, height, amount)
+    int hsub, vsub;
+    int nb_threads;     ///< number of jobs the state machines are allocated for
+
+    /**
+     * Run a line through two stages of the vertical state machine, line[x]
+     * is the input of the first stage and receives the output of the second.
+     */
+    void (*vsum_line)(uint32_t *line, uint32_t *sc0, uint32_t *sc1, int width);
+    /**
+     * Mix the source pixels with the blurred line according to fp->amount.
+     */
+    void (*blend_line)(uint8_t *dst, const uint8_t *src, const uint32_t *line,
+                       int width, const FilterParam *fp);
+} UnsharpContext;
+
+void ff_unsharp_init_x86(UnsharpContext *unsharp);
+
+void ff_unsharp_vsum_line_c(uint32_t *line, uint32_t *sc0, uint32_t *sc1, int width);
+void ff_unsharp_blend_line_c(uint8_t *dst, const uint8_t *src, const uint32_t *line,
+                             int width, const FilterParam *fp);
+
+#endif /* AVFILTER_UNSHARP_H */
@@ -30,6 +30,7 @@
 #include "libavutil/eval.h"
 #include "libavutil/pixdesc.h"
 #include "avfilter.h"
+#include "boxblur.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
@@ -54,25 +55,6 @@ enum var_name {
     VARS_NB
 };
 
-typedef struct {
-    int radius;
-    int power;
-} FilterParam;
-
-typedef struct {
-    FilterParam luma_param;
-    FilterParam chroma_param;
-    FilterParam alpha_param;
-    char luma_radius_expr  [256];
-    char chroma_radius_expr[256];
-    char alpha_radius_expr [256];
-
-    int hsub, vsub;
-    int radius[4];
-    int power[4];
-    uint8_t *temp[2]; ///< temporary buffer used in blur_power()
-} BoxBlurContext;
-
 #define Y 0
 #define U 1
 #define V 2
@@ -120,6 +102,11 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_freep(&boxblur->temp[0]);
     av_freep(&boxblur->temp[1]);
+    av_freep(&boxblur->temp_plane[0]);
+    av_freep(&boxblur->temp_plane[1]);
+    av_freep(&boxblur->temp_plane[2]);
+    av_freep(&boxblur->temp_plane[3]);
+    av_freep(&boxblur->sums);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -146,17 +133,38 @@ static int config_input(AVFilterLink *inlink)
     int cw, ch;
     double var_values[VARS_NB], res;
     char *expr;
-    int ret;
+    int ret, i;
+
+    boxblur->nb_threads = ff_filter_get_nb_threads(ctx);
+    boxblur->temp_size  = FFMAX(w, h);
 
     av_freep(&boxblur->temp[0]);
     av_freep(&boxblur->temp[1]);
-    if (!(boxblur->temp[0] = av_malloc(FFMAX(w, h))))
+    if (!(boxblur->temp[0] = av_malloc(boxblur->temp_size * boxblur->nb_threads)))
        return AVERROR(ENOMEM);
-    if (!(boxblur->temp[1] = av_malloc(FFMAX(w, h)))) {
+    if (!(boxblur->temp[1] = av_malloc(boxblur->temp_size * boxblur->nb_threads))) {
         av_freep(&boxblur->temp[0]);
         return AVERROR(ENOMEM);
     }
 
+    for (i = 0; i < 4; i++) {
+        int pw = i == U || i == V ? -((-w) >> desc->log2_chroma_w) : w;
+        int ph = i == U || i == V ? -((-h) >> desc->log2_chroma_h) : h;
+
+        av_freep(&boxblur->temp_plane[i]);
+        boxblur->temp_linesize[i] = FFALIGN(pw, 16);
+        if (!(boxblur->temp_plane[i] = av_malloc(boxblur->temp_linesize[i] * ph)))
+            return AVERROR(ENOMEM);
+    }
+    av_freep(&boxblur->sums);
+    if (!(boxblur->sums = av_malloc(FFALIGN(w, 16) * boxblur->nb_threads *
+                                    sizeof(*boxblur->sums))))
+        return AVERROR(ENOMEM);
+
+    boxblur->vblur_line = ff_boxblur_vblur_line_c;
+    if (HAVE_MMX)
+        ff_boxblur_init_x86(boxblur);
+
     boxblur->hsub = desc->log2_chroma_w;
     boxblur->vsub = desc->log2_chroma_h;
 
@@ -282,54 +290,169 @@ static inline void blur_power(uint8_t *dst, int dst_step, const uint8_t *src, in
 }
 
 static void hblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
-                  int w, int h, int radius, int power, uint8_t *temp[2])
+                  int w, int y0, int y1, int radius, int power, uint8_t *temp[2])
 {
     int y;
 
     if (radius == 0 && dst == src)
         return;
 
-    for (y = 0; y < h; y++)
+    for (y = y0; y < y1; y++)
         blur_power(dst + y*dst_linesize, 1, src + y*src_linesize, 1,
                    w, radius, power, temp);
 }
 
 static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
-                  int w, int h, int radius, int power, uint8_t *temp[2])
+                  int x0, int x1, int h, int radius, int power, uint8_t *temp[2])
 {
     int x;
 
     if (radius == 0 && dst == src)
         return;
 
-    for (x = 0; x < w; x++)
+    for (x = x0; x < x1; x++)
         blur_power(dst + x, dst_linesize, src + x, src_linesize,
                    h, radius, power, temp);
 }
 
+void ff_boxblur_vblur_line_c(uint8_t *dst, uint16_t *sum, const uint8_t *add,
+                             const uint8_t *sub, int width, int inv)
+{
+    int x;
+
+    for (x = 0; x < width; x++) {
+        sum[x] += add[x] - sub[x];
+        dst[x]  = (sum[x]*inv + (1<<15))>>16;
+    }
+}
+
+/**
+ * Same as blur() applied to the columns x0 to x1 - 1, but run on whole
+ * lines so that the memory is accessed in order.
+ */
+static void vblur_lines(BoxBlurContext *boxblur,
+                        uint8_t *dst, int dst_linesize,
+                        const uint8_t *src, int src_linesize,
+                        int x0, int x1, int len, int radius, uint16_t *sum)
+{
+    const int length = radius*2 + 1;
+    const int inv = ((1<<16) + length/2)/length;
+    int x, y, w = x1 - x0;
+
+    dst += x0;
+    src += x0;
+
+    for (x = 0; x < w; x++)
+        sum[x] = src[radius*src_linesize + x];
+    for (y = 0; y < radius; y++)
+        for (x = 0; x < w; x++)
+            sum[x] += src[y*src_linesize + x]<<1;
+
+    for (y = 0; y < len; y++) {
+        int add = y < len-radius ? radius+y : 2*len-radius-y-1;
+        int sub = y <= radius    ? radius-y : y-radius-1;
+
+        boxblur->vblur_line(dst + y*dst_linesize, sum,
+                            src + add*src_linesize, src + sub*src_linesize,
+                            w, inv);
+    }
+}
+
+/**
+ * Whether the vertical pass of a plane runs on whole lines. The column
+ * sums must fit in 16 bits, and a box taller than the plane is handled by
+ * blur() only.
+ */
+static int vblur_by_lines(BoxBlurContext *boxblur, int plane, int h)
+{
+    int radius = boxblur->radius[plane];
+
+    return radius && boxblur->power[plane] &&
+           radius <= 128 && h >= 2*radius + 1;
+}
+
+typedef struct ThreadData {
+    AVFilterBufferRef *in, *out;
+    int w[4], h[4];
+} ThreadData;
+
+/* the rows of every plane are split between the jobs */
+static int hblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *boxblur = ctx->priv;
+    ThreadData *td = arg;
+    uint8_t *temp[2] = { boxblur->temp[0] + jobnr * boxblur->temp_size,
+                         boxblur->temp[1] + jobnr * boxblur->temp_size };
+    int plane;
+
+    for (plane = 0; td->in->data[plane] && plane < 4; plane++) {
+        /* the vertical passes alternate between the temporary picture and
+         * the output, ending in the output */
+        int to_temp = vblur_by_lines(boxblur, plane, td->h[plane]) &&
+                      boxblur->power[plane] & 1;
+
+        hblur(to_temp ? boxblur->temp_plane[plane]    : td->out->data[plane],
+              to_temp ? boxblur->temp_linesize[plane] : td->out->linesize[plane],
+              td->in ->data[plane], td->in ->linesize[plane],
+              td->w[plane],
+              td->h[plane] *  jobnr      / nb_jobs,
+              td->h[plane] * (jobnr + 1) / nb_jobs,
+              boxblur->radius[plane], boxblur->power[plane], temp);
+    }
+    return 0;
+}
+
+/* the columns of every plane are split between the jobs */
+static int vblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *boxblur = ctx->priv;
+    ThreadData *td = arg;
+    uint8_t *temp[2] = { boxblur->temp[0] + jobnr * boxblur->temp_size,
+                         boxblur->temp[1] + jobnr * boxblur->temp_size };
+    uint16_t *sum = boxblur->sums + jobnr * FFALIGN(td->w[0], 16);
+    int plane, pass;
+
+    for (plane = 0; td->in->data[plane] && plane < 4; plane++) {
+        int x0 = td->w[plane] *  jobnr      / nb_jobs;
+        int x1 = td->w[plane] * (jobnr + 1) / nb_jobs;
+
+        if (vblur_by_lines(boxblur, plane, td->h[plane])) {
+            uint8_t *buf[2]   = { td->out->data[plane], boxblur->temp_plane[plane] };
+            int linesize[2]   = { td->out->linesize[plane], boxblur->temp_linesize[plane] };
+            int power         = boxblur->power[plane];
+            int cur           = power & 1;
+
+            for (pass = 0; pass < power; pass++, cur ^= 1)
+                vblur_lines(boxblur, buf[!cur], linesize[!cur],
+                            buf[cur], linesize[cur], x0, x1, td->h[plane],
+                            boxblur->radius[plane], sum);
+        } else {
+            vblur(td->out->data[plane], td->out->linesize[plane],
+                  td->out->data[plane], td->out->linesize[plane],
+                  x0, x1, td->h[plane],
+                  boxblur->radius[plane], boxblur->power[plane], temp);
+        }
+    }
+    return 0;
+}
+
 static int draw_slice(AVFilterLink *inlink, int y0, int h0, int slice_dir)
 {
     AVFilterContext *ctx = inlink->dst;
     BoxBlurContext *boxblur = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
-    AVFilterBufferRef *inpicref  = inlink ->cur_buf;
-    AVFilterBufferRef *outpicref = outlink->out_buf;
-    int plane;
     int cw = inlink->w >> boxblur->hsub, ch = h0 >> boxblur->vsub;
-    int w[4] = { inlink->w, cw, cw, inlink->w };
-    int h[4] = { h0, ch, ch, h0 };
-
-    for (plane = 0; inpicref->data[plane] && plane < 4; plane++)
-        hblur(outpicref->data[plane], outpicref->linesize[plane],
-              inpicref ->data[plane], inpicref ->linesize[plane],
-              w[plane], h[plane], boxblur->radius[plane], boxblur->power[plane],
-              boxblur->temp);
+    ThreadData td = {
+        .in  = inlink ->cur_buf,
+        .out = outlink->out_buf,
+        .w   = { inlink->w, cw, cw, inlink->w },
+        .h   = { h0, ch, ch, h0 },
+    };
 
-    for (plane = 0; inpicref->data[plane] && plane < 4; plane++)
-        vblur(outpicref->data[plane], outpicref->linesize[plane],
-              outpicref->data[plane], outpicref->linesize[plane],
-              w[plane], h[plane], boxblur->radius[plane], boxblur->power[plane],
-              boxblur->temp);
+    ctx->internal->execute(ctx, hblur_slice, &td, NULL,
+                           FFMIN(h0, boxblur->nb_threads));
+    ctx->internal->execute(ctx, vblur_slice, &td, NULL,
+                           FFMIN(inlink->w, boxblur->nb_threads));
 
     return ff_draw_slice(outlink, y0, h0, slice_dir);
 }
@@ -341,6 +464,7 @@ AVFilter avfilter_vf_boxblur = {
     .init          = init,
     .uninit        = uninit,
     .query_formats = query_formats,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_FRAME_THREADS,
 
     .inputs    = (const AVFilterPad[]) {{ .name             = "default",
                                           .type             = AVMEDIA_TYPE_VIDEO,
@@ -36,16 +36,18 @@
 
 typedef struct {
     int16_t coefs[4][512*16];
-    uint16_t *line;
+    uint16_t *line;             ///< one line of state for each plane
     uint16_t *frame_prev[3];
     int hsub, vsub;
     int depth;
 } HQDN3DContext;
 
 #define RIGHTSHIFT(a,b) (((a)+(((1<<(b))-1)>>1))>>(b))
-#define LOAD(x) ((depth==8 ? src[x] : AV_RN16A(src+(x)*2)) << (16-depth))
-#define STORE(x,val) (depth==8 ? dst[x] = RIGHTSHIFT(val, 16-depth)\
-                    : AV_WN16A(dst+(x)*2, RIGHTSHIFT(val, 16-depth)))
+#define LOAD_PIX(p,x) ((depth==8 ? (p)[x] : AV_RN16A((p)+(x)*2)) << (16-depth))
+#define STORE_PIX(p,x,val) (depth==8 ? (p)[x] = RIGHTSHIFT(val, 16-depth)\
+                          : AV_WN16A((p)+(x)*2, RIGHTSHIFT(val, 16-depth)))
+#define LOAD(x)      LOAD_PIX(src, x)
+#define STORE(x,val) STORE_PIX(dst, x, val)
 
 static inline uint32_t lowpass(int prev, int cur, int16_t *coef)
 {
@@ -97,7 +99,42 @@ static void denoise_spatial(uint8_t *src, uint8_t *dst,
         STORE(x, tmp);
     }
 
-    for (y = 1; y < h; y++) {
+    /* Each line is filtered from left to right, so the lookups of a line
+     * form one long dependency chain. Two lines are filtered together to
+     * let their chains overlap, the second line taking its top neighbor
+     * from the first one. */
+    for (y = 1; y + 1 < h; y += 2) {
+        uint8_t  *src0 = src + sstride, *src1 = src0 + sstride;
+        uint8_t  *dst0 = dst + dstride, *dst1 = dst0 + dstride;
+        uint16_t *frame_ant0 = frame_ant + w, *frame_ant1 = frame_ant0 + w;
+        uint32_t pixel_ant0 = LOAD_PIX(src0, 0), pixel_ant1 = LOAD_PIX(src1, 0);
+        uint32_t tmp0, tmp1;
+
+        for (x = 0; x < w-1; x++) {
+            tmp0 = lowpass(line_ant[x], pixel_ant0, spatial);
+            pixel_ant0 = lowpass(pixel_ant0, LOAD_PIX(src0, x+1), spatial);
+            tmp1 = lowpass((uint16_t)tmp0, pixel_ant1, spatial);
+            pixel_ant1 = lowpass(pixel_ant1, LOAD_PIX(src1, x+1), spatial);
+            line_ant[x] = tmp1;
+            frame_ant0[x] = tmp0 = lowpass(frame_ant0[x], tmp0, temporal);
+            frame_ant1[x] = tmp1 = lowpass(frame_ant1[x], tmp1, temporal);
+            STORE_PIX(dst0, x, tmp0);
+            STORE_PIX(dst1, x, tmp1);
+        }
+        tmp0 = lowpass(line_ant[x], pixel_ant0, spatial);
+        tmp1 = lowpass((uint16_t)tmp0, pixel_ant1, spatial);
+        line_ant[x] = tmp1;
+        frame_ant0[x] = tmp0 = lowpass(frame_ant0[x], tmp0, temporal);
+        frame_ant1[x] = tmp1 = lowpass(frame_ant1[x], tmp1, temporal);
+        STORE_PIX(dst0, x, tmp0);
+        STORE_PIX(dst1, x, tmp1);
+
+        src       = src1;
+        dst       = dst1;
+        frame_ant = frame_ant1;
+    }
+
+    for (; y < h; y++) {
         src += sstride;
         dst += dstride;
         frame_ant += w;
@@ -145,6 +182,7 @@ static void denoise_depth(uint8_t *src, uint8_t *dst,
         case  8: denoise_depth(__VA_ARGS__,  8); break;\
         case  9: denoise_depth(__VA_ARGS__,  9); break;\
         case 10: denoise_depth(__VA_ARGS__, 10); break;\
+        case 16: denoise_depth(__VA_ARGS__, 16); break;\
     }
 
 static void precalc_coefs(int16_t *ct, double dist25)
@@ -256,6 +294,9 @@ static int query_formats(AVFilterContext *ctx)
         AV_NE( PIX_FMT_YUV420P10BE, PIX_FMT_YUV420P10LE ),
         AV_NE( PIX_FMT_YUV422P10BE, PIX_FMT_YUV422P10LE ),
         AV_NE( PIX_FMT_YUV444P10BE, PIX_FMT_YUV444P10LE ),
+        AV_NE( PIX_FMT_YUV420P16BE, PIX_FMT_YUV420P16LE ),
+        AV_NE( PIX_FMT_YUV422P16BE, PIX_FMT_YUV422P16LE ),
+        AV_NE( PIX_FMT_YUV444P16BE, PIX_FMT_YUV444P16LE ),
         PIX_FMT_NONE
     };
 
@@ -272,7 +313,7 @@ static int config_input(AVFilterLink *inlink)
     hqdn3d->vsub = av_pix_fmt_descriptors[inlink->format].log2_chroma_h;
     hqdn3d->depth = av_pix_fmt_descriptors[inlink->format].comp[0].depth_minus1+1;
 
-    hqdn3d->line = av_malloc(inlink->w * sizeof(*hqdn3d->line));
+    hqdn3d->line = av_malloc(3 * inlink->w * sizeof(*hqdn3d->line));
     if (!hqdn3d->line)
         return AVERROR(ENOMEM);
 
@@ -284,24 +325,37 @@ static int null_draw_slice(AVFilterLink *link, int y, int h, int slice_dir)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFilterBufferRef *in, *out;
+} ThreadData;
+
+/* the filter is recursive in both directions, so each plane is one job */
+static int denoise_plane(AVFilterContext *ctx, void *arg, int c, int nb_jobs)
+{
+    HQDN3DContext *hqdn3d = ctx->priv;
+    ThreadData *td = arg;
+    AVFilterBufferRef *inpic  = td->in;
+    AVFilterBufferRef *outpic = td->out;
+
+    denoise(inpic->data[c], outpic->data[c],
+            hqdn3d->line + c * ctx->inputs[0]->w, &hqdn3d->frame_prev[c],
+            inpic->video->w >> (!!c * hqdn3d->hsub),
+            inpic->video->h >> (!!c * hqdn3d->vsub),
+            inpic->linesize[c], outpic->linesize[c],
+            hqdn3d->coefs[c?2:0], hqdn3d->coefs[c?3:1]);
+    return 0;
+}
+
 static int end_frame(AVFilterLink *inlink)
 {
-    HQDN3DContext *hqdn3d = inlink->dst->priv;
-    AVFilterLink *outlink = inlink->dst->outputs[0];
-    AVFilterBufferRef *inpic  = inlink ->cur_buf;
-    AVFilterBufferRef *outpic = outlink->out_buf;
-    int ret, c;
-
-    for (c = 0; c < 3; c++) {
-        denoise(inpic->data[c], outpic->data[c],
-                hqdn3d->line, &hqdn3d->frame_prev[c],
-                inpic->video->w >> (!!c * hqdn3d->hsub),
-                inpic->video->h >> (!!c * hqdn3d->vsub),
-                inpic->linesize[c], outpic->linesize[c],
-                hqdn3d->coefs[c?2:0], hqdn3d->coefs[c?3:1]);
-    }
+    AVFilterContext *ctx = inlink->dst;
+    AVFilterLink *outlink = ctx->outputs[0];
+    ThreadData td = { inlink->cur_buf, outlink->out_buf };
+    int ret;
+
+    ctx->internal->execute(ctx, denoise_plane, &td, NULL, 3);
 
-    if ((ret = ff_draw_slice(outlink, 0, inpic->video->h, 1)) < 0 ||
+    if ((ret = ff_draw_slice(outlink, 0, td.in->video->h, 1)) < 0 ||
         (ret = ff_end_frame(outlink)) < 0)
         return ret;
     return 0;
@@ -315,6 +369,7 @@ AVFilter avfilter_vf_hqdn3d = {
     .init          = init,
     .uninit        = uninit,
     .query_formats = query_formats,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_FRAME_THREADS,
 
     .inputs    = (const AVFilterPad[]) {{ .name             = "default",
                                           .type             = AVMEDIA_TYPE_VIDEO,
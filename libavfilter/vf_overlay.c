@@ -32,8 +32,10 @@
 #include "libavutil/avstring.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/imgutils.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/mathematics.h"
 #include "internal.h"
+#include "overlay.h"
 #include "video.h"
 
 static const char *const var_names[] = {
@@ -61,17 +63,6 @@ enum var_name {
 #define MAIN    0
 #define OVERLAY 1
 
-typedef struct {
-    int x, y;                   ///< position of overlayed picture
-
-    AVFilterBufferRef *overpicref;
-
-    int max_plane_step[4];      ///< steps per pixel for each plane
-    int hsub, vsub;             ///< chroma subsampling values
-
-    char x_expr[256], y_expr[256];
-} OverlayContext;
-
 static av_cold int init(AVFilterContext *ctx, const char *args)
 {
     OverlayContext *over = ctx->priv;
@@ -82,6 +73,11 @@ static av_cold int init(AVFilterContext *ctx, const char *args)
     if (args)
         sscanf(args, "%255[^:]:%255[^:]", over->x_expr, over->y_expr);
 
+    over->blend_row        = ff_overlay_blend_row_c;
+    over->blend_row_yuv420 = ff_overlay_blend_row_yuv420_c;
+    if (HAVE_MMX)
+        ff_overlay_init_x86(over);
+
     return 0;
 }
 
@@ -247,13 +243,104 @@ static int start_frame_overlay(AVFilterLink *inlink, AVFilterBufferRef *inpicref
     return 0;
 }
 
-static void blend_slice(AVFilterContext *ctx,
-                        AVFilterBufferRef *dst, AVFilterBufferRef *src,
-                        int x, int y, int w, int h,
-                        int slice_y, int slice_w, int slice_h)
+// divide by 255 and round to nearest, exact for x in [0, 255 * 255]
+#define FAST_DIV255(x) ((((x) + 128) * 257) >> 16)
+
+void ff_overlay_blend_row_c(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *alpha, int width)
+{
+    int x;
+
+    for (x = 0; x < width; x++)
+        dst[x] = FAST_DIV255(dst[x] * (255 - alpha[x]) + src[x] * alpha[x]);
+}
+
+void ff_overlay_blend_row_yuv420_c(uint8_t *dst, const uint8_t *src,
+                                   const uint8_t *alpha, int alpha_linesize,
+                                   int width)
+{
+    int x;
+
+    for (x = 0; x < width; x++) {
+        const uint8_t *a = alpha + 2 * x;
+        int av = (a[0] + a[alpha_linesize] +
+                  a[1] + a[alpha_linesize + 1]) >> 2;
+        dst[x] = FAST_DIV255(dst[x] * (255 - av) + src[x] * av);
+    }
+}
+
+/**
+ * Blend the pixels [k0, k1) of a row of a subsampled plane, last_row is set
+ * if the pixels below in the alpha plane are outside of the overlaid area.
+ */
+static void blend_row_generic(uint8_t *d, const uint8_t *s, const uint8_t *a,
+                              int alpha_linesize, int k0, int k1, int wp,
+                              int hsub, int vsub, int last_row)
+{
+    int k;
+
+    for (k = k0; k < k1; k++) {
+        const uint8_t *ak = a + (k << hsub);
+        // average alpha for color components, improve quality
+        int alpha_v, alpha_h, alpha;
+        if (hsub && vsub && !last_row && k+1 < wp) {
+            alpha = (ak[0] + ak[alpha_linesize] +
+                     ak[1] + ak[alpha_linesize+1]) >> 2;
+        } else if (hsub || vsub) {
+            alpha_h = hsub && k+1 < wp ?
+                (ak[0] + ak[1]) >> 1 : ak[0];
+            alpha_v = vsub && !last_row ?
+                (ak[0] + ak[alpha_linesize]) >> 1 : ak[0];
+            alpha = (alpha_v + alpha_h) >> 1;
+        } else
+            alpha = ak[0];
+        d[k] = FAST_DIV255(d[k] * (0xff - alpha) + s[k] * alpha);
+    }
+}
+
+/**
+ * Find the smallest range [*start, *end) containing all the non zero alpha
+ * values of a row, *start == *end if the row is fully transparent.
+ */
+static void alpha_span(const uint8_t *a, int width, int *start, int *end)
+{
+    int s = 0, e = width;
+
+    while (s + 8 <= width && !AV_RN64(a + s))
+        s += 8;
+    while (s < width && !a[s])
+        s++;
+    if (s == width) {
+        *start = *end = 0;
+        return;
+    }
+    while (e - 8 >= s && !AV_RN64(a + e - 8))
+        e -= 8;
+    while (!a[e - 1])
+        e--;
+    *start = s;
+    *end   = e;
+}
+
+typedef struct ThreadData {
+    AVFilterBufferRef *dst, *src;
+    int x, y, w, h;
+    int slice_y, slice_w, slice_h;
+} ThreadData;
+
+/**
+ * Blend a part of the rows of the overlaid area, the rows of each plane
+ * are split evenly between the jobs. Fully transparent parts of the
+ * overlay leave the main picture untouched, so they are skipped.
+ */
+static int blend_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     OverlayContext *over = ctx->priv;
-    int i, j, k;
+    ThreadData *td = arg;
+    AVFilterBufferRef *dst = td->dst, *src = td->src;
+    int x = td->x, y = td->y, w = td->w, h = td->h;
+    int slice_y = td->slice_y, slice_w = td->slice_w, slice_h = td->slice_h;
+    int i, j, k, j0, j1;
     int width, height;
     int overlay_end_y = y+h;
     int slice_end_y = slice_y+slice_h;
@@ -271,12 +358,16 @@ static void blend_slice(AVFilterContext *ctx,
         int r = dst->format == PIX_FMT_BGR24 ? 0 : 2;
         if (slice_y > y)
             sp += (slice_y - y) * src->linesize[0];
-        for (i = 0; i < height; i++) {
+        j0  = height *  jobnr      / nb_jobs;
+        j1  = height * (jobnr + 1) / nb_jobs;
+        dp += j0 * dst->linesize[0];
+        sp += j0 * src->linesize[0];
+        for (i = j0; i < j1; i++) {
             uint8_t *d = dp, *s = sp;
             for (j = 0; j < width; j++) {
-                d[r] = (d[r] * (0xff - s[3]) + s[0] * s[3] + 128) >> 8;
-                d[1] = (d[1] * (0xff - s[3]) + s[1] * s[3] + 128) >> 8;
-                d[b] = (d[b] * (0xff - s[3]) + s[2] * s[3] + 128) >> 8;
+                d[r] = FAST_DIV255(d[r] * (0xff - s[3]) + s[0] * s[3]);
+                d[1] = FAST_DIV255(d[1] * (0xff - s[3]) + s[1] * s[3]);
+                d[b] = FAST_DIV255(d[b] * (0xff - s[3]) + s[2] * s[3]);
                 d += 3;
                 s += 4;
             }
@@ -297,25 +388,47 @@ static void blend_slice(AVFilterContext *ctx,
                 sp += ((slice_y - y) >> vsub) * src->linesize[i];
                 ap += (slice_y - y) * src->linesize[3];
             }
-            for (j = 0; j < hp; j++) {
-                uint8_t *d = dp, *s = sp, *a = ap;
-                for (k = 0; k < wp; k++) {
-                    // average alpha for color components, improve quality
-                    int alpha_v, alpha_h, alpha;
-                    if (hsub && vsub && j+1 < hp && k+1 < wp) {
-                        alpha = (a[0] + a[src->linesize[3]] +
-                                 a[1] + a[src->linesize[3]+1]) >> 2;
-                    } else if (hsub || vsub) {
-                        alpha_h = hsub && k+1 < wp ?
-                            (a[0] + a[1]) >> 1 : a[0];
-                        alpha_v = vsub && j+1 < hp ?
-                            (a[0] + a[src->linesize[3]]) >> 1 : a[0];
-                        alpha = (alpha_v + alpha_h) >> 1;
-                    } else
-                        alpha = a[0];
-                    *d = (*d * (0xff - alpha) + *s++ * alpha + 128) >> 8;
-                    d++;
-                    a += 1 << hsub;
+            j0  = hp *  jobnr      / nb_jobs;
+            j1  = hp * (jobnr + 1) / nb_jobs;
+            dp += j0 * dst->linesize[i];
+            sp += j0 * src->linesize[i];
+            ap += j0 * (1 << vsub) * src->linesize[3];
+            for (j = j0; j < j1; j++) {
+                int last_row = j+1 == hp;
+                int start, end, start1, end1;
+
+                alpha_span(ap, width, &start, &end);
+                if (vsub && !last_row) {
+                    alpha_span(ap + src->linesize[3], width, &start1, &end1);
+                    if (start == end) {
+                        start = start1;
+                        end   = end1;
+                    } else if (start1 < end1) {
+                        start = FFMIN(start, start1);
+                        end   = FFMAX(end,   end1);
+                    }
+                }
+                start >>= hsub;
+                end     = FFMIN(wp, (end + (1 << hsub) - 1) >> hsub);
+
+                if (start >= end) {
+                    /* fully transparent */
+                } else if (!hsub && !vsub) {
+                    over->blend_row(dp + start, sp + start, ap + start,
+                                    end - start);
+                } else if (hsub == 1 && vsub == 1 && !last_row) {
+                    /* the last pixel of the row has only half an alpha block */
+                    k = FFMIN(end, wp - 1);
+                    if (k > start)
+                        over->blend_row_yuv420(dp + start, sp + start,
+                                               ap + 2 * start,
+                                               src->linesize[3], k - start);
+                    blend_row_generic(dp, sp, ap, src->linesize[3],
+                                      FFMAX(k, start), end, wp,
+                                      hsub, vsub, last_row);
+                } else {
+                    blend_row_generic(dp, sp, ap, src->linesize[3],
+                                      start, end, wp, hsub, vsub, last_row);
                 }
                 dp += dst->linesize[i];
                 sp += src->linesize[i];
@@ -323,6 +436,7 @@ static void blend_slice(AVFilterContext *ctx,
             }
         }
     }
+    return 0;
 }
 
 static int draw_slice(AVFilterLink *inlink, int y, int h, int slice_dir)
@@ -335,9 +449,20 @@ static int draw_slice(AVFilterLink *inlink, int y, int h, int slice_dir)
     if (over->overpicref &&
         !(over->x >= outpicref->video->w || over->y >= outpicref->video->h ||
           y+h < over->y || y >= over->y + over->overpicref->video->h)) {
-        blend_slice(ctx, outpicref, over->overpicref, over->x, over->y,
-                    over->overpicref->video->w, over->overpicref->video->h,
-                    y, outpicref->video->w, h);
+        ThreadData td = {
+            .dst     = outpicref,
+            .src     = over->overpicref,
+            .x       = over->x,
+            .y       = over->y,
+            .w       = over->overpicref->video->w,
+            .h       = over->overpicref->video->h,
+            .slice_y = y,
+            .slice_w = outpicref->video->w,
+            .slice_h = h,
+        };
+
+        ctx->internal->execute(ctx, blend_slice, &td, NULL,
+                               FFMIN(h, ff_filter_get_nb_threads(ctx)));
     }
     return ff_draw_slice(outlink, y, h, slice_dir);
 }
@@ -379,6 +504,7 @@ AVFilter avfilter_vf_overlay = {
     .priv_size = sizeof(OverlayContext),
 
     .query_formats = query_formats,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 
     .inputs    = (const AVFilterPad[]) {{ .name            = "main",
                                           .type            = AVMEDIA_TYPE_VIDEO,
@@ -233,11 +233,23 @@ static int config_props(AVFilterLink *outlink)
         inlink->format == outlink->format)
         scale->sws = NULL;
     else {
-        scale->sws = sws_getContext(inlink ->w, inlink ->h, inlink ->format,
-                                    outlink->w, outlink->h, outlink->format,
-                                    scale->flags, NULL, NULL, NULL);
-        if (!scale->sws)
-            return AVERROR(EINVAL);
+        struct SwsContext *sws = sws_alloc_context();
+        if (!sws)
+            return AVERROR(ENOMEM);
+        scale->sws = sws;
+
+        av_opt_set_int(sws, "srcw",       inlink ->w,      0);
+        av_opt_set_int(sws, "srch",       inlink ->h,      0);
+        av_opt_set_int(sws, "src_format", inlink ->format, 0);
+        av_opt_set_int(sws, "dstw",       outlink->w,      0);
+        av_opt_set_int(sws, "dsth",       outlink->h,      0);
+        av_opt_set_int(sws, "dst_format", outlink->format, 0);
+        av_opt_set_int(sws, "sws_flags",  scale->flags,    0);
+        /* swscale runs its own slice threads */
+        av_opt_set_int(sws, "threads", ff_filter_get_nb_threads(ctx), 0);
+
+        if ((ret = sws_init_context(sws, NULL, NULL)) < 0)
+            return ret;
     }
 
 
@@ -347,6 +359,8 @@ AVFilter avfilter_vf_scale = {
 
     .priv_size = sizeof(ScaleContext),
 
+    .flags     = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_FRAME_THREADS,
+
     .inputs    = (const AVFilterPad[]) {{ .name             = "default",
                                           .type             = AVMEDIA_TYPE_VIDEO,
                                           .start_frame      = start_frame,
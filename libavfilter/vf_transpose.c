@@ -27,6 +27,7 @@
 
 #include <stdio.h>
 
+#include "libavutil/common.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/imgutils.h"
@@ -34,19 +35,9 @@
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "transpose.h"
 #include "video.h"
 
-typedef struct {
-    int hsub, vsub;
-    int pixsteps[4];
-
-    /* 0    Rotate by 90 degrees counterclockwise and vflip. */
-    /* 1    Rotate by 90 degrees clockwise.                  */
-    /* 2    Rotate by 90 degrees counterclockwise.           */
-    /* 3    Rotate by 90 degrees clockwise and vflip.        */
-    int dir;
-} TransContext;
-
 static av_cold int init(AVFilterContext *ctx, const char *args)
 {
     TransContext *trans = ctx->priv;
@@ -65,6 +56,8 @@ static av_cold int init(AVFilterContext *ctx, const char *args)
 
 static int query_formats(AVFilterContext *ctx)
 {
+    /* the chroma planes of formats with different horizontal and vertical
+     * subsampling cannot be transposed into the same format */
     enum PixelFormat pix_fmts[] = {
         PIX_FMT_ARGB,         PIX_FMT_RGBA,
         PIX_FMT_ABGR,         PIX_FMT_BGRA,
@@ -75,16 +68,13 @@ static int query_formats(AVFilterContext *ctx)
         PIX_FMT_BGR555BE,     PIX_FMT_BGR555LE,
         PIX_FMT_GRAY16BE,     PIX_FMT_GRAY16LE,
         PIX_FMT_YUV420P16LE,  PIX_FMT_YUV420P16BE,
-        PIX_FMT_YUV422P16LE,  PIX_FMT_YUV422P16BE,
         PIX_FMT_YUV444P16LE,  PIX_FMT_YUV444P16BE,
         PIX_FMT_NV12,         PIX_FMT_NV21,
         PIX_FMT_RGB8,         PIX_FMT_BGR8,
         PIX_FMT_RGB4_BYTE,    PIX_FMT_BGR4_BYTE,
-        PIX_FMT_YUV444P,      PIX_FMT_YUV422P,
+        PIX_FMT_YUV444P,      PIX_FMT_YUVJ444P,
         PIX_FMT_YUV420P,      PIX_FMT_YUVJ420P,
-        PIX_FMT_YUV411P,      PIX_FMT_YUV410P,
-        PIX_FMT_YUVJ444P,     PIX_FMT_YUVJ422P,
-        PIX_FMT_YUV440P,      PIX_FMT_YUVJ440P,
+        PIX_FMT_YUV410P,
         PIX_FMT_YUVA420P,     PIX_FMT_GRAY8,
         PIX_FMT_NONE
     };
@@ -93,18 +83,90 @@ static int query_formats(AVFilterContext *ctx)
     return 0;
 }
 
+static void transpose_block_8_c(uint8_t *src, int src_linesize,
+                                uint8_t *dst, int dst_linesize,
+                                int w, int h)
+{
+    int x, y;
+    for (y = 0; y < h; y++, dst += dst_linesize, src++)
+        for (x = 0; x < w; x++)
+            dst[x] = src[x*src_linesize];
+}
+
+static void transpose_block_16_c(uint8_t *src, int src_linesize,
+                                 uint8_t *dst, int dst_linesize,
+                                 int w, int h)
+{
+    int x, y;
+    for (y = 0; y < h; y++, dst += dst_linesize, src += 2)
+        for (x = 0; x < w; x++)
+            *((uint16_t *)(dst + 2*x)) = *((uint16_t *)(src + x*src_linesize));
+}
+
+static void transpose_block_24_c(uint8_t *src, int src_linesize,
+                                 uint8_t *dst, int dst_linesize,
+                                 int w, int h)
+{
+    int x, y;
+    for (y = 0; y < h; y++, dst += dst_linesize, src += 3)
+        for (x = 0; x < w; x++) {
+            int32_t v = AV_RB24(src + x*src_linesize);
+            AV_WB24(dst + 3*x, v);
+        }
+}
+
+static void transpose_block_32_c(uint8_t *src, int src_linesize,
+                                 uint8_t *dst, int dst_linesize,
+                                 int w, int h)
+{
+    int x, y;
+    for (y = 0; y < h; y++, dst += dst_linesize, src += 4)
+        for (x = 0; x < w; x++)
+            *((uint32_t *)(dst + 4*x)) = *((uint32_t *)(src + x*src_linesize));
+}
+
+#define TRANSPOSE_8x8_C(bits)                                               \
+static void transpose_8x8_ ## bits ## _c(uint8_t *src, int src_linesize,    \
+                                         uint8_t *dst, int dst_linesize)    \
+{                                                                           \
+    transpose_block_ ## bits ## _c(src, src_linesize, dst, dst_linesize,    \
+                                   8, 8);                                   \
+}
+
+TRANSPOSE_8x8_C(8)
+TRANSPOSE_8x8_C(16)
+TRANSPOSE_8x8_C(24)
+TRANSPOSE_8x8_C(32)
+
 static int config_props_output(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
     TransContext *trans = ctx->priv;
     AVFilterLink *inlink = ctx->inputs[0];
     const AVPixFmtDescriptor *pixdesc = &av_pix_fmt_descriptors[outlink->format];
+    int i;
 
     trans->hsub = av_pix_fmt_descriptors[inlink->format].log2_chroma_w;
     trans->vsub = av_pix_fmt_descriptors[inlink->format].log2_chroma_h;
 
     av_image_fill_max_pixsteps(trans->pixsteps, NULL, pixdesc);
 
+    for (i = 0; i < 4; i++) {
+        TransVtable *v = &trans->vtables[i];
+        switch (trans->pixsteps[i]) {
+        case 1: v->transpose_block = transpose_block_8_c;
+                v->transpose_8x8   = transpose_8x8_8_c;  break;
+        case 2: v->transpose_block = transpose_block_16_c;
+                v->transpose_8x8   = transpose_8x8_16_c; break;
+        case 3: v->transpose_block = transpose_block_24_c;
+                v->transpose_8x8   = transpose_8x8_24_c; break;
+        case 4: v->transpose_block = transpose_block_32_c;
+                v->transpose_8x8   = transpose_8x8_32_c; break;
+        }
+        if (HAVE_MMX)
+            ff_transpose_init_x86(v, trans->pixsteps[i]);
+    }
+
     outlink->w = inlink->h;
     outlink->h = inlink->w;
 
@@ -145,13 +207,48 @@ static int start_frame(AVFilterLink *inlink, AVFilterBufferRef *picref)
     return ff_start_frame(outlink, buf_out);
 }
 
-static int end_frame(AVFilterLink *inlink)
+typedef struct ThreadData {
+    AVFilterBufferRef *in, *out;
+} ThreadData;
+
+/* size of the tiles the planes are transposed in, so that the source
+ * lines of a tile stay in the L1 cache */
+#define TILE_SIZE 64
+
+/**
+ * Transpose a tile of w x h output pixels in blocks of 8x8 pixels.
+ */
+static void transpose_tile(TransVtable *v, uint8_t *in, int inlinesize,
+                           uint8_t *out, int outlinesize,
+                           int pixstep, int w, int h)
 {
-    TransContext *trans = inlink->dst->priv;
-    AVFilterBufferRef *inpic  = inlink->cur_buf;
-    AVFilterBufferRef *outpic = inlink->dst->outputs[0]->out_buf;
-    AVFilterLink *outlink = inlink->dst->outputs[0];
-    int plane, ret;
+    int x, y;
+
+    for (y = 0; y < h - 7; y += 8) {
+        for (x = 0; x < w - 7; x += 8)
+            v->transpose_8x8(in + x*inlinesize, inlinesize,
+                             out + x*pixstep, outlinesize);
+        if (w - x > 0)
+            v->transpose_block(in + x*inlinesize, inlinesize,
+                               out + x*pixstep, outlinesize, w - x, 8);
+        out += 8 * outlinesize;
+        in  += 8 * pixstep;
+    }
+    if (h - y > 0)
+        v->transpose_block(in, inlinesize, out, outlinesize, w, h - y);
+}
+
+/**
+ * Transpose a part of the rows of each output plane, going through the
+ * picture in tiles to stay within the cache.
+ */
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    TransContext *trans = ctx->priv;
+    ThreadData *td = arg;
+    AVFilterBufferRef *inpic  = td->in;
+    AVFilterBufferRef *outpic = td->out;
+    int plane;
 
     for (plane = 0; outpic->data[plane]; plane++) {
         int hsub = plane == 1 || plane == 2 ? trans->hsub : 0;
@@ -160,10 +257,17 @@ static int end_frame(AVFilterLink *inlink)
         int inh  = inpic->video->h>>vsub;
         int outw = outpic->video->w>>hsub;
         int outh = outpic->video->h>>vsub;
+        int start = (outh *  jobnr     ) / nb_jobs;
+        int end   = (outh * (jobnr + 1)) / nb_jobs;
+        TransVtable *v = &trans->vtables[plane];
         uint8_t *out, *in;
         int outlinesize, inlinesize;
         int x, y;
 
+        /* the palette of (pseudo)paletted formats is copied in end_frame() */
+        if (!pixstep)
+            continue;
+
         out = outpic->data[plane]; outlinesize = outpic->linesize[plane];
         in  = inpic ->data[plane]; inlinesize  = inpic ->linesize[plane];
 
@@ -177,30 +281,31 @@ static int end_frame(AVFilterLink *inlink)
             outlinesize *= -1;
         }
 
-        for (y = 0; y < outh; y++) {
-            switch (pixstep) {
-            case 1:
-                for (x = 0; x < outw; x++)
-                    out[x] = in[x*inlinesize + y];
-                break;
-            case 2:
-                for (x = 0; x < outw; x++)
-                    *((uint16_t *)(out + 2*x)) = *((uint16_t *)(in + x*inlinesize + y*2));
-                break;
-            case 3:
-                for (x = 0; x < outw; x++) {
-                    int32_t v = AV_RB24(in + x*inlinesize + y*3);
-                    AV_WB24(out + 3*x, v);
-                }
-                break;
-            case 4:
-                for (x = 0; x < outw; x++)
-                    *((uint32_t *)(out + 4*x)) = *((uint32_t *)(in + x*inlinesize + y*4));
-                break;
-            }
-            out += outlinesize;
-        }
+        for (y = start; y < end; y += TILE_SIZE)
+            for (x = 0; x < outw; x += TILE_SIZE)
+                transpose_tile(v, in  + x*inlinesize  + y*pixstep, inlinesize,
+                                  out + y*outlinesize + x*pixstep, outlinesize,
+                               pixstep, FFMIN(TILE_SIZE, outw - x),
+                               FFMIN(TILE_SIZE, end - y));
     }
+    return 0;
+}
+
+static int end_frame(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    AVFilterBufferRef *inpic  = inlink->cur_buf;
+    AVFilterBufferRef *outpic = inlink->dst->outputs[0]->out_buf;
+    AVFilterLink *outlink = inlink->dst->outputs[0];
+    ThreadData td = { inpic, outpic };
+    int ret;
+
+    if (av_pix_fmt_descriptors[inlink->format].flags & PIX_FMT_PAL ||
+        av_pix_fmt_descriptors[inlink->format].flags & PIX_FMT_PSEUDOPAL)
+        memcpy(outpic->data[1], inpic->data[1], 256*4);
+
+    ctx->internal->execute(ctx, filter_slice, &td, NULL,
+                           FFMIN(outpic->video->h, ff_filter_get_nb_threads(ctx)));
 
     if ((ret = ff_draw_slice(outlink, 0, outpic->video->h, 1)) < 0 ||
         (ret = ff_end_frame(outlink)) < 0)
@@ -216,6 +321,7 @@ AVFilter avfilter_vf_transpose = {
     .priv_size = sizeof(TransContext),
 
     .query_formats = query_formats,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_FRAME_THREADS,
 
     .inputs    = (const AVFilterPad[]) {{ .name            = "default",
                                           .type            = AVMEDIA_TYPE_VIDEO,
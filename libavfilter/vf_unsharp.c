@@ -39,6 +39,7 @@
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "unsharp.h"
 #include "video.h"
 #include "libavutil/common.h"
 #include "libavutil/mem.h"
@@ -50,39 +51,58 @@
 /* right-shift and round-up */
 #define SHIFTUP(x,shift) (-((-(x))>>(shift)))
 
-typedef struct FilterParam {
-    int msize_x;                             ///< matrix width
-    int msize_y;                             ///< matrix height
-    int amount;                              ///< effect amount
-    int steps_x;                             ///< horizontal step count
-    int steps_y;                             ///< vertical step count
-    int scalebits;                           ///< bits to shift pixel
-    int32_t halfscale;                       ///< amount to add to pixel
-    uint32_t *sc[(MAX_SIZE * MAX_SIZE) - 1]; ///< finite state machine storage
-} FilterParam;
-
-typedef struct {
-    FilterParam luma;   ///< luma parameters (width, height, amount)
-    FilterParam chroma; ///< chroma parameters (width, height, amount)
-    int hsub, vsub;
-} UnsharpContext;
-
-static void apply_unsharp(      uint8_t *dst, int dst_stride,
-                          const uint8_t *src, int src_stride,
-                          int width, int height, FilterParam *fp)
+/* number of lines of state machine storage used by each job */
+#define SC_LINES(fp) (2 * (fp)->steps_y + 1)
+
+void ff_unsharp_vsum_line_c(uint32_t *line, uint32_t *sc0, uint32_t *sc1, int width)
 {
-    uint32_t **sc = fp->sc;
-    uint32_t sr[(MAX_SIZE * MAX_SIZE) - 1], tmp1, tmp2;
+    uint32_t tmp1, tmp2;
+    int x;
+
+    for (x = 0; x < width; x++) {
+        tmp1 = line[x];
+        tmp2 = sc0[x] + tmp1; sc0[x] = tmp1;
+        tmp1 = sc1[x] + tmp2; sc1[x] = tmp2;
+        line[x] = tmp1;
+    }
+}
 
+void ff_unsharp_blend_line_c(uint8_t *dst, const uint8_t *src, const uint32_t *line,
+                             int width, const FilterParam *fp)
+{
     int32_t res;
+    int x;
+
+    for (x = 0; x < width; x++) {
+        res = (int32_t)src[x] + ((((int32_t)src[x] - (int32_t)((line[x] + fp->halfscale) >> fp->scalebits)) * fp->amount) >> 16);
+        dst[x] = av_clip_uint8(res);
+    }
+}
+
+/**
+ * Filter the rows slice_start to slice_end - 1 of a plane.
+ * The vertical state machine only depends on the last 2 * steps_y rows, so
+ * starting it steps_y rows before the slice gives the same output as
+ * filtering the whole plane at once.
+ */
+static void apply_unsharp(UnsharpContext *unsharp,
+                                uint8_t *dst, int dst_stride,
+                          const uint8_t *src, int src_stride,
+                          int width, int height, int slice_start, int slice_end,
+                          FilterParam *fp, uint32_t **sc)
+{
+    uint32_t sr[(MAX_SIZE * MAX_SIZE) - 1], tmp1, tmp2;
+    uint32_t *line = sc[2 * fp->steps_y];
     int x, y, z;
     const uint8_t *src2;
 
     if (!fp->amount) {
+        dst += slice_start * dst_stride;
+        src += slice_start * src_stride;
         if (dst_stride == src_stride)
-            memcpy(dst, src, src_stride * height);
+            memcpy(dst, src, src_stride * (slice_end - slice_start));
         else
-            for (y = 0; y < height; y++, dst += dst_stride, src += src_stride)
+            for (y = slice_start; y < slice_end; y++, dst += dst_stride, src += src_stride)
                 memcpy(dst, src, width);
         return;
     }
@@ -90,9 +110,8 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
     for (y = 0; y < 2 * fp->steps_y; y++)
         memset(sc[y], 0, sizeof(sc[y][0]) * (width + 2 * fp->steps_x));
 
-    for (y = -fp->steps_y; y < height + fp->steps_y; y++) {
-        if (y < height)
-            src2 = src;
+    for (y = slice_start - fp->steps_y; y < slice_end + fp->steps_y; y++) {
+        src2 = src + av_clip(y, 0, height - 1) * src_stride;
 
         memset(sr, 0, sizeof(sr[0]) * (2 * fp->steps_x - 1));
         for (x = -fp->steps_x; x < width + fp->steps_x; x++) {
@@ -101,22 +120,19 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
                 tmp2 = sr[z + 0] + tmp1; sr[z + 0] = tmp1;
                 tmp1 = sr[z + 1] + tmp2; sr[z + 1] = tmp2;
             }
-            for (z = 0; z < fp->steps_y * 2; z += 2) {
-                tmp2 = sc[z + 0][x + fp->steps_x] + tmp1; sc[z + 0][x + fp->steps_x] = tmp1;
-                tmp1 = sc[z + 1][x + fp->steps_x] + tmp2; sc[z + 1][x + fp->steps_x] = tmp2;
-            }
-            if (x >= fp->steps_x && y >= fp->steps_y) {
-                const uint8_t *srx = src - fp->steps_y * src_stride + x - fp->steps_x;
-                uint8_t *dsx       = dst - fp->steps_y * dst_stride + x - fp->steps_x;
-
-                res = (int32_t)*srx + ((((int32_t) * srx - (int32_t)((tmp1 + fp->halfscale) >> fp->scalebits)) * fp->amount) >> 16);
-                *dsx = av_clip_uint8(res);
-            }
-        }
-        if (y >= 0) {
-            dst += dst_stride;
-            src += src_stride;
+            if (x >= fp->steps_x)
+                line[x - fp->steps_x] = tmp1;
         }
+
+        /* the columns left of the output pixels are never used */
+        for (z = 0; z < fp->steps_y * 2; z += 2)
+            unsharp->vsum_line(line, sc[z + 0] + 2 * fp->steps_x,
+                                     sc[z + 1] + 2 * fp->steps_x, width);
+
+        if (y >= slice_start + fp->steps_y)
+            unsharp->blend_line(dst + (y - fp->steps_y) * dst_stride,
+                                src + (y - fp->steps_y) * src_stride,
+                                line, width, fp);
     }
 }
 
@@ -154,6 +170,11 @@ static av_cold int init(AVFilterContext *ctx, const char *args)
     set_filter_param(&unsharp->luma,   lmsize_x, lmsize_y, lamount);
     set_filter_param(&unsharp->chroma, cmsize_x, cmsize_y, camount);
 
+    unsharp->vsum_line  = ff_unsharp_vsum_line_c;
+    unsharp->blend_line = ff_unsharp_blend_line_c;
+    if (HAVE_MMX)
+        ff_unsharp_init_x86(unsharp);
+
     return 0;
 }
 
@@ -170,7 +191,7 @@ static int query_formats(AVFilterContext *ctx)
     return 0;
 }
 
-static void init_filter_param(AVFilterContext *ctx, FilterParam *fp, const char *effect_type, int width)
+static int init_filter_param(AVFilterContext *ctx, FilterParam *fp, const char *effect_type, int width, int nb_jobs)
 {
     int z;
     const char *effect;
@@ -180,51 +201,94 @@ static void init_filter_param(AVFilterContext *ctx, FilterParam *fp, const char
     av_log(ctx, AV_LOG_VERBOSE, "effect:%s type:%s msize_x:%d msize_y:%d amount:%0.2f\n",
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
+    fp->sc = av_mallocz(sizeof(*fp->sc) * SC_LINES(fp) * nb_jobs);
+    if (!fp->sc)
+        return AVERROR(ENOMEM);
+    for (z = 0; z < SC_LINES(fp) * nb_jobs; z++) {
         fp->sc[z] = av_malloc(sizeof(*(fp->sc[z])) * (width + 2 * fp->steps_x));
+        if (!fp->sc[z])
+            return AVERROR(ENOMEM);
+    }
+    return 0;
 }
 
 static int config_props(AVFilterLink *link)
 {
     UnsharpContext *unsharp = link->dst->priv;
+    int ret;
 
     unsharp->hsub = av_pix_fmt_descriptors[link->format].log2_chroma_w;
     unsharp->vsub = av_pix_fmt_descriptors[link->format].log2_chroma_h;
-
-    init_filter_param(link->dst, &unsharp->luma,   "luma",   link->w);
-    init_filter_param(link->dst, &unsharp->chroma, "chroma", SHIFTUP(link->w, unsharp->hsub));
+    unsharp->nb_threads = FFMIN(ff_filter_get_nb_threads(link->dst),
+                                SHIFTUP(link->h, unsharp->vsub));
+
+    if ((ret = init_filter_param(link->dst, &unsharp->luma,   "luma",   link->w,
+                                 unsharp->nb_threads)) < 0 ||
+        (ret = init_filter_param(link->dst, &unsharp->chroma, "chroma",
+                                 SHIFTUP(link->w, unsharp->hsub),
+                                 unsharp->nb_threads)) < 0)
+        return ret;
 
     return 0;
 }
 
-static void free_filter_param(FilterParam *fp)
+static void free_filter_param(FilterParam *fp, int nb_jobs)
 {
     int z;
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
+    if (!fp->sc)
+        return;
+    for (z = 0; z < SC_LINES(fp) * nb_jobs; z++)
         av_free(fp->sc[z]);
+    av_freep(&fp->sc);
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
     UnsharpContext *unsharp = ctx->priv;
 
-    free_filter_param(&unsharp->luma);
-    free_filter_param(&unsharp->chroma);
+    free_filter_param(&unsharp->luma,   unsharp->nb_threads);
+    free_filter_param(&unsharp->chroma, unsharp->nb_threads);
+}
+
+typedef struct ThreadData {
+    AVFilterBufferRef *in, *out;
+    int w, h, cw, ch;
+} ThreadData;
+
+static int unsharp_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    UnsharpContext *unsharp = ctx->priv;
+    ThreadData *td = arg;
+    AVFilterBufferRef *in  = td->in;
+    AVFilterBufferRef *out = td->out;
+    uint32_t **lsc = unsharp->luma.sc   + jobnr * SC_LINES(&unsharp->luma);
+    uint32_t **csc = unsharp->chroma.sc + jobnr * SC_LINES(&unsharp->chroma);
+    int y0  = td->h  *  jobnr      / nb_jobs;
+    int y1  = td->h  * (jobnr + 1) / nb_jobs;
+    int cy0 = td->ch *  jobnr      / nb_jobs;
+    int cy1 = td->ch * (jobnr + 1) / nb_jobs;
+
+    apply_unsharp(unsharp, out->data[0], out->linesize[0], in->data[0], in->linesize[0], td->w,  td->h,  y0,  y1,  &unsharp->luma,   lsc);
+    apply_unsharp(unsharp, out->data[1], out->linesize[1], in->data[1], in->linesize[1], td->cw, td->ch, cy0, cy1, &unsharp->chroma, csc);
+    apply_unsharp(unsharp, out->data[2], out->linesize[2], in->data[2], in->linesize[2], td->cw, td->ch, cy0, cy1, &unsharp->chroma, csc);
+    return 0;
 }
 
 static int end_frame(AVFilterLink *link)
 {
-    UnsharpContext *unsharp = link->dst->priv;
-    AVFilterBufferRef *in  = link->cur_buf;
-    AVFilterBufferRef *out = link->dst->outputs[0]->out_buf;
-    int cw = SHIFTUP(link->w, unsharp->hsub);
-    int ch = SHIFTUP(link->h, unsharp->vsub);
+    AVFilterContext *ctx = link->dst;
+    UnsharpContext *unsharp = ctx->priv;
+    ThreadData td;
     int ret;
 
-    apply_unsharp(out->data[0], out->linesize[0], in->data[0], in->linesize[0], link->w, link->h, &unsharp->luma);
-    apply_unsharp(out->data[1], out->linesize[1], in->data[1], in->linesize[1], cw,      ch,      &unsharp->chroma);
-    apply_unsharp(out->data[2], out->linesize[2], in->data[2], in->linesize[2], cw,      ch,      &unsharp->chroma);
+    td.in  = link->cur_buf;
+    td.out = ctx->outputs[0]->out_buf;
+    td.w   = link->w;
+    td.h   = link->h;
+    td.cw  = SHIFTUP(link->w, unsharp->hsub);
+    td.ch  = SHIFTUP(link->h, unsharp->vsub);
+    ctx->internal->execute(ctx, unsharp_slice, &td, NULL, unsharp->nb_threads);
 
     if ((ret = ff_draw_slice(link->dst->outputs[0], 0, link->h, 1)) < 0 ||
         (ret = ff_end_frame(link->dst->outputs[0])) < 0)
@@ -246,6 +310,7 @@ AVFilter avfilter_vf_unsharp = {
     .init = init,
     .uninit = uninit,
     .query_formats = query_formats,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_FRAME_THREADS,
 
     .inputs    = (const AVFilterPad[]) {{ .name             = "default",
                                           .type             = AVMEDIA_TYPE_VIDEO,
@@ -90,10 +90,14 @@ static void filter_line_c(uint8_t *dst,
     FILTER
 }
 
-static void filter_line_c_16bit(uint16_t *dst,
-                                uint16_t *prev, uint16_t *cur, uint16_t *next,
+static void filter_line_c_16bit(uint8_t *dst1,
+                                uint8_t *prev1, uint8_t *cur1, uint8_t *next1,
                                 int w, int prefs, int mrefs, int parity, int mode)
 {
+    uint16_t *dst  = (uint16_t *)dst1;
+    uint16_t *prev = (uint16_t *)prev1;
+    uint16_t *cur  = (uint16_t *)cur1;
+    uint16_t *next = (uint16_t *)next1;
     int x;
     uint16_t *prev2 = parity ? prev : cur ;
     uint16_t *next2 = parity ? cur  : next;
@@ -103,10 +107,18 @@ static void filter_line_c_16bit(uint16_t *dst,
     FILTER
 }
 
-static void filter(AVFilterContext *ctx, AVFilterBufferRef *dstpic,
-                   int parity, int tff)
+typedef struct ThreadData {
+    AVFilterBufferRef *dst;
+    int parity, tff;
+} ThreadData;
+
+/* the lines of each plane are split evenly between the jobs */
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     YADIFContext *yadif = ctx->priv;
+    ThreadData *td = arg;
+    AVFilterBufferRef *dstpic = td->dst;
+    int parity = td->parity, tff = td->tff;
     int y, i;
 
     for (i = 0; i < yadif->csp->nb_components; i++) {
@@ -121,7 +133,7 @@ static void filter(AVFilterContext *ctx, AVFilterBufferRef *dstpic,
             h >>= yadif->csp->log2_chroma_h;
         }
 
-        for (y = 0; y < h; y++) {
+        for (y = h * jobnr / nb_jobs; y < h * (jobnr + 1) / nb_jobs; y++) {
             if ((y ^ parity) & 1) {
                 uint8_t *prev = &yadif->prev->data[i][y*refs];
                 uint8_t *cur  = &yadif->cur ->data[i][y*refs];
@@ -137,6 +149,16 @@ static void filter(AVFilterContext *ctx, AVFilterBufferRef *dstpic,
     }
 
     emms_c();
+    return 0;
+}
+
+static void filter(AVFilterContext *ctx, AVFilterBufferRef *dstpic,
+                   int parity, int tff)
+{
+    ThreadData td = { dstpic, parity, tff };
+
+    ctx->internal->execute(ctx, filter_slice, &td, NULL,
+                           FFMIN(dstpic->video->h, ff_filter_get_nb_threads(ctx)));
 }
 
 static AVFilterBufferRef *get_video_buffer(AVFilterLink *link, int perms, int w, int h)
@@ -180,11 +202,6 @@ static int return_frame(AVFilterContext *ctx, int is_second)
         yadif->out->video->interlaced = 0;
     }
 
-    if (!yadif->csp)
-        yadif->csp = &av_pix_fmt_descriptors[link->format];
-    if (yadif->csp->comp[0].depth_minus1 / 8 == 1)
-        yadif->filter_line = filter_line_c_16bit;
-
     filter(ctx, yadif->out, tff ^ !is_second, tff);
 
     if (is_second) {
@@ -385,11 +402,6 @@ static av_cold int init(AVFilterContext *ctx, const char *args)
 
     if (args) sscanf(args, "%d:%d:%d", &yadif->mode, &yadif->parity, &yadif->auto_enable);
 
-    yadif->filter_line = filter_line_c;
-
-    if (HAVE_MMX)
-        ff_yadif_init_x86(yadif);
-
     av_log(ctx, AV_LOG_VERBOSE, "mode:%d parity:%d auto_enable:%d\n", yadif->mode, yadif->parity, yadif->auto_enable);
 
     return 0;
@@ -402,11 +414,22 @@ static int null_draw_slice(AVFilterLink *link, int y, int h, int slice_dir)
 
 static int config_props(AVFilterLink *link)
 {
+    YADIFContext *yadif = link->src->priv;
+
     link->time_base.num = link->src->inputs[0]->time_base.num;
     link->time_base.den = link->src->inputs[0]->time_base.den * 2;
     link->w             = link->src->inputs[0]->w;
     link->h             = link->src->inputs[0]->h;
 
+    yadif->csp = &av_pix_fmt_descriptors[link->format];
+    if (yadif->csp->comp[0].depth_minus1 / 8 == 1)
+        yadif->filter_line = filter_line_c_16bit;
+    else
+        yadif->filter_line = filter_line_c;
+
+    if (HAVE_MMX)
+        ff_yadif_init_x86(yadif);
+
     return 0;
 }
 
@@ -418,6 +441,7 @@ AVFilter avfilter_vf_yadif = {
     .init          = init,
     .uninit        = uninit,
     .query_formats = query_formats,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_FRAME_THREADS,
 
     .inputs    = (const AVFilterPad[]) {{ .name             = "default",
                                           .type             = AVMEDIA_TYPE_VIDEO,
@@ -19,8 +19,11 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "libavutil/buffer.h"
+#include "libavutil/common.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
 
 #include "avfilter.h"
 #include "internal.h"
@@ -74,26 +77,60 @@ AVFilterBufferRef *ff_null_get_video_buffer(AVFilterLink *link, int perms, int w
     return ff_get_video_buffer(link->dst->outputs[0], perms, w, h);
 }
 
-/* TODO: set the buffer's priv member to a context structure for the whole
- * filter chain.  This will allow for a buffer pool instead of the constant
- * alloc & free cycle currently implemented. */
+static void video_pool_free_buffer(AVFilterBuffer *ptr)
+{
+    AVBufferRef *buf = ptr->priv;
+    av_buffer_unref(&buf);
+    av_free(ptr);
+}
+
 AVFilterBufferRef *ff_default_get_video_buffer(AVFilterLink *link, int perms, int w, int h)
 {
-    int linesize[4];
+    int i, size, linesize[4];
     uint8_t *data[4];
+    AVBufferRef *buf;
     AVFilterBufferRef *picref = NULL;
 
-    // +2 is needed for swscaler, +16 to be SIMD-friendly
-    if (av_image_alloc(data, linesize, w, h, link->format, 16) < 0)
+    if (av_image_check_size(w, h, 0, link->dst) < 0 ||
+        av_image_fill_linesizes(linesize, link->format, w) < 0)
         return NULL;
 
+    // +16 to be SIMD-friendly
+    for (i = 0; i < 4; i++)
+        linesize[i] = FFALIGN(linesize[i], 16);
+
+    if ((size = av_image_fill_pointers(data, link->format, h, NULL, linesize)) < 0)
+        return NULL;
+    size += 16;
+
+    /* the pool is shared by all the buffers allocated on this link, so it only
+     * needs to be recreated when the frame size changes */
+    if (!link->pool || link->pool_size != size) {
+        av_buffer_pool_uninit(&link->pool);
+        link->pool      = av_buffer_pool_init(size, NULL);
+        link->pool_size = size;
+        if (!link->pool)
+            return NULL;
+    }
+
+    if (!(buf = av_buffer_pool_get(link->pool)))
+        return NULL;
+
+    av_image_fill_pointers(data, link->format, h, buf->data, linesize);
+    if (av_pix_fmt_descriptors[link->format].flags & PIX_FMT_PAL ||
+        av_pix_fmt_descriptors[link->format].flags & PIX_FMT_PSEUDOPAL)
+        ff_set_systematic_pal2((uint32_t*)data[1], link->format);
+
     picref = avfilter_get_video_buffer_ref_from_arrays(data, linesize,
                                                        perms, w, h, link->format);
     if (!picref) {
-        av_free(data[0]);
+        av_buffer_unref(&buf);
         return NULL;
     }
 
+    picref->buf->priv = buf;
+    picref->buf->free = video_pool_free_buffer;
+
     return picref;
 }
 
@@ -244,7 +281,8 @@ int ff_start_frame(AVFilterLink *link, AVFilterBufferRef *picref)
 {
     int (*start_frame)(AVFilterLink *, AVFilterBufferRef *);
     AVFilterPad *dst = link->dstpad;
-    int ret, perms = picref->perms;
+    int ret, timed, perms = picref->perms;
+    FFStatsTimer t;
 
     FF_DPRINTF_START(NULL, start_frame); ff_dlog_link(NULL, link, 0); av_dlog(NULL, " "); ff_dlog_ref(NULL, picref, 1);
 
@@ -272,7 +310,11 @@ int ff_start_frame(AVFilterLink *link, AVFilterBufferRef *picref)
     else
         link->cur_buf = picref;
 
+    ff_stats_count_frame(link);
+    timed = ff_stats_start(link->dst, &t);
     ret = start_frame(link, link->cur_buf);
+    if (timed)
+        ff_stats_stop(link->dst, AVFILTER_STATS_START_FRAME, &t);
     if (ret < 0)
         clear_link(link);
 
@@ -300,12 +342,16 @@ static int default_end_frame(AVFilterLink *inlink)
 int ff_end_frame(AVFilterLink *link)
 {
     int (*end_frame)(AVFilterLink *);
-    int ret;
+    int ret, timed;
+    FFStatsTimer t;
 
     if (!(end_frame = link->dstpad->end_frame))
         end_frame = default_end_frame;
 
+    timed = ff_stats_start(link->dst, &t);
     ret = end_frame(link);
+    if (timed)
+        ff_stats_stop(link->dst, AVFILTER_STATS_END_FRAME, &t);
 
     clear_link(link);
 
@@ -332,8 +378,9 @@ static int default_draw_slice(AVFilterLink *inlink, int y, int h, int slice_dir)
 int ff_draw_slice(AVFilterLink *link, int y, int h, int slice_dir)
 {
     uint8_t *src[4], *dst[4];
-    int i, j, vsub, ret;
+    int i, j, vsub, ret, timed;
     int (*draw_slice)(AVFilterLink *, int, int, int);
+    FFStatsTimer t;
 
     FF_DPRINTF_START(NULL, draw_slice); ff_dlog_link(NULL, link, 0); av_dlog(NULL, " y:%d h:%d dir:%d\n", y, h, slice_dir);
 
@@ -367,7 +414,10 @@ int ff_draw_slice(AVFilterLink *link, int y, int h, int slice_dir)
 
     if (!(draw_slice = link->dstpad->draw_slice))
         draw_slice = default_draw_slice;
+    timed = ff_stats_start(link->dst, &t);
     ret = draw_slice(link, y, h, slice_dir);
+    if (timed)
+        ff_stats_stop(link->dst, AVFILTER_STATS_DRAW_SLICE, &t);
     if (ret < 0)
         clear_link(link);
     return ret;
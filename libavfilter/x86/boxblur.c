@@ -0,0 +1,86 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Libav; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/asm.h"
+#include "libavfilter/boxblur.h"
+
+#if HAVE_INLINE_ASM
+
+#if HAVE_SSE
+static void boxblur_vblur_line_sse2(uint8_t *dst, uint16_t *sum,
+                                    const uint8_t *add, const uint8_t *sub,
+                                    int width, int inv)
+{
+    intptr_t x;
+
+    if (width & 7) {
+        x = width & ~7;
+        ff_boxblur_vblur_line_c(dst + x, sum + x, add + x, sub + x,
+                                width - x, inv);
+        width = x;
+    }
+    if (!width)
+        return;
+    x = -width;
+    __asm__ volatile(
+        "movd             %5, %%xmm6 \n"
+        "pxor         %%xmm7, %%xmm7 \n"
+        "pshuflw $0, %%xmm6, %%xmm6 \n"
+        "punpcklqdq   %%xmm6, %%xmm6 \n"
+        "1: \n"
+        "movq       (%3,%0), %%xmm0 \n"
+        "movq       (%4,%0), %%xmm1 \n"
+        "movdqu   (%2,%0,2), %%xmm2 \n"
+        "punpcklbw    %%xmm7, %%xmm0 \n"
+        "punpcklbw    %%xmm7, %%xmm1 \n"
+        "paddw        %%xmm0, %%xmm2 \n"
+        "psubw        %%xmm1, %%xmm2 \n" // sum += add - sub
+        "movdqu       %%xmm2, (%2,%0,2) \n"
+        "movdqa       %%xmm2, %%xmm3 \n"
+        "pmulhuw      %%xmm6, %%xmm2 \n"
+        "pmullw       %%xmm6, %%xmm3 \n"
+        "psrlw           $15, %%xmm3 \n"
+        "paddw        %%xmm3, %%xmm2 \n" // (sum * inv + (1 << 15)) >> 16
+        "packuswb     %%xmm2, %%xmm2 \n"
+        "movq         %%xmm2, (%1,%0) \n"
+        "add              $8, %0 \n"
+        "jl 1b \n"
+        :"+&r"(x)
+        :"r"(dst+width), "r"(sum+width), "r"(add+width), "r"(sub+width),
+         "rm"(inv)
+        :XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                      "%xmm6", "%xmm7",) "memory"
+    );
+}
+#endif /* HAVE_SSE */
+
+#endif /* HAVE_INLINE_ASM */
+
+av_cold void ff_boxblur_init_x86(BoxBlurContext *boxblur)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+#if HAVE_INLINE_ASM
+#if HAVE_SSE
+    if (cpu_flags & AV_CPU_FLAG_SSE2)
+        boxblur->vblur_line = boxblur_vblur_line_sse2;
+#endif
+#endif /* HAVE_INLINE_ASM */
+}
@@ -0,0 +1,145 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/asm.h"
+#include "libavfilter/overlay.h"
+
+#if HAVE_INLINE_ASM
+
+DECLARE_ALIGNED(16, static const uint16_t, pw_ff)[8]  = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
+DECLARE_ALIGNED(16, static const uint16_t, pw_80)[8]  = {0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80};
+DECLARE_ALIGNED(16, static const uint16_t, pw_101)[8] = {0x101,0x101,0x101,0x101,0x101,0x101,0x101,0x101};
+
+/* blend the words of xmm1 (src) into xmm2 (dst) with the alpha words of
+ * xmm0, the result is packed to bytes in xmm2 */
+#define BLEND_WORDS                                                        \
+        "pmullw       %%xmm0, %%xmm1 \n" /* src * a */                     \
+        "pxor         %%xmm6, %%xmm0 \n"                                   \
+        "pmullw       %%xmm0, %%xmm2 \n" /* dst * (255 - a) */             \
+        "paddw        %%xmm1, %%xmm2 \n"                                   \
+        "paddw        %%xmm5, %%xmm2 \n"                                   \
+        "pmulhuw      %%xmm4, %%xmm2 \n" /* (x + 128) * 257 >> 16 */       \
+        "packuswb     %%xmm2, %%xmm2 \n"
+
+#if HAVE_SSE
+static void overlay_blend_row_sse2(uint8_t *dst, const uint8_t *src,
+                                   const uint8_t *alpha, int width)
+{
+    intptr_t x;
+
+    if (width & 7) {
+        x = width & ~7;
+        ff_overlay_blend_row_c(dst + x, src + x, alpha + x, width - x);
+        width = x;
+    }
+    if (!width)
+        return;
+    x = -width;
+    __asm__ volatile(
+        "pxor         %%xmm7, %%xmm7 \n"
+        "movdqa           %4, %%xmm6 \n"
+        "movdqa           %5, %%xmm5 \n"
+        "movdqa           %6, %%xmm4 \n"
+        "1: \n"
+        "movq       (%3,%0), %%xmm0 \n"
+        "movq       (%2,%0), %%xmm1 \n"
+        "movq       (%1,%0), %%xmm2 \n"
+        "punpcklbw    %%xmm7, %%xmm0 \n"
+        "punpcklbw    %%xmm7, %%xmm1 \n"
+        "punpcklbw    %%xmm7, %%xmm2 \n"
+        BLEND_WORDS
+        "movq         %%xmm2, (%1,%0) \n"
+        "add              $8, %0 \n"
+        "jl 1b \n"
+        :"+&r"(x)
+        :"r"(dst+width), "r"(src+width), "r"(alpha+width),
+         "m"(*pw_ff), "m"(*pw_80), "m"(*pw_101)
+        :XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                      "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+    );
+}
+
+static void overlay_blend_row_yuv420_sse2(uint8_t *dst, const uint8_t *src,
+                                          const uint8_t *alpha,
+                                          int alpha_linesize, int width)
+{
+    intptr_t x;
+
+    if (width & 7) {
+        x = width & ~7;
+        ff_overlay_blend_row_yuv420_c(dst + x, src + x, alpha + 2 * x,
+                                      alpha_linesize, width - x);
+        width = x;
+    }
+    if (!width)
+        return;
+    x = -width;
+    __asm__ volatile(
+        "pxor         %%xmm7, %%xmm7 \n"
+        "movdqa           %5, %%xmm6 \n"
+        "movdqa           %6, %%xmm5 \n"
+        "movdqa           %7, %%xmm4 \n"
+        "1: \n"
+        "movdqu   (%3,%0,2), %%xmm0 \n"
+        "movdqu   (%4,%0,2), %%xmm1 \n"
+        "movdqa       %%xmm0, %%xmm2 \n"
+        "movdqa       %%xmm1, %%xmm3 \n"
+        "pand         %%xmm6, %%xmm0 \n"
+        "pand         %%xmm6, %%xmm1 \n"
+        "psrlw            $8, %%xmm2 \n"
+        "psrlw            $8, %%xmm3 \n"
+        "paddw        %%xmm1, %%xmm0 \n"
+        "paddw        %%xmm3, %%xmm2 \n"
+        "paddw        %%xmm2, %%xmm0 \n"
+        "psrlw            $2, %%xmm0 \n" // average of the 2x2 alpha block
+        "movq       (%2,%0), %%xmm1 \n"
+        "movq       (%1,%0), %%xmm2 \n"
+        "punpcklbw    %%xmm7, %%xmm1 \n"
+        "punpcklbw    %%xmm7, %%xmm2 \n"
+        BLEND_WORDS
+        "movq         %%xmm2, (%1,%0) \n"
+        "add              $8, %0 \n"
+        "jl 1b \n"
+        :"+&r"(x)
+        :"r"(dst+width), "r"(src+width), "r"(alpha+2*width),
+         "r"(alpha+alpha_linesize+2*width),
+         "m"(*pw_ff), "m"(*pw_80), "m"(*pw_101)
+        :XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                      "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+    );
+}
+#endif /* HAVE_SSE */
+
+#endif /* HAVE_INLINE_ASM */
+
+av_cold void ff_overlay_init_x86(OverlayContext *over)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+#if HAVE_INLINE_ASM
+#if HAVE_SSE
+    if (cpu_flags & AV_CPU_FLAG_SSE2) {
+        over->blend_row        = overlay_blend_row_sse2;
+        over->blend_row_yuv420 = overlay_blend_row_yuv420_sse2;
+    }
+#endif
+#endif /* HAVE_INLINE_ASM */
+}
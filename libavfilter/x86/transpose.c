@@ -0,0 +1,143 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/asm.h"
+#include "libavfilter/transpose.h"
+
+#if HAVE_INLINE_ASM
+
+#if HAVE_SSE
+static void transpose_8x8_8_sse2(uint8_t *src, int src_linesize,
+                                 uint8_t *dst, int dst_linesize)
+{
+    x86_reg src_stride = src_linesize, dst_stride = dst_linesize;
+
+    __asm__ volatile(
+        "movq          (%0), %%xmm0 \n"
+        "movq       (%0,%2), %%xmm1 \n"
+        "lea      (%0,%2,2), %0 \n"
+        "movq          (%0), %%xmm2 \n"
+        "movq       (%0,%2), %%xmm3 \n"
+        "lea      (%0,%2,2), %0 \n"
+        "movq          (%0), %%xmm4 \n"
+        "movq       (%0,%2), %%xmm5 \n"
+        "lea      (%0,%2,2), %0 \n"
+        "movq          (%0), %%xmm6 \n"
+        "movq       (%0,%2), %%xmm7 \n"
+        "punpcklbw    %%xmm1, %%xmm0 \n"
+        "punpcklbw    %%xmm3, %%xmm2 \n"
+        "punpcklbw    %%xmm5, %%xmm4 \n"
+        "punpcklbw    %%xmm7, %%xmm6 \n"
+        "movdqa       %%xmm0, %%xmm1 \n"
+        "punpcklwd    %%xmm2, %%xmm0 \n" // columns 0-3 of rows 0-3
+        "punpckhwd    %%xmm2, %%xmm1 \n" // columns 4-7 of rows 0-3
+        "movdqa       %%xmm4, %%xmm5 \n"
+        "punpcklwd    %%xmm6, %%xmm4 \n" // columns 0-3 of rows 4-7
+        "punpckhwd    %%xmm6, %%xmm5 \n" // columns 4-7 of rows 4-7
+        "movdqa       %%xmm0, %%xmm2 \n"
+        "punpckldq    %%xmm4, %%xmm0 \n" // columns 0-1
+        "punpckhdq    %%xmm4, %%xmm2 \n" // columns 2-3
+        "movdqa       %%xmm1, %%xmm3 \n"
+        "punpckldq    %%xmm5, %%xmm1 \n" // columns 4-5
+        "punpckhdq    %%xmm5, %%xmm3 \n" // columns 6-7
+        "movq         %%xmm0, (%1) \n"
+        "movhps       %%xmm0, (%1,%3) \n"
+        "lea      (%1,%3,2), %1 \n"
+        "movq         %%xmm2, (%1) \n"
+        "movhps       %%xmm2, (%1,%3) \n"
+        "lea      (%1,%3,2), %1 \n"
+        "movq         %%xmm1, (%1) \n"
+        "movhps       %%xmm1, (%1,%3) \n"
+        "lea      (%1,%3,2), %1 \n"
+        "movq         %%xmm3, (%1) \n"
+        "movhps       %%xmm3, (%1,%3) \n"
+        :"+&r"(src), "+&r"(dst)
+        :"r"(src_stride), "r"(dst_stride)
+        :XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                      "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+    );
+}
+
+static av_always_inline void transpose_4x4_32_sse2(uint8_t *src, x86_reg src_stride,
+                                                   uint8_t *dst, x86_reg dst_stride)
+{
+    __asm__ volatile(
+        "movdqu        (%0), %%xmm0 \n"
+        "movdqu     (%0,%2), %%xmm1 \n"
+        "lea      (%0,%2,2), %0 \n"
+        "movdqu        (%0), %%xmm2 \n"
+        "movdqu     (%0,%2), %%xmm3 \n"
+        "movdqa       %%xmm0, %%xmm4 \n"
+        "punpckldq    %%xmm1, %%xmm0 \n"
+        "punpckhdq    %%xmm1, %%xmm4 \n"
+        "movdqa       %%xmm2, %%xmm5 \n"
+        "punpckldq    %%xmm3, %%xmm2 \n"
+        "punpckhdq    %%xmm3, %%xmm5 \n"
+        "movdqa       %%xmm0, %%xmm1 \n"
+        "punpcklqdq   %%xmm2, %%xmm0 \n" // column 0
+        "punpckhqdq   %%xmm2, %%xmm1 \n" // column 1
+        "movdqa       %%xmm4, %%xmm3 \n"
+        "punpcklqdq   %%xmm5, %%xmm4 \n" // column 2
+        "punpckhqdq   %%xmm5, %%xmm3 \n" // column 3
+        "movdqu       %%xmm0, (%1) \n"
+        "movdqu       %%xmm1, (%1,%3) \n"
+        "lea      (%1,%3,2), %1 \n"
+        "movdqu       %%xmm4, (%1) \n"
+        "movdqu       %%xmm3, (%1,%3) \n"
+        :"+&r"(src), "+&r"(dst)
+        :"r"(src_stride), "r"(dst_stride)
+        :XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                      "%xmm4", "%xmm5",) "memory"
+    );
+}
+
+static void transpose_8x8_32_sse2(uint8_t *src, int src_linesize,
+                                  uint8_t *dst, int dst_linesize)
+{
+    x86_reg src_stride = src_linesize, dst_stride = dst_linesize;
+
+    transpose_4x4_32_sse2(src,                       src_stride,
+                          dst,                       dst_stride);
+    transpose_4x4_32_sse2(src + 4 * src_stride,      src_stride,
+                          dst + 16,                  dst_stride);
+    transpose_4x4_32_sse2(src + 16,                  src_stride,
+                          dst + 4 * dst_stride,      dst_stride);
+    transpose_4x4_32_sse2(src + 4 * src_stride + 16, src_stride,
+                          dst + 4 * dst_stride + 16, dst_stride);
+}
+#endif /* HAVE_SSE */
+
+#endif /* HAVE_INLINE_ASM */
+
+av_cold void ff_transpose_init_x86(TransVtable *v, int pixstep)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+#if HAVE_INLINE_ASM
+#if HAVE_SSE
+    if (cpu_flags & AV_CPU_FLAG_SSE2) {
+        if (pixstep == 1)
+            v->transpose_8x8 = transpose_8x8_8_sse2;
+        else if (pixstep == 4)
+            v->transpose_8x8 = transpose_8x8_32_sse2;
+    }
+#endif
+#endif /* HAVE_INLINE_ASM */
+}
@@ -0,0 +1,144 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/asm.h"
+#include "libavfilter/unsharp.h"
+
+#if HAVE_INLINE_ASM
+
+#if HAVE_SSE
+static void unsharp_vsum_line_sse2(uint32_t *line, uint32_t *sc0, uint32_t *sc1,
+                                   int width)
+{
+    intptr_t x;
+
+    if (width & 3) {
+        x = width & ~3;
+        ff_unsharp_vsum_line_c(line + x, sc0 + x, sc1 + x, width - x);
+        width = x;
+    }
+    if (!width)
+        return;
+    x = -width;
+    __asm__ volatile(
+        "1: \n"
+        "movdqu   (%1,%0,4), %%xmm0 \n"
+        "movdqu   (%2,%0,4), %%xmm1 \n"
+        "movdqu   (%3,%0,4), %%xmm2 \n"
+        "movdqu       %%xmm0, (%2,%0,4) \n"
+        "paddd        %%xmm0, %%xmm1 \n"
+        "movdqu       %%xmm1, (%3,%0,4) \n"
+        "paddd        %%xmm1, %%xmm2 \n"
+        "movdqu       %%xmm2, (%1,%0,4) \n"
+        "add              $4, %0 \n"
+        "jl 1b \n"
+        :"+&r"(x)
+        :"r"(line+width), "r"(sc0+width), "r"(sc1+width)
+        :XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2",) "memory"
+    );
+}
+
+static void unsharp_blend_line_sse2(uint8_t *dst, const uint8_t *src,
+                                    const uint32_t *line, int width,
+                                    const FilterParam *fp)
+{
+    DECLARE_ALIGNED(16, uint32_t, half)[4];
+    DECLARE_ALIGNED(16, int16_t,  ah)[8];
+    DECLARE_ALIGNED(16, int16_t,  al)[8];
+    DECLARE_ALIGNED(16, int16_t,  mask)[8];
+    int amount_hi = fp->amount >> 16;
+    intptr_t x;
+    int i;
+
+    /* d * amount is split into d * (amount >> 16) and the high word of
+     * d * (amount & 0xffff), which has to fit in 16 bits */
+    if (amount_hi < -128 || amount_hi > 127 || fp->scalebits > 31) {
+        ff_unsharp_blend_line_c(dst, src, line, width, fp);
+        return;
+    }
+    if (width & 7) {
+        x = width & ~7;
+        ff_unsharp_blend_line_c(dst + x, src + x, line + x, width - x, fp);
+        width = x;
+    }
+    if (!width)
+        return;
+
+    for (i = 0; i < 4; i++)
+        half[i] = fp->halfscale;
+    for (i = 0; i < 8; i++) {
+        ah[i]   = amount_hi;
+        al[i]   = fp->amount & 0xffff;
+        mask[i] = fp->amount & 0x8000 ? -1 : 0;
+    }
+
+    x = -width;
+    __asm__ volatile(
+        "movd             %8, %%xmm5 \n"
+        "pxor         %%xmm7, %%xmm7 \n"
+        "1: \n"
+        "movdqu   (%3,%0,4), %%xmm0 \n"
+        "movdqu 16(%3,%0,4), %%xmm1 \n"
+        "paddd            %4, %%xmm0 \n"
+        "paddd            %4, %%xmm1 \n"
+        "psrld        %%xmm5, %%xmm0 \n"
+        "psrld        %%xmm5, %%xmm1 \n"
+        "packssdw     %%xmm1, %%xmm0 \n" // blurred pixels
+        "movq       (%2,%0), %%xmm1 \n"
+        "punpcklbw    %%xmm7, %%xmm1 \n"
+        "movdqa       %%xmm1, %%xmm2 \n"
+        "psubw        %%xmm0, %%xmm2 \n" // d = src - blurred
+        "movdqa       %%xmm2, %%xmm3 \n"
+        "movdqa       %%xmm2, %%xmm4 \n"
+        "pmullw           %5, %%xmm3 \n"
+        "pmulhw           %6, %%xmm4 \n"
+        "pand             %7, %%xmm2 \n"
+        "paddsw       %%xmm4, %%xmm2 \n"
+        "paddsw       %%xmm3, %%xmm2 \n" // d * amount >> 16
+        "paddsw       %%xmm2, %%xmm1 \n"
+        "packuswb     %%xmm1, %%xmm1 \n"
+        "movq         %%xmm1, (%1,%0) \n"
+        "add              $8, %0 \n"
+        "jl 1b \n"
+        :"+&r"(x)
+        :"r"(dst+width), "r"(src+width), "r"(line+width),
+         "m"(half), "m"(ah), "m"(al), "m"(mask), "rm"(fp->scalebits)
+        :XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                      "%xmm4", "%xmm5", "%xmm7",) "memory"
+    );
+}
+#endif /* HAVE_SSE */
+
+#endif /* HAVE_INLINE_ASM */
+
+av_cold void ff_unsharp_init_x86(UnsharpContext *unsharp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+#if HAVE_INLINE_ASM
+#if HAVE_SSE
+    if (cpu_flags & AV_CPU_FLAG_SSE2) {
+        unsharp->vsum_line  = unsharp_vsum_line_sse2;
+        unsharp->blend_line = unsharp_blend_line_sse2;
+    }
+#endif
+#endif /* HAVE_INLINE_ASM */
+}
@@ -58,8 +58,23 @@ DECLARE_ASM_CONST(16, const xmm_reg, pw_1) = {0x0001000100010001ULL, 0x000100010
 av_cold void ff_yadif_init_x86(YADIFContext *yadif)
 {
     int cpu_flags = av_get_cpu_flags();
+    int bit_depth = yadif->csp->comp[0].depth_minus1 + 1;
 
 #if HAVE_INLINE_ASM
+    if (bit_depth > 8) {
+        /* the word arithmetic is exact for up to 12 bits per pixel */
+        if (bit_depth > 12)
+            return;
+#if HAVE_SSE
+        if (cpu_flags & AV_CPU_FLAG_SSE2)
+            yadif->filter_line = yadif_filter_line_16bit_sse2;
+#endif
+#if HAVE_SSSE3
+        if (cpu_flags & AV_CPU_FLAG_SSSE3)
+            yadif->filter_line = yadif_filter_line_16bit_ssse3;
+#endif
+        return;
+    }
 #if HAVE_MMXEXT
     if (cpu_flags & AV_CPU_FLAG_MMXEXT)
         yadif->filter_line = yadif_filter_line_mmx2;
@@ -245,6 +245,172 @@ static void RENAME(yadif_filter_line)(uint8_t *dst, uint8_t *prev, uint8_t *cur,
 #undef next2
     }
 }
+#ifdef COMPILE_TEMPLATE_SSE
+/* The 16-bit version works on the pixels directly instead of unpacking
+ * bytes, it is exact as long as the scores and the (1 << 14) penalty of
+ * CHECK2 fit in a signed word, i.e. for up to 12 bits per pixel. */
+#define LOAD16(mem,dst) \
+            MOVQU"     "mem", "dst" \n\t"
+
+#define ABSDIFF16(pj,mj,dst) \
+            MOVQU" "#pj"(%[cur],%[mrefs]), "dst" \n\t"\
+            MOVQU" "#mj"(%[cur],%[prefs]), "MM"4 \n\t"\
+            "psubw     "MM"4, "dst" \n\t"\
+            PABS(      MM"4", dst)
+
+#define CHECK16(pj,mj) \
+            ABSDIFF16(pj,mj,MM"2")          /* ABS(cur[x-refs-1+j] - cur[x+refs-1-j]) */\
+            MOVQU" 2+"#pj"(%[cur],%[mrefs]), "MM"3 \n\t" /* cur[x-refs+j] */\
+            MOVQU" 2+"#mj"(%[cur],%[prefs]), "MM"4 \n\t" /* cur[x+refs-j] */\
+            MOVQ"      "MM"3, "MM"5 \n\t"\
+            "paddw     "MM"4, "MM"5 \n\t"\
+            "psrlw     $1,    "MM"5 \n\t" /* (cur[x-refs+j] + cur[x+refs-j])>>1 */\
+            "psubw     "MM"4, "MM"3 \n\t"\
+            PABS(      MM"4", MM"3")\
+            "paddw     "MM"3, "MM"2 \n\t"\
+            ABSDIFF16(4+pj,4+mj,MM"3")      /* ABS(cur[x-refs+1+j] - cur[x+refs+1-j]) */\
+            "paddw     "MM"3, "MM"2 \n\t" /* score */
+
+static void RENAME(yadif_filter_line_16bit)(uint8_t *dst, uint8_t *prev,
+                                            uint8_t *cur, uint8_t *next,
+                                            int w, int prefs, int mrefs,
+                                            int parity, int mode)
+{
+    DECLARE_ALIGNED(16, uint16_t, tmp)[8*4];
+    int x;
+
+#define FILTER16\
+    for(x=0; x<w; x+=8){\
+        __asm__ volatile(\
+            LOAD16("(%[cur],%[mrefs])", MM"0") /* c = cur[x-refs] */\
+            LOAD16("(%[cur],%[prefs])", MM"1") /* e = cur[x+refs] */\
+            LOAD16("(%["prev2"])", MM"2") /* prev2[x] */\
+            LOAD16("(%["next2"])", MM"3") /* next2[x] */\
+            MOVQ"      "MM"3, "MM"4 \n\t"\
+            "paddw     "MM"2, "MM"3 \n\t"\
+            "psraw     $1,    "MM"3 \n\t" /* d = (prev2[x] + next2[x])>>1 */\
+            MOVQ"      "MM"0,   (%[tmp]) \n\t" /* c */\
+            MOVQ"      "MM"3, 16(%[tmp]) \n\t" /* d */\
+            MOVQ"      "MM"1, 32(%[tmp]) \n\t" /* e */\
+            "psubw     "MM"4, "MM"2 \n\t"\
+            PABS(      MM"4", MM"2") /* temporal_diff0 */\
+            LOAD16("(%[prev],%[mrefs])", MM"3") /* prev[x-refs] */\
+            LOAD16("(%[prev],%[prefs])", MM"4") /* prev[x+refs] */\
+            "psubw     "MM"0, "MM"3 \n\t"\
+            "psubw     "MM"1, "MM"4 \n\t"\
+            PABS(      MM"5", MM"3")\
+            PABS(      MM"5", MM"4")\
+            "paddw     "MM"4, "MM"3 \n\t" /* temporal_diff1 */\
+            "psrlw     $1,    "MM"2 \n\t"\
+            "psrlw     $1,    "MM"3 \n\t"\
+            "pmaxsw    "MM"3, "MM"2 \n\t"\
+            LOAD16("(%[next],%[mrefs])", MM"3") /* next[x-refs] */\
+            LOAD16("(%[next],%[prefs])", MM"4") /* next[x+refs] */\
+            "psubw     "MM"0, "MM"3 \n\t"\
+            "psubw     "MM"1, "MM"4 \n\t"\
+            PABS(      MM"5", MM"3")\
+            PABS(      MM"5", MM"4")\
+            "paddw     "MM"4, "MM"3 \n\t" /* temporal_diff2 */\
+            "psrlw     $1,    "MM"3 \n\t"\
+            "pmaxsw    "MM"3, "MM"2 \n\t"\
+            MOVQ"      "MM"2, 48(%[tmp]) \n\t" /* diff */\
+\
+            "paddw     "MM"0, "MM"1 \n\t"\
+            "paddw     "MM"0, "MM"0 \n\t"\
+            "psubw     "MM"1, "MM"0 \n\t"\
+            "psrlw     $1,    "MM"1 \n\t" /* spatial_pred */\
+            PABS(      MM"2", MM"0")      /* ABS(c-e) */\
+\
+            ABSDIFF16(-2,-2,MM"2")         /* ABS(cur[x-refs-1] - cur[x+refs-1]) */\
+            "paddw     "MM"2, "MM"0 \n\t"\
+            ABSDIFF16(2,2,MM"2")           /* ABS(cur[x-refs+1] - cur[x+refs+1]) */\
+            "paddw     "MM"2, "MM"0 \n\t"\
+            "psubw    "MANGLE(pw_1)", "MM"0 \n\t" /* spatial_score */\
+\
+            CHECK16(-4,0)\
+            CHECK1\
+            CHECK16(-6,2)\
+            CHECK2\
+            CHECK16(0,-4)\
+            CHECK1\
+            CHECK16(2,-6)\
+            CHECK2\
+\
+            /* if(p->mode<2) ... */\
+            MOVQ" 48(%[tmp]), "MM"6 \n\t" /* diff */\
+            "cmpl      $2, %[mode] \n\t"\
+            "jge       1f \n\t"\
+            LOAD16("(%["prev2"],%[mrefs],2)", MM"2") /* prev2[x-2*refs] */\
+            LOAD16("(%["next2"],%[mrefs],2)", MM"4") /* next2[x-2*refs] */\
+            LOAD16("(%["prev2"],%[prefs],2)", MM"3") /* prev2[x+2*refs] */\
+            LOAD16("(%["next2"],%[prefs],2)", MM"5") /* next2[x+2*refs] */\
+            "paddw     "MM"4, "MM"2 \n\t"\
+            "paddw     "MM"5, "MM"3 \n\t"\
+            "psrlw     $1,    "MM"2 \n\t" /* b */\
+            "psrlw     $1,    "MM"3 \n\t" /* f */\
+            MOVQ"   (%[tmp]), "MM"4 \n\t" /* c */\
+            MOVQ" 16(%[tmp]), "MM"5 \n\t" /* d */\
+            MOVQ" 32(%[tmp]), "MM"7 \n\t" /* e */\
+            "psubw     "MM"4, "MM"2 \n\t" /* b-c */\
+            "psubw     "MM"7, "MM"3 \n\t" /* f-e */\
+            MOVQ"      "MM"5, "MM"0 \n\t"\
+            "psubw     "MM"4, "MM"5 \n\t" /* d-c */\
+            "psubw     "MM"7, "MM"0 \n\t" /* d-e */\
+            MOVQ"      "MM"2, "MM"4 \n\t"\
+            "pminsw    "MM"3, "MM"2 \n\t"\
+            "pmaxsw    "MM"4, "MM"3 \n\t"\
+            "pmaxsw    "MM"5, "MM"2 \n\t"\
+            "pminsw    "MM"5, "MM"3 \n\t"\
+            "pmaxsw    "MM"0, "MM"2 \n\t" /* max */\
+            "pminsw    "MM"0, "MM"3 \n\t" /* min */\
+            "pxor      "MM"4, "MM"4 \n\t"\
+            "pmaxsw    "MM"3, "MM"6 \n\t"\
+            "psubw     "MM"2, "MM"4 \n\t" /* -max */\
+            "pmaxsw    "MM"4, "MM"6 \n\t" /* diff= MAX3(diff, min, -max); */\
+            "1: \n\t"\
+\
+            MOVQ" 16(%[tmp]), "MM"2 \n\t" /* d */\
+            MOVQ"      "MM"2, "MM"3 \n\t"\
+            "psubw     "MM"6, "MM"2 \n\t" /* d-diff */\
+            "paddw     "MM"6, "MM"3 \n\t" /* d+diff */\
+            "pmaxsw    "MM"2, "MM"1 \n\t"\
+            "pminsw    "MM"3, "MM"1 \n\t" /* d = clip(spatial_pred, d-diff, d+diff); */\
+\
+            ::[prev] "r"(prev),\
+             [cur]  "r"(cur),\
+             [next] "r"(next),\
+             [prefs]"r"((x86_reg)prefs),\
+             [mrefs]"r"((x86_reg)mrefs),\
+             [mode] "g"(mode),\
+             [tmp]  "r"(tmp)\
+        );\
+        __asm__ volatile(MOVQU" "MM"1, %0" :"=m"(*(xmm_reg *)dst));\
+        dst += 16;\
+        prev+= 16;\
+        cur += 16;\
+        next+= 16;\
+    }
+
+    if (parity) {
+#define prev2 "prev"
+#define next2 "cur"
+        FILTER16
+#undef prev2
+#undef next2
+    } else {
+#define prev2 "cur"
+#define next2 "next"
+        FILTER16
+#undef prev2
+#undef next2
+    }
+}
+#undef LOAD16
+#undef ABSDIFF16
+#undef CHECK16
+#undef FILTER16
+#endif /* COMPILE_TEMPLATE_SSE */
+
 #undef STEP
 #undef MM
 #undef MOV
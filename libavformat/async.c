@@ -0,0 +1,301 @@
+/*
+ * Asynchronous read-ahead protocol
+ *
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Asynchronous read-ahead protocol
+ *
+ * A thread reads the nested url into a ring buffer ahead of the reader.
+ * Seeks within the buffered data are served from the ring buffer, other
+ * seeks interrupt the read in progress and restart reading at the new
+ * position.
+ */
+
+#include <pthread.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/opt.h"
+#include "libavutil/time.h"
+#include "avformat.h"
+#include "url.h"
+
+#define READ_CHUNK_SIZE 32768
+
+typedef struct {
+    const AVClass *class;
+    URLContext *hd;
+    int buffer_size;
+    int64_t file_size;
+
+    uint8_t *buf;                   ///< ring buffer of buffer_size bytes
+    int64_t buf_start;              ///< stream position of the oldest byte kept
+    int64_t buf_end;                ///< stream position after the newest byte
+    int64_t read_pos;               ///< stream position of the reader
+    int eof;
+    int io_error;
+
+    int seek_request;               ///< set by the reader, cleared by the thread
+    int64_t seek_pos;
+    int seek_completed;
+    int64_t seek_ret;
+    int abort_request;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_wakeup_thread;
+    pthread_cond_t cond_wakeup_reader;
+} AsyncContext;
+
+static int async_check_interrupt(void *arg)
+{
+    URLContext *h = arg;
+    AsyncContext *c = h->priv_data;
+
+    return c->abort_request || c->seek_request ||
+           ff_check_interrupt(&h->interrupt_callback);
+}
+
+/* Up to a quarter of the buffer keeps data already consumed, for short
+ * backward seeks, the rest is free for reading ahead. */
+static int write_space(AsyncContext *c)
+{
+    if (c->read_pos - c->buf_start > c->buffer_size / 4)
+        c->buf_start = c->read_pos - c->buffer_size / 4;
+    return c->buffer_size - (c->buf_end - c->buf_start);
+}
+
+static void *async_buffer_task(void *arg)
+{
+    URLContext *h = arg;
+    AsyncContext *c = h->priv_data;
+
+    pthread_mutex_lock(&c->mutex);
+    for (;;) {
+        int64_t pos;
+        int offset, len, ret;
+
+        while (!c->abort_request && !c->seek_request &&
+               (c->eof || write_space(c) <= 0))
+            pthread_cond_wait(&c->cond_wakeup_thread, &c->mutex);
+        if (c->abort_request)
+            break;
+
+        if (c->seek_request) {
+            pos = c->seek_pos;
+            c->seek_request = 0;
+            pthread_mutex_unlock(&c->mutex);
+            pos = ffurl_seek(c->hd, pos, SEEK_SET);
+            pthread_mutex_lock(&c->mutex);
+            if (pos >= 0) {
+                c->buf_start = c->buf_end = c->read_pos = pos;
+                c->eof       = 0;
+                c->io_error  = 0;
+            }
+            c->seek_ret       = pos;
+            c->seek_completed = 1;
+            pthread_cond_signal(&c->cond_wakeup_reader);
+            continue;
+        }
+
+        offset = c->buf_end % c->buffer_size;
+        len    = FFMIN(write_space(c), c->buffer_size - offset);
+        len    = FFMIN(len, READ_CHUNK_SIZE);
+        pthread_mutex_unlock(&c->mutex);
+
+        /* the region written to is not visible to the reader yet */
+        ret = ffurl_read(c->hd, c->buf + offset, len);
+
+        pthread_mutex_lock(&c->mutex);
+        if (ret > 0) {
+            c->buf_end += ret;
+        } else if (!c->seek_request && !c->abort_request) {
+            c->eof      = 1;
+            c->io_error = ret < 0 && ret != AVERROR_EOF ? ret : 0;
+        }
+        pthread_cond_signal(&c->cond_wakeup_reader);
+    }
+    pthread_mutex_unlock(&c->mutex);
+    return NULL;
+}
+
+/* wait for the buffer thread, called with the mutex held */
+static int wait_thread(URLContext *h)
+{
+    AsyncContext *c = h->priv_data;
+    int64_t t = av_gettime() + 100000;
+    struct timespec tv = { .tv_sec  =  t / 1000000,
+                           .tv_nsec = (t % 1000000) * 1000 };
+
+    if (ff_check_interrupt(&h->interrupt_callback))
+        return AVERROR_EXIT;
+    pthread_cond_timedwait(&c->cond_wakeup_reader, &c->mutex, &tv);
+    return 0;
+}
+
+static int async_open(URLContext *h, const char *arg, int flags)
+{
+    AsyncContext *c = h->priv_data;
+    AVIOInterruptCB int_cb = { async_check_interrupt, h };
+    int ret;
+
+    av_strstart(arg, "async:", &arg);
+
+    if (flags & AVIO_FLAG_WRITE) {
+        av_log(h, AV_LOG_ERROR, "Only reading is supported\n");
+        return AVERROR(ENOSYS);
+    }
+    if ((ret = ffurl_open(&c->hd, arg, flags, &int_cb, NULL)) < 0)
+        return ret;
+
+    c->buf = av_malloc(c->buffer_size);
+    if (!c->buf) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    c->file_size = ffurl_size(c->hd);
+    h->is_streamed = c->hd->is_streamed;
+
+    pthread_mutex_init(&c->mutex, NULL);
+    pthread_cond_init(&c->cond_wakeup_thread, NULL);
+    pthread_cond_init(&c->cond_wakeup_reader, NULL);
+    if (pthread_create(&c->thread, NULL, async_buffer_task, h)) {
+        pthread_mutex_destroy(&c->mutex);
+        pthread_cond_destroy(&c->cond_wakeup_thread);
+        pthread_cond_destroy(&c->cond_wakeup_reader);
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    return 0;
+
+fail:
+    av_freep(&c->buf);
+    ffurl_close(c->hd);
+    return ret;
+}
+
+static int async_read(URLContext *h, uint8_t *buf, int size)
+{
+    AsyncContext *c = h->priv_data;
+    int ret = 0;
+
+    pthread_mutex_lock(&c->mutex);
+    for (;;) {
+        int64_t avail = c->buf_end - c->read_pos;
+
+        if (avail > 0) {
+            int offset = c->read_pos % c->buffer_size;
+
+            ret = FFMIN(FFMIN(size, avail), c->buffer_size - offset);
+            memcpy(buf, c->buf + offset, ret);
+            c->read_pos += ret;
+            pthread_cond_signal(&c->cond_wakeup_thread);
+            break;
+        }
+        if (c->eof) {
+            ret = c->io_error ? c->io_error : AVERROR_EOF;
+            break;
+        }
+        if ((ret = wait_thread(h)) < 0)
+            break;
+    }
+    pthread_mutex_unlock(&c->mutex);
+    return ret;
+}
+
+static int64_t async_seek(URLContext *h, int64_t pos, int whence)
+{
+    AsyncContext *c = h->priv_data;
+    int64_t ret;
+
+    if (whence == AVSEEK_SIZE)
+        return c->file_size;
+    if (whence == SEEK_END) {
+        if (c->file_size < 0)
+            return AVERROR(ENOSYS);
+        pos += c->file_size;
+    } else if (whence == SEEK_CUR) {
+        pos += c->read_pos;
+    } else if (whence != SEEK_SET) {
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    pthread_mutex_lock(&c->mutex);
+    if (pos >= c->buf_start && pos <= c->buf_end) {
+        c->read_pos = pos;
+        pthread_cond_signal(&c->cond_wakeup_thread);
+        pthread_mutex_unlock(&c->mutex);
+        return pos;
+    }
+
+    c->seek_pos       = pos;
+    c->seek_completed = 0;
+    c->seek_request   = 1;
+    pthread_cond_signal(&c->cond_wakeup_thread);
+    while (!c->seek_completed)
+        pthread_cond_wait(&c->cond_wakeup_reader, &c->mutex);
+    ret = c->seek_ret;
+    pthread_mutex_unlock(&c->mutex);
+    return ret;
+}
+
+static int async_close(URLContext *h)
+{
+    AsyncContext *c = h->priv_data;
+
+    pthread_mutex_lock(&c->mutex);
+    c->abort_request = 1;
+    pthread_cond_signal(&c->cond_wakeup_thread);
+    pthread_mutex_unlock(&c->mutex);
+    pthread_join(c->thread, NULL);
+
+    pthread_mutex_destroy(&c->mutex);
+    pthread_cond_destroy(&c->cond_wakeup_thread);
+    pthread_cond_destroy(&c->cond_wakeup_reader);
+    av_freep(&c->buf);
+    ffurl_close(c->hd);
+    return 0;
+}
+
+#define OFFSET(x) offsetof(AsyncContext, x)
+#define D AV_OPT_FLAG_DECODING_PARAM
+static const AVOption options[] = {
+    { "buffer_size", "size of the read-ahead buffer in bytes", OFFSET(buffer_size), AV_OPT_TYPE_INT, { .dbl = 4 << 20 }, 4096, INT_MAX / 2, D },
+    { NULL }
+};
+
+static const AVClass async_class = {
+    .class_name     = "async",
+    .item_name      = av_default_item_name,
+    .option         = options,
+    .version        = LIBAVUTIL_VERSION_INT,
+};
+
+URLProtocol ff_async_protocol = {
+    .name            = "async",
+    .url_open        = async_open,
+    .url_read        = async_read,
+    .url_seek        = async_seek,
+    .url_close       = async_close,
+    .priv_data_size  = sizeof(AsyncContext),
+    .priv_data_class = &async_class,
+    .flags           = URL_PROTOCOL_FLAG_NESTED_SCHEME,
+};
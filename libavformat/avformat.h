@@ -778,6 +778,15 @@ typedef struct AVStream {
                                     support seeking natively. */
     int nb_index_entries;
     unsigned int index_entries_allocated_size;
+
+    /**
+     * Entries of the generic index which do not go at its end, in insertion
+     * order. They are merged into index_entries in one pass before the
+     * index is searched.
+     */
+    AVIndexEntry *pending_index_entries;
+    int nb_pending_index_entries;
+    unsigned int pending_index_entries_allocated_size;
 } AVStream;
 
 #define AV_PROGRAM_RUNNING 1
@@ -1691,6 +1700,26 @@ int av_filename_number_test(const char *filename);
  */
 int av_sdp_create(AVFormatContext *ac[], int n_files, char *buf, int size);
 
+/**
+ * Statistics of one PID of an MPEG transport stream.
+ */
+typedef struct AVMpegTSPIDStats {
+    uint64_t packets;   ///< number of TS packets received
+    uint64_t bytes;     ///< number of bytes received, including the TS headers
+    uint64_t cc_errors; ///< number of continuity counter errors
+} AVMpegTSPIDStats;
+
+/**
+ * Get the per PID statistics of an input opened with the mpegts demuxer.
+ * They are collected when the "pid_stats" private option of the demuxer is
+ * set and cover every PID, including the discarded ones.
+ *
+ * @return array of 8192 entries indexed by PID, updated as the input is
+ *         read and valid until it is closed, or NULL if the input is not
+ *         MPEG-TS or the statistics are not collected
+ */
+const AVMpegTSPIDStats *av_mpegts_get_pid_stats(AVFormatContext *s);
+
 /**
  * Return a positive value if the given filename has one of the given
  * extensions, 0 otherwise.
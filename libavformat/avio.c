@@ -344,6 +344,13 @@ int ffurl_get_file_handle(URLContext *h)
     return h->prot->url_get_file_handle(h);
 }
 
+int ffurl_flush(URLContext *h)
+{
+    if (!h->prot->url_flush)
+        return 0;
+    return h->prot->url_flush(h);
+}
+
 int ffurl_shutdown(URLContext *h, int flags)
 {
     if (!h->prot->url_shutdown)
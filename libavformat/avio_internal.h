@@ -45,6 +45,32 @@ int ffio_init_context(AVIOContext *s,
  */
 int ffio_read_partial(AVIOContext *s, unsigned char *buf, int size);
 
+/**
+ * Read size bytes from AVIOContext, returning a pointer to them.
+ * If the bytes are all available in the internal buffer, a pointer into it
+ * is returned instead of copying them to buf. Either way, the data is only
+ * valid until the next call operating on the AVIOContext, and it is not
+ * followed by any padding.
+ *
+ * @param buf  buffer of at least size bytes, used if the data cannot be
+ *             returned in place
+ * @param data set to the beginning of the data read, either buf or a
+ *             pointer into the internal buffer
+ * @return number of bytes read or AVERROR, as avio_read()
+ */
+int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size,
+                       const unsigned char **data);
+
+/**
+ * Skip bytes until the next byte to be read is b, scanning the internal
+ * buffer directly instead of reading byte by byte.
+ *
+ * @param max_size maximum number of bytes to skip
+ * @return number of bytes skipped, AVERROR_INVALIDDATA if b was not found
+ *         within max_size bytes, or another AVERROR on EOF or I/O error
+ */
+int ffio_skip_to_byte(AVIOContext *s, int b, int max_size);
+
 void ffio_fill(AVIOContext *s, int b, int count);
 
 static av_always_inline void ffio_wfourcc(AVIOContext *pb, const uint8_t *s)
@@ -102,4 +128,12 @@ int ffio_open_dyn_packet_buf(AVIOContext **s, int max_packet_size);
  */
 int ffio_fdopen(AVIOContext **s, URLContext *h);
 
+/**
+ * Flush the buffer and have the underlying protocol send out everything
+ * it has queued for batched writing.
+ * Muxers that emit many datagrams per input packet call this at the end
+ * of each packet, so that batching adds no latency beyond one packet.
+ */
+void ffio_batch_flush(AVIOContext *s);
+
 #endif /* AVFORMAT_AVIO_INTERNAL_H */
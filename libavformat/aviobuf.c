@@ -479,6 +479,41 @@ int avio_read(AVIOContext *s, unsigned char *buf, int size)
     return size1 - size;
 }
 
+int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size,
+                       const unsigned char **data)
+{
+    if (s->buf_end - s->buf_ptr >= size && !s->write_flag) {
+        *data = s->buf_ptr;
+        s->buf_ptr += size;
+        return size;
+    }
+    *data = buf;
+    return avio_read(s, buf, size);
+}
+
+int ffio_skip_to_byte(AVIOContext *s, int b, int max_size)
+{
+    const unsigned char *p;
+    int i, len;
+
+    for (i = 0; i < max_size; i += len) {
+        if (s->buf_ptr >= s->buf_end) {
+            fill_buffer(s);
+            if (s->buf_ptr >= s->buf_end)
+                return s->error ? s->error : AVERROR_EOF;
+        }
+        len = FFMIN(s->buf_end - s->buf_ptr, max_size - i);
+        p   = memchr(s->buf_ptr, b, len);
+        if (p) {
+            len = p - s->buf_ptr;
+            s->buf_ptr += len;
+            return i + len;
+        }
+        s->buf_ptr += len;
+    }
+    return AVERROR_INVALIDDATA;
+}
+
 int ffio_read_partial(AVIOContext *s, unsigned char *buf, int size)
 {
     int len;
@@ -664,6 +699,13 @@ int ffio_fdopen(AVIOContext **s, URLContext *h)
     return 0;
 }
 
+void ffio_batch_flush(AVIOContext *s)
+{
+    avio_flush(s);
+    if (s->av_class == &ffio_url_class)
+        ffurl_flush(s->opaque);
+}
+
 int ffio_set_buf_size(AVIOContext *s, int buf_size)
 {
     uint8_t *buffer;
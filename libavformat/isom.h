@@ -53,6 +53,32 @@ typedef struct {
     int id;
 } MOVStsc;
 
+/**
+ * Run of consecutive chunks holding the same number of samples.
+ */
+typedef struct {
+    unsigned first_chunk;
+    unsigned first_sample;
+    unsigned count;       ///< number of samples in each chunk
+} MOVSampleRun;
+
+/**
+ * Position in the sample tables of a track whose samples are resolved on
+ * demand, see MOVStreamContext.lazy_count.
+ */
+typedef struct {
+    unsigned sample;
+    unsigned run;
+    unsigned chunk;
+    unsigned chunk_sample;  ///< index of the sample in its chunk
+    unsigned stts_index;
+    unsigned stts_sample;
+    unsigned stss_index;
+    unsigned stps_index;
+    unsigned distance;      ///< only exact when reading from the first sample
+    AVIndexEntry entry;     ///< the sample resolved from the tables
+} MOVIndexCursor;
+
 typedef struct {
     uint32_t type;
     char *path;
@@ -69,6 +95,16 @@ typedef struct {
 
 struct MOVParseTableEntry;
 
+/**
+ * Binary heap of stream indexes, used to pick the next sample to read.
+ */
+typedef struct MOVSampleHeap {
+    int *streams;         ///< stream indexes in heap order
+    int *slots;           ///< position of each stream in streams
+    int nb;
+    int (*before)(AVFormatContext *s, int a, int b);
+} MOVSampleHeap;
+
 typedef struct {
     unsigned track_id;
     uint64_t base_data_offset;
@@ -128,9 +164,23 @@ typedef struct MOVStreamContext {
     int has_palette;
     int64_t data_size;
     int64_t track_end;    ///< used for dts generation in fragmented movie files
+    /**
+     * Number of samples resolved from the sample tables on demand, 0 if
+     * they are in the index of the AVStream.
+     */
+    unsigned int lazy_count;
+    int64_t lazy_start_dts; ///< dts of the first sample of a lazy index
+    int key_off;          ///< 1 if the sync sample tables are 1-based
+    MOVSampleRun *runs;
+    unsigned int runs_count;
+    MOVIndexCursor cursor;
+    int64_t next_dts;     ///< dts of the current sample in AV_TIME_BASE units
+    int64_t next_pos;     ///< position of the current sample
+    int has_next;         ///< next_dts and next_pos describe a current sample
 } MOVStreamContext;
 
 typedef struct MOVContext {
+    const AVClass *class;
     AVFormatContext *fc;
     int time_scale;
     int64_t duration;     ///< duration of the longest track
@@ -145,6 +195,20 @@ typedef struct MOVContext {
     int itunes_metadata;  ///< metadata are itunes style
     int chapter_track;
     int64_t next_root_atom; ///< offset of the next root atom
+    int lazy_index;       ///< resolve the samples from the sample tables on demand
+    int heap_interleave;  ///< order the samples of seekable input with the heaps
+    /**
+     * Streams which have samples left, by dts. The samples which are at most
+     * AV_TIME_BASE after the first one are read in file order: their streams
+     * are in pos_heap, the other ones wait in wait_heap.
+     */
+    MOVSampleHeap dts_heap;
+    MOVSampleHeap pos_heap;
+    MOVSampleHeap wait_heap;
+    int heaps_size;       ///< number of streams the heaps are allocated for
+    int heaps_dirty;      ///< the heaps or cached samples must be rebuilt before being used
+    int scan_streams;     ///< pick the next sample with a scan of all streams
+    int last_stream;      ///< stream whose sample was picked last, -1 if none
 } MOVContext;
 
 int ff_mp4_read_descr_len(AVIOContext *pb);
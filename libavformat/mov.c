@@ -32,6 +32,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/avstring.h"
 #include "libavutil/dict.h"
+#include "libavutil/opt.h"
 #include "libavcodec/ac3tab.h"
 #include "avformat.h"
 #include "internal.h"
@@ -1695,6 +1696,340 @@ static int mov_read_ctts(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     return 0;
 }
 
+/* resolve size, flags and distance of the sample the cursor is on */
+static void mov_update_cursor_entry(MOVStreamContext *sc)
+{
+    MOVIndexCursor *c = &sc->cursor;
+    int keyframe = 0;
+
+    if (!sc->keyframe_absent && (!sc->keyframe_count ||
+        c->sample + sc->key_off == sc->keyframes[c->stss_index])) {
+        keyframe = 1;
+        if (c->stss_index + 1 < sc->keyframe_count)
+            c->stss_index++;
+    } else if (sc->stps_count &&
+               c->sample + sc->key_off == sc->stps_data[c->stps_index]) {
+        keyframe = 1;
+        if (c->stps_index + 1 < sc->stps_count)
+            c->stps_index++;
+    }
+    if (keyframe)
+        c->distance = 0;
+    c->entry.size = sc->sample_size > 0 ? sc->sample_size :
+                                          sc->sample_sizes[c->sample];
+    c->entry.min_distance = c->distance;
+    c->entry.flags        = keyframe ? AVINDEX_KEYFRAME : 0;
+}
+
+/* index of the first element of a sorted table not lower than val */
+static unsigned lower_bound(const unsigned *tab, unsigned nb, unsigned val)
+{
+    unsigned lo = 0, hi = nb;
+
+    while (lo < hi) {
+        unsigned mid = (lo + hi) >> 1;
+        if (tab[mid] < val)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* move the cursor of a lazy index to any sample */
+static void mov_seek_cursor(MOVStreamContext *sc, unsigned sample)
+{
+    MOVIndexCursor *c = &sc->cursor;
+    const MOVSampleRun *run;
+    unsigned lo = 0, hi = sc->runs_count - 1, i, first;
+    int64_t dts = sc->lazy_start_dts;
+
+    while (lo < hi) {
+        unsigned mid = (lo + hi + 1) >> 1;
+        if (sc->runs[mid].first_sample <= sample)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    run = &sc->runs[lo];
+    c->sample       = sample;
+    c->run          = lo;
+    c->chunk        = run->first_chunk  + (sample - run->first_sample) / run->count;
+    c->chunk_sample = (sample - run->first_sample) % run->count;
+    c->entry.pos    = sc->chunk_offsets[c->chunk];
+    if (sc->sample_size > 0)
+        c->entry.pos += (int64_t)c->chunk_sample * sc->sample_size;
+    else
+        for (i = sample - c->chunk_sample; i < sample; i++)
+            c->entry.pos += sc->sample_sizes[i];
+
+    /* a zero count is never reached, as when building the index */
+    for (i = first = 0; i + 1 < sc->stts_count; i++) {
+        unsigned count = sc->stts_data[i].count;
+        if (!count || sample - first < count)
+            break;
+        dts   += (int64_t)count * sc->stts_data[i].duration;
+        first += count;
+    }
+    c->stts_index  = i;
+    c->stts_sample = sample - first;
+    c->entry.timestamp = dts + (int64_t)c->stts_sample * sc->stts_data[i].duration;
+
+    c->stss_index = 0;
+    if (sc->keyframe_count)
+        c->stss_index = FFMIN(lower_bound((const unsigned *)sc->keyframes,
+                                          sc->keyframe_count,
+                                          sample + sc->key_off),
+                              sc->keyframe_count - 1);
+    c->stps_index = 0;
+    if (sc->stps_count)
+        c->stps_index = FFMIN(lower_bound(sc->stps_data, sc->stps_count,
+                                          sample + sc->key_off),
+                              sc->stps_count - 1);
+    c->distance = 0;
+    mov_update_cursor_entry(sc);
+}
+
+/* move the cursor of a lazy index to the next sample, which must exist */
+static void mov_next_cursor(MOVStreamContext *sc)
+{
+    MOVIndexCursor *c = &sc->cursor;
+
+    c->entry.pos       += c->entry.size;
+    c->entry.timestamp += sc->stts_data[c->stts_index].duration;
+    c->stts_sample++;
+    if (c->stts_index + 1 < sc->stts_count &&
+        c->stts_sample == sc->stts_data[c->stts_index].count) {
+        c->stts_sample = 0;
+        c->stts_index++;
+    }
+    c->sample++;
+    if (c->run + 1 < sc->runs_count &&
+        c->sample == sc->runs[c->run + 1].first_sample) {
+        c->run++;
+        c->chunk        = sc->runs[c->run].first_chunk;
+        c->chunk_sample = 0;
+        c->entry.pos    = sc->chunk_offsets[c->chunk];
+    } else if (++c->chunk_sample == sc->runs[c->run].count) {
+        c->chunk++;
+        c->chunk_sample = 0;
+        c->entry.pos    = sc->chunk_offsets[c->chunk];
+    }
+    c->distance++;
+    mov_update_cursor_entry(sc);
+}
+
+/**
+ * Get a sample of a track, from the index of the stream or from the sample
+ * tables. A sample resolved from the tables is only valid until the next
+ * call for the same track.
+ * @return the sample, NULL if there is no such sample
+ */
+static AVIndexEntry *mov_get_sample(AVStream *st, int sample)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    if (!sc->lazy_count)
+        return sample < st->nb_index_entries ? &st->index_entries[sample] : NULL;
+    if ((unsigned)sample >= sc->lazy_count)
+        return NULL;
+    if (sample == sc->cursor.sample + 1)
+        mov_next_cursor(sc);
+    else if (sample != sc->cursor.sample)
+        mov_seek_cursor(sc, sample);
+    return &sc->cursor.entry;
+}
+
+/* nearest sync sample of a lazy index in the given direction */
+static int mov_find_lazy_keyframe(MOVStreamContext *sc, unsigned sample,
+                                  int backward)
+{
+    const unsigned *tabs[2] = { (const unsigned *)sc->keyframes, sc->stps_data };
+    unsigned counts[2] = { sc->keyframe_absent ? 0 : sc->keyframe_count,
+                           sc->stps_count };
+    unsigned val = sample + sc->key_off;
+    int64_t best = backward ? -1 : (int64_t)sc->lazy_count;
+    int t;
+
+    if (!sc->keyframe_absent && !sc->keyframe_count)
+        return sample;
+    for (t = 0; t < 2; t++) {
+        unsigned i;
+        if (backward) {
+            i = lower_bound(tabs[t], counts[t], val + 1);
+            if (i)
+                best = FFMAX(best, (int64_t)tabs[t][i - 1] - sc->key_off);
+        } else {
+            i = lower_bound(tabs[t], counts[t], val);
+            if (i < counts[t])
+                best = FFMIN(best, (int64_t)tabs[t][i] - sc->key_off);
+        }
+    }
+    return best;
+}
+
+/**
+ * Search the samples of a lazy index as av_index_search_timestamp() does
+ * the entries of an index.
+ */
+static int mov_search_lazy_index(AVStream *st, int64_t wanted_timestamp,
+                                 int flags)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t dts = sc->lazy_start_dts;
+    unsigned i, first = 0;
+    int a = -1, b = -1, m;
+
+    /* a is the last sample not after the wanted timestamp,
+     * b the first one not before it */
+    for (i = 0; i < sc->stts_count && first < sc->lazy_count; i++) {
+        unsigned count = sc->lazy_count - first;
+        int duration = sc->stts_data[i].duration;
+
+        if (i + 1 < sc->stts_count && sc->stts_data[i].count)
+            count = FFMIN(count, (unsigned)sc->stts_data[i].count);
+        if (dts > wanted_timestamp) {
+            if (b < 0)
+                b = first;
+            break;
+        }
+        if (duration <= 0) {
+            a = first + count - 1;
+            if (dts == wanted_timestamp && b < 0)
+                b = first;
+        } else {
+            int64_t k = (wanted_timestamp - dts) / duration;
+            if (k < count) {
+                a = first + k;
+                if (b < 0)
+                    b = dts + k * duration == wanted_timestamp ? a : a + 1;
+                break;
+            }
+            a = first + count - 1;
+        }
+        dts   += (int64_t)count * duration;
+        first += count;
+    }
+    if (b < 0)
+        b = sc->lazy_count;
+
+    m = (flags & AVSEEK_FLAG_BACKWARD) ? a : b;
+    if (!(flags & AVSEEK_FLAG_ANY) && m >= 0 && m < sc->lazy_count)
+        m = mov_find_lazy_keyframe(sc, m, flags & AVSEEK_FLAG_BACKWARD);
+    if (m == sc->lazy_count)
+        return -1;
+    return m;
+}
+
+/**
+ * Keep the sample tables of a track to resolve its samples on demand
+ * instead of expanding them into the index of the stream.
+ */
+static int mov_init_lazy_index(MOVContext *mov, AVStream *st,
+                               int64_t start_dts, int key_off)
+{
+    MOVStreamContext *sc = st->priv_data;
+    uint64_t nb_samples = 0, stream_size = 0;
+    unsigned chunk = 0, stsc_index = 0, i;
+
+    if (!sc->stsc_count || sc->stsc_count >= UINT_MAX / sizeof(*sc->runs))
+        return AVERROR(EINVAL);
+    sc->runs = av_malloc(sc->stsc_count * sizeof(*sc->runs));
+    if (!sc->runs)
+        return AVERROR(ENOMEM);
+
+    /* follow the chunks as mov_build_index() does */
+    while (chunk < sc->chunk_count && nb_samples < sc->sample_count) {
+        MOVSampleRun *run;
+        unsigned next = sc->chunk_count;
+
+        while (stsc_index + 1 < sc->stsc_count &&
+               chunk + 1 == sc->stsc_data[stsc_index + 1].first)
+            stsc_index++;
+        if (stsc_index + 1 < sc->stsc_count &&
+            sc->stsc_data[stsc_index + 1].first - 1U > chunk)
+            next = FFMIN(next, sc->stsc_data[stsc_index + 1].first - 1U);
+        if (!sc->stsc_data[stsc_index].count) {
+            chunk = next;
+            continue;
+        }
+        /* the samples of other sample descriptions are not indexed */
+        if (sc->pseudo_stream_id != -1 &&
+            sc->stsc_data[stsc_index].id - 1 != sc->pseudo_stream_id) {
+            av_freep(&sc->runs);
+            sc->runs_count = 0;
+            return AVERROR_PATCHWELCOME;
+        }
+        run = &sc->runs[sc->runs_count++];
+        run->first_chunk  = chunk;
+        run->first_sample = nb_samples;
+        run->count        = sc->stsc_data[stsc_index].count;
+        nb_samples += (uint64_t)(next - chunk) * run->count;
+        chunk = next;
+    }
+    if (nb_samples > sc->sample_count) {
+        av_log(mov->fc, AV_LOG_ERROR, "wrong sample count\n");
+        nb_samples = sc->sample_count;
+    }
+    if (!nb_samples || nb_samples >= INT_MAX) {
+        av_freep(&sc->runs);
+        sc->runs_count = 0;
+        return AVERROR(EINVAL);
+    }
+
+    if (sc->sample_size > 0)
+        stream_size = nb_samples * sc->sample_size;
+    else
+        for (i = 0; i < nb_samples; i++)
+            stream_size += sc->sample_sizes[i];
+    if (st->duration > 0)
+        st->codec->bit_rate = stream_size*8*sc->time_scale/st->duration;
+
+    sc->lazy_count     = nb_samples;
+    sc->lazy_start_dts = start_dts;
+    sc->key_off        = key_off;
+    mov_seek_cursor(sc, 0);
+    return 0;
+}
+
+static void mov_free_sample_tables(MOVStreamContext *sc)
+{
+    av_freep(&sc->chunk_offsets);
+    av_freep(&sc->stsc_data);
+    av_freep(&sc->sample_sizes);
+    av_freep(&sc->keyframes);
+    av_freep(&sc->stts_data);
+    av_freep(&sc->stps_data);
+    av_freep(&sc->runs);
+}
+
+/**
+ * Move the samples of a lazy index into the index of the stream, for the
+ * code which needs all of them there.
+ */
+static int mov_expand_lazy_index(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    AVIndexEntry *mem;
+    unsigned i, nb_samples = sc->lazy_count;
+
+    if (!nb_samples)
+        return 0;
+    if (nb_samples >= UINT_MAX / sizeof(*st->index_entries) - st->nb_index_entries)
+        return AVERROR(EINVAL);
+    mem = av_realloc(st->index_entries, (st->nb_index_entries + nb_samples) * sizeof(*st->index_entries));
+    if (!mem)
+        return AVERROR(ENOMEM);
+    st->index_entries = mem;
+    st->index_entries_allocated_size = (st->nb_index_entries + nb_samples) * sizeof(*st->index_entries);
+
+    for (i = 0; i < nb_samples; i++)
+        st->index_entries[st->nb_index_entries++] = *mov_get_sample(st, i);
+    sc->lazy_count = 0;
+    mov_free_sample_tables(sc);
+    return 0;
+}
+
 static void mov_build_index(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *sc = st->priv_data;
@@ -1735,6 +2070,9 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
 
         if (!sc->sample_count)
             return;
+        if (mov->lazy_index &&
+            mov_init_lazy_index(mov, st, current_dts, key_off) >= 0)
+            return;
         if (sc->sample_count >= UINT_MAX / sizeof(*st->index_entries) - st->nb_index_entries)
             return;
         mem = av_realloc(st->index_entries, (st->nb_index_entries + sc->sample_count) * sizeof(*st->index_entries));
@@ -2006,13 +2344,9 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         break;
     }
 
-    /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->stsc_data);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stts_data);
-    av_freep(&sc->stps_data);
+    /* Do not need those anymore, unless the samples are resolved from them. */
+    if (!sc->lazy_count)
+        mov_free_sample_tables(sc);
 
     return 0;
 }
@@ -2197,7 +2531,7 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     int64_t dts;
     int data_offset = 0;
     unsigned entries, first_sample_flags = frag->flags;
-    int flags, distance, i, found_keyframe = 0;
+    int flags, distance, i, err, found_keyframe = 0;
 
     for (i = 0; i < c->fc->nb_streams; i++) {
         if (c->fc->streams[i]->id == frag->track_id) {
@@ -2212,6 +2546,8 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     sc = st->priv_data;
     if (sc->pseudo_stream_id+1 != frag->stsd_id)
         return 0;
+    if ((err = mov_expand_lazy_index(st)) < 0)
+        return err;
     avio_r8(pb); /* version */
     flags = avio_rb24(pb);
     entries = avio_rb32(pb);
@@ -2593,6 +2929,8 @@ static void mov_read_chapters(AVFormatContext *s)
 
     st->discard = AVDISCARD_ALL;
     sc = st->priv_data;
+    if (mov_expand_lazy_index(st) < 0)
+        return;
     cur_pos = avio_tell(sc->pb);
 
     for (i = 0; i < st->nb_index_entries; i++) {
@@ -2652,6 +2990,7 @@ static int mov_read_close(AVFormatContext *s)
         MOVStreamContext *sc = st->priv_data;
 
         av_freep(&sc->ctts_data);
+        mov_free_sample_tables(sc);
         for (j = 0; j < sc->drefs_count; j++) {
             av_freep(&sc->drefs[j].path);
             av_freep(&sc->drefs[j].dir);
@@ -2671,6 +3010,12 @@ static int mov_read_close(AVFormatContext *s)
     }
 
     av_freep(&mov->trex_data);
+    av_freep(&mov->dts_heap.streams);
+    av_freep(&mov->dts_heap.slots);
+    av_freep(&mov->pos_heap.streams);
+    av_freep(&mov->pos_heap.slots);
+    av_freep(&mov->wait_heap.streams);
+    av_freep(&mov->wait_heap.slots);
 
     return 0;
 }
@@ -2705,6 +3050,11 @@ static int mov_read_header(AVFormatContext *s)
     if (pb->seekable && mov->chapter_track > 0)
         mov_read_chapters(s);
 
+    mov->heaps_dirty  = 1;
+    mov->last_stream  = -1;
+    /* the heaps only follow the order of the scan on non-seekable input */
+    mov->scan_streams = pb->seekable && !mov->heap_interleave;
+
     if (mov->trex_data) {
         int i;
         for (i = 0; i < s->nb_streams; i++) {
@@ -2718,42 +3068,282 @@ static int mov_read_header(AVFormatContext *s)
     return 0;
 }
 
-static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
+/**
+ * Pick the stream of the next sample with a scan of all streams, comparing
+ * each one with the best one found so far: file order for samples at most
+ * AV_TIME_BASE apart, dts order beyond, file order on non-seekable input.
+ * @return stream index, -1 if there are no samples left
+ */
+static int mov_scan_next_stream(AVFormatContext *s)
+{
+    int64_t best_dts = INT64_MAX, best_pos = 0;
+    int i, best = -1;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        MOVStreamContext *msc = s->streams[i]->priv_data;
+        int64_t dts = msc->next_dts, pos = msc->next_pos;
+        if (!msc->has_next)
+            continue;
+        av_dlog(s, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
+        if (best < 0 || (!s->pb->seekable && pos < best_pos) ||
+            (s->pb->seekable &&
+             ((msc->pb != s->pb && dts < best_dts) || (msc->pb == s->pb &&
+             ((FFABS(best_dts - dts) <= AV_TIME_BASE && pos < best_pos) ||
+              (FFABS(best_dts - dts) > AV_TIME_BASE && dts < best_dts)))))) {
+            best     = i;
+            best_dts = dts;
+            best_pos = pos;
+        }
+    }
+    return best;
+}
+
+static int mov_dts_before(AVFormatContext *s, int a, int b)
+{
+    MOVStreamContext *sa = s->streams[a]->priv_data;
+    MOVStreamContext *sb = s->streams[b]->priv_data;
+
+    return sa->next_dts < sb->next_dts || (sa->next_dts == sb->next_dts && a < b);
+}
+
+static int mov_pos_before(AVFormatContext *s, int a, int b)
+{
+    MOVStreamContext *sa = s->streams[a]->priv_data;
+    MOVStreamContext *sb = s->streams[b]->priv_data;
+
+    return sa->next_pos < sb->next_pos || (sa->next_pos == sb->next_pos && a < b);
+}
+
+static void heap_set(MOVSampleHeap *h, int slot, int stream)
+{
+    h->streams[slot] = stream;
+    h->slots[stream] = slot;
+}
+
+static void heap_sift(AVFormatContext *s, MOVSampleHeap *h, int slot)
+{
+    int stream = h->streams[slot];
+
+    while (slot && h->before(s, stream, h->streams[(slot - 1) >> 1])) {
+        heap_set(h, slot, h->streams[(slot - 1) >> 1]);
+        slot = (slot - 1) >> 1;
+    }
+    for (;;) {
+        int child = 2 * slot + 1;
+        if (child >= h->nb)
+            break;
+        if (child + 1 < h->nb &&
+            h->before(s, h->streams[child + 1], h->streams[child]))
+            child++;
+        if (!h->before(s, h->streams[child], stream))
+            break;
+        heap_set(h, slot, h->streams[child]);
+        slot = child;
+    }
+    heap_set(h, slot, stream);
+}
+
+static void heap_push(AVFormatContext *s, MOVSampleHeap *h, int stream)
+{
+    heap_set(h, h->nb++, stream);
+    heap_sift(s, h, h->nb - 1);
+}
+
+static void heap_remove(AVFormatContext *s, MOVSampleHeap *h, int stream)
+{
+    int slot = h->slots[stream];
+
+    if (slot == --h->nb)
+        return;
+    heap_set(h, slot, h->streams[h->nb]);
+    heap_sift(s, h, slot);
+}
+
+/* cache the dts and position of the current sample of a stream */
+static int mov_set_next_sample(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    AVIndexEntry *sample;
+
+    sc->has_next = 0;
+    if (!sc->pb || !(sample = mov_get_sample(st, sc->current_sample)))
+        return 0;
+    sc->next_dts = av_rescale(sample->timestamp, AV_TIME_BASE, sc->time_scale);
+    sc->next_pos = sample->pos;
+    sc->has_next = 1;
+    return 1;
+}
+
+/* latest dts of the samples which are read in file order */
+static int64_t mov_dts_limit(AVFormatContext *s)
+{
+    MOVContext *mov = s->priv_data;
+    MOVStreamContext *sc;
+
+    if (!s->pb->seekable)
+        return INT64_MAX;
+    sc = s->streams[mov->dts_heap.streams[0]]->priv_data;
+    return sc->next_dts + AV_TIME_BASE;
+}
+
+/* move the streams whose sample falls below the dts limit to pos_heap */
+static void mov_admit_waiting_streams(AVFormatContext *s, int64_t limit)
+{
+    MOVContext *mov = s->priv_data;
+
+    while (mov->wait_heap.nb) {
+        int stream = mov->wait_heap.streams[0];
+        MOVStreamContext *sc = s->streams[stream]->priv_data;
+        if (sc->next_dts > limit)
+            break;
+        heap_remove(s, &mov->wait_heap, stream);
+        heap_push(s, &mov->pos_heap, stream);
+    }
+}
+
+static int mov_build_sample_heaps(AVFormatContext *s)
 {
-    AVIndexEntry *sample = NULL;
-    int64_t best_dts = INT64_MAX;
+    MOVContext *mov = s->priv_data;
+    MOVSampleHeap *heaps[3] = { &mov->dts_heap, &mov->pos_heap, &mov->wait_heap };
+    int64_t limit;
     int i;
+
     for (i = 0; i < s->nb_streams; i++) {
-        AVStream *avst = s->streams[i];
-        MOVStreamContext *msc = avst->priv_data;
-        if (msc->pb && msc->current_sample < avst->nb_index_entries) {
-            AVIndexEntry *current_sample = &avst->index_entries[msc->current_sample];
-            int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
-            av_dlog(s, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
-            if (!sample || (!s->pb->seekable && current_sample->pos < sample->pos) ||
-                (s->pb->seekable &&
-                 ((msc->pb != s->pb && dts < best_dts) || (msc->pb == s->pb &&
-                 ((FFABS(best_dts - dts) <= AV_TIME_BASE && current_sample->pos < sample->pos) ||
-                  (FFABS(best_dts - dts) > AV_TIME_BASE && dts < best_dts)))))) {
-                sample = current_sample;
-                best_dts = dts;
-                *st = avst;
+        MOVStreamContext *sc = s->streams[i]->priv_data;
+        /* samples from other files are only ordered by dts */
+        if (sc->pb && sc->pb != s->pb) {
+            mov->scan_streams = 1;
+            return 0;
+        }
+    }
+    if (mov->heaps_size < s->nb_streams) {
+        for (i = 0; i < 3; i++) {
+            av_freep(&heaps[i]->streams);
+            av_freep(&heaps[i]->slots);
+            heaps[i]->streams = av_malloc(s->nb_streams * sizeof(int));
+            heaps[i]->slots   = av_malloc(s->nb_streams * sizeof(int));
+            if (!heaps[i]->streams || !heaps[i]->slots) {
+                mov->heaps_size   = 0;
+                mov->scan_streams = 1;
+                return AVERROR(ENOMEM);
             }
         }
+        mov->heaps_size = s->nb_streams;
+    }
+    mov->dts_heap.before  = mov_dts_before;
+    mov->pos_heap.before  = mov_pos_before;
+    mov->wait_heap.before = mov_dts_before;
+    for (i = 0; i < 3; i++)
+        heaps[i]->nb = 0;
+    mov->heaps_dirty = 0;
+
+    for (i = 0; i < s->nb_streams; i++)
+        if (mov_set_next_sample(s->streams[i]))
+            heap_push(s, &mov->dts_heap, i);
+    if (!mov->dts_heap.nb)
+        return 0;
+    limit = mov_dts_limit(s);
+    for (i = 0; i < mov->dts_heap.nb; i++) {
+        int stream = mov->dts_heap.streams[i];
+        MOVStreamContext *sc = s->streams[stream]->priv_data;
+        heap_push(s, sc->next_dts > limit ? &mov->wait_heap : &mov->pos_heap,
+                  stream);
+    }
+    return 0;
+}
+
+/* put back the stream whose sample was picked last, with its next sample */
+static void mov_update_sample_heaps(AVFormatContext *s)
+{
+    MOVContext *mov = s->priv_data;
+    int stream = mov->last_stream;
+    MOVStreamContext *sc = s->streams[stream]->priv_data;
+    int64_t old_limit = mov_dts_limit(s), limit;
+    int has_sample;
+
+    mov->last_stream = -1;
+    heap_remove(s, &mov->pos_heap, stream);
+    has_sample = mov_set_next_sample(s->streams[stream]);
+    if (has_sample)
+        heap_sift(s, &mov->dts_heap, mov->dts_heap.slots[stream]);
+    else
+        heap_remove(s, &mov->dts_heap, stream);
+    if (!mov->dts_heap.nb)
+        return;
+
+    limit = mov_dts_limit(s);
+    /* only happens with decreasing timestamps */
+    if (limit < old_limit) {
+        mov->heaps_dirty = 1;
+        return;
+    }
+    if (has_sample)
+        heap_push(s, sc->next_dts > limit ? &mov->wait_heap : &mov->pos_heap,
+                  stream);
+    mov_admit_waiting_streams(s, limit);
+}
+
+/* update the cached current sample of the streams for the scan */
+static void mov_update_next_samples(AVFormatContext *s)
+{
+    MOVContext *mov = s->priv_data;
+    int i;
+
+    if (mov->heaps_dirty) {
+        for (i = 0; i < s->nb_streams; i++)
+            mov_set_next_sample(s->streams[i]);
+        mov->heaps_dirty = 0;
+    } else if (mov->last_stream >= 0) {
+        mov_set_next_sample(s->streams[mov->last_stream]);
     }
-    return sample;
+}
+
+/**
+ * Pick the next sample to read. By default the streams are scanned, with
+ * their current sample cached so that only the stream read last is looked
+ * up again. With heap_interleave, or on non-seekable input, the streams are
+ * kept in heaps instead: the sample with the lowest position among the
+ * samples which are at most AV_TIME_BASE after the sample with the lowest
+ * dts is picked, or the sample with the lowest position if the input is not
+ * seekable. On seekable input this can differ from the order of the scan,
+ * which compares each stream with the best one found so far.
+ */
+static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
+{
+    MOVContext *mov = s->priv_data;
+    MOVStreamContext *sc;
+    int stream;
+
+    if (!mov->scan_streams && !mov->heaps_dirty && mov->last_stream >= 0)
+        mov_update_sample_heaps(s);
+    if (!mov->scan_streams && mov->heaps_dirty)
+        mov_build_sample_heaps(s);
+
+    if (mov->scan_streams) {
+        mov_update_next_samples(s);
+        stream = mov_scan_next_stream(s);
+    } else {
+        stream = mov->pos_heap.nb ? mov->pos_heap.streams[0] : -1;
+    }
+    mov->last_stream = stream;
+    if (stream < 0)
+        return NULL;
+
+    *st = s->streams[stream];
+    sc  = (*st)->priv_data;
+    return mov_get_sample(*st, sc->current_sample);
 }
 
 static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
 {
     MOVContext *mov = s->priv_data;
     MOVStreamContext *sc;
-    AVIndexEntry *sample;
+    AVIndexEntry *next_sample, *sample, entry;
     AVStream *st = NULL;
     int ret;
  retry:
-    sample = mov_find_next_sample(s, &st);
-    if (!sample) {
+    next_sample = mov_find_next_sample(s, &st);
+    if (!next_sample) {
         mov->found_mdat = 0;
         if (!mov->next_root_atom)
             return AVERROR_EOF;
@@ -2762,9 +3352,13 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         if (mov_read_default(mov, s->pb, (MOVAtom){ AV_RL32("root"), INT64_MAX }) < 0 ||
             s->pb->eof_reached)
             return AVERROR_EOF;
+        mov->heaps_dirty = 1;
         av_dlog(s, "read fragments, offset 0x%"PRIx64"\n", avio_tell(s->pb));
         goto retry;
     }
+    /* a sample resolved from the sample tables is overwritten by the next one */
+    entry  = *next_sample;
+    sample = &entry;
     sc = st->priv_data;
     /* must be done just before reading, to avoid infinite loop on sample */
     sc->current_sample++;
@@ -2815,8 +3409,8 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         if (sc->wrong_dts)
             pkt->dts = AV_NOPTS_VALUE;
     } else {
-        int64_t next_dts = (sc->current_sample < st->nb_index_entries) ?
-            st->index_entries[sc->current_sample].timestamp : st->duration;
+        AVIndexEntry *next = mov_get_sample(st, sc->current_sample);
+        int64_t next_dts = next ? next->timestamp : st->duration;
         pkt->duration = next_dts - pkt->dts;
         pkt->pts = pkt->dts;
     }
@@ -2832,12 +3426,16 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
 static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp, int flags)
 {
     MOVStreamContext *sc = st->priv_data;
+    AVIndexEntry *first;
     int sample, time_sample;
     int i;
 
-    sample = av_index_search_timestamp(st, timestamp, flags);
+    if (sc->lazy_count)
+        sample = mov_search_lazy_index(st, timestamp, flags);
+    else
+        sample = av_index_search_timestamp(st, timestamp, flags);
     av_dlog(s, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
-    if (sample < 0 && st->nb_index_entries && timestamp < st->index_entries[0].timestamp)
+    if (sample < 0 && (first = mov_get_sample(st, 0)) && timestamp < first->timestamp)
         sample = 0;
     if (sample < 0) /* not sure what to do */
         return AVERROR_INVALIDDATA;
@@ -2861,6 +3459,7 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
 
 static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_time, int flags)
 {
+    MOVContext *mov = s->priv_data;
     AVStream *st;
     int64_t seek_timestamp, timestamp;
     int sample;
@@ -2875,9 +3474,10 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
     sample = mov_seek_stream(s, st, sample_time, flags);
     if (sample < 0)
         return sample;
+    mov->heaps_dirty = 1;
 
     /* adjust seek timestamp to found sample timestamp */
-    seek_timestamp = st->index_entries[sample].timestamp;
+    seek_timestamp = mov_get_sample(st, sample)->timestamp;
 
     for (i = 0; i < s->nb_streams; i++) {
         st = s->streams[i];
@@ -2890,6 +3490,21 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
     return 0;
 }
 
+static const AVOption mov_options[] = {
+    {"lazy_index", "Resolve the samples from the sample tables while reading instead of building an index of all of them when opening.", offsetof(MOVContext, lazy_index), AV_OPT_TYPE_INT,
+     {.dbl = 0}, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
+    {"heap_interleave", "Order the samples of seekable input with priority queues, faster with many tracks. Samples within a second of the earliest one are read in file order, which can differ from the default order.", offsetof(MOVContext, heap_interleave), AV_OPT_TYPE_INT,
+     {.dbl = 0}, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
+    { NULL },
+};
+
+static const AVClass mov_class = {
+    .class_name = "mov demuxer",
+    .item_name  = av_default_item_name,
+    .option     = mov_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 AVInputFormat ff_mov_demuxer = {
     .name           = "mov,mp4,m4a,3gp,3g2,mj2",
     .long_name      = NULL_IF_CONFIG_SMALL("QuickTime / MOV"),
@@ -2899,4 +3514,5 @@ AVInputFormat ff_mov_demuxer = {
     .read_packet    = mov_read_packet,
     .read_close     = mov_read_close,
     .read_seek      = mov_read_seek,
+    .priv_class     = &mov_class,
 };
@@ -123,6 +123,21 @@ struct MpegTSContext {
     struct Program *prg;
 
 
+    /** PIDs dropped before any parsing, see update_discard_map() */
+    uint32_t discard_map[NB_PID_MAX / 32];
+    /** set when discard_map is not empty */
+    int has_discard_map;
+    /** set when the PIDs of the programs change */
+    int discard_map_dirty;
+    /** discard values of the programs and streams the map was built from */
+    int8_t *discard_snapshot;
+    int nb_discard_snapshot;
+
+    /** collect per PID statistics                            */
+    int collect_pid_stats;
+    AVMpegTSPIDStats *pid_stats;
+    int8_t *pid_stats_cc;
+
     /** filters for various streams specified by PMT + for the PAT and PMT */
     MpegTSFilter *pids[NB_PID_MAX];
 };
@@ -133,6 +148,19 @@ static const AVOption options[] = {
     { NULL },
 };
 
+static const AVOption mpegts_options[] = {
+    {"pid_stats", "Collect packet, byte and continuity error counts for each PID.", offsetof(MpegTSContext, collect_pid_stats), AV_OPT_TYPE_INT,
+     {.dbl = 0}, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
+    { NULL },
+};
+
+static const AVClass mpegts_class = {
+    .class_name = "mpegts demuxer",
+    .item_name  = av_default_item_name,
+    .option     = mpegts_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 static const AVClass mpegtsraw_class = {
     .class_name = "mpegtsraw demuxer",
     .item_name  = av_default_item_name,
@@ -186,12 +214,14 @@ static void clear_program(MpegTSContext *ts, unsigned int programid)
     for(i=0; i<ts->nb_prg; i++)
         if(ts->prg[i].id == programid)
             ts->prg[i].nb_pids = 0;
+    ts->discard_map_dirty = 1;
 }
 
 static void clear_programs(MpegTSContext *ts)
 {
     av_freep(&ts->prg);
     ts->nb_prg=0;
+    ts->discard_map_dirty = 1;
 }
 
 static void add_pat_entry(MpegTSContext *ts, unsigned int programid)
@@ -205,6 +235,7 @@ static void add_pat_entry(MpegTSContext *ts, unsigned int programid)
     p->id = programid;
     p->nb_pids = 0;
     ts->nb_prg++;
+    ts->discard_map_dirty = 1;
 }
 
 static void add_pid_to_pmt(MpegTSContext *ts, unsigned int programid, unsigned int pid)
@@ -223,40 +254,161 @@ static void add_pid_to_pmt(MpegTSContext *ts, unsigned int programid, unsigned i
     if(p->nb_pids >= MAX_PIDS_PER_PROGRAM)
         return;
     p->pids[p->nb_pids++] = pid;
+    ts->discard_map_dirty = 1;
+}
+
+/* a PES stream is dropped when all the streams it feeds are discarded */
+static int discard_pes(MpegTSFilter *tss)
+{
+    PESContext *pes;
+
+    if (!tss || tss->type != MPEGTS_PES)
+        return 0;
+    pes = tss->u.pes_filter.opaque;
+    return pes->st && pes->st->discard == AVDISCARD_ALL &&
+           (!pes->sub_st || pes->sub_st->discard == AVDISCARD_ALL);
 }
 
 /**
- * @brief discard_pid() decides if the pid is to be discarded according
- *                      to caller's programs selection
- * @param ts    : - TS context
- * @param pid   : - pid
- * @return 1 if the pid is only comprised in programs that have .discard=AVDISCARD_ALL
- *         0 otherwise
+ * Check whether the discard values of the programs or streams changed
+ * since the discard map was last built.
  */
-static int discard_pid(MpegTSContext *ts, unsigned int pid)
+static void check_discard_changes(MpegTSContext *ts)
 {
-    int i, j, k;
-    int used = 0, discarded = 0;
-    struct Program *p;
-    for(i=0; i<ts->nb_prg; i++) {
-        p = &ts->prg[i];
-        for(j=0; j<p->nb_pids; j++) {
-            if(p->pids[j] != pid)
+    AVFormatContext *s = ts->stream;
+    int i;
+
+    if (ts->nb_discard_snapshot != s->nb_programs + s->nb_streams) {
+        ts->discard_map_dirty = 1;
+        return;
+    }
+    for (i = 0; i < s->nb_programs; i++)
+        if (ts->discard_snapshot[i] != s->programs[i]->discard)
+            ts->discard_map_dirty = 1;
+    for (i = 0; i < s->nb_streams; i++)
+        if (ts->discard_snapshot[s->nb_programs + i] != s->streams[i]->discard)
+            ts->discard_map_dirty = 1;
+}
+
+/**
+ * Rebuild the map of the PIDs dropped in handle_packet(), according to
+ * the caller's selection of programs and streams. A PID is dropped if it
+ * only belongs to programs with .discard=AVDISCARD_ALL, or if it carries
+ * discarded streams only. The PES streams whose PID changes state restart
+ * at the next PES header.
+ */
+static void update_discard_map(MpegTSContext *ts)
+{
+    AVFormatContext *s = ts->stream;
+    uint32_t map[NB_PID_MAX / 32] = { 0 }, used[NB_PID_MAX / 32] = { 0 };
+    int8_t *snapshot;
+    int has_discard = 0, i, j, k;
+
+    ts->discard_map_dirty = 0;
+
+    snapshot = av_realloc(ts->discard_snapshot,
+                          s->nb_programs + s->nb_streams + 1);
+    if (!snapshot) {
+        /* keep every PID and try again next time */
+        memset(ts->discard_map, 0, sizeof(ts->discard_map));
+        ts->has_discard_map = 0;
+        ts->discard_map_dirty = 1;
+        return;
+    }
+    ts->discard_snapshot    = snapshot;
+    ts->nb_discard_snapshot = s->nb_programs + s->nb_streams;
+    for (i = 0; i < s->nb_programs; i++) {
+        snapshot[i] = s->programs[i]->discard;
+        has_discard |= snapshot[i] == AVDISCARD_ALL;
+    }
+    for (i = 0; i < s->nb_streams; i++) {
+        snapshot[s->nb_programs + i] = s->streams[i]->discard;
+        has_discard |= snapshot[s->nb_programs + i] == AVDISCARD_ALL;
+    }
+    /* the map is empty and stays so */
+    if (!has_discard && !ts->has_discard_map)
+        return;
+
+    if (has_discard) {
+        for (i = 0; i < ts->nb_prg; i++) {
+            struct Program *p = &ts->prg[i];
+            uint32_t *dst = NULL;
+
+            for (k = 0; k < s->nb_programs; k++)
+                if (s->programs[k]->id == p->id)
+                    dst = s->programs[k]->discard == AVDISCARD_ALL ? map : used;
+            if (!dst)
                 continue;
-            //is program with id p->id set to be discarded?
-            for(k=0; k<ts->stream->nb_programs; k++) {
-                if(ts->stream->programs[k]->id == p->id) {
-                    if(ts->stream->programs[k]->discard == AVDISCARD_ALL)
-                        discarded++;
-                    else
-                        used++;
-                }
+            for (j = 0; j < p->nb_pids; j++)
+                dst[p->pids[j] >> 5] |= 1U << (p->pids[j] & 31);
+        }
+        for (i = 0; i < NB_PID_MAX / 32; i++)
+            map[i] &= ~used[i];
+        /* the PAT is never dropped */
+        map[0] &= ~1U;
+    }
+
+    for (i = 1; i < NB_PID_MAX; i++) {
+        MpegTSFilter *tss = ts->pids[i];
+        uint32_t bit = 1U << (i & 31);
+
+        if (!tss)
+            continue;
+        if (has_discard && discard_pes(tss))
+            map[i >> 5] |= bit;
+        if ((map[i >> 5] ^ ts->discard_map[i >> 5]) & bit) {
+            if (tss->type == MPEGTS_PES) {
+                PESContext *pes = tss->u.pes_filter.opaque;
+                av_freep(&pes->buffer);
+                pes->data_index = 0;
+                pes->state = MPEGTS_SKIP; /* skip until pes header */
             }
+            tss->last_cc = -1;
         }
     }
+    memcpy(ts->discard_map, map, sizeof(map));
+    ts->has_discard_map = has_discard;
+}
+
+/* return 1 if the continuity counter of the packet follows last_cc */
+static int check_cc(int pid, int last_cc, const uint8_t *packet)
+{
+    int afc            = (packet[3] >> 4) & 3;
+    int expected_cc    = afc & 1 ? (last_cc + 1) & 0x0f : last_cc;
+    int is_discontinuity = (afc & 2)
+                && packet[4] != 0 /* with length > 0 */
+                && (packet[5] & 0x80); /* and discontinuity indicated */
+
+    return pid == 0x1FFF // null packet PID
+           || is_discontinuity
+           || last_cc < 0
+           || expected_cc == (packet[3] & 0xf);
+}
+
+static void update_pid_stats(MpegTSContext *ts, int pid, const uint8_t *packet)
+{
+    AVMpegTSPIDStats *stats = &ts->pid_stats[pid];
+
+    stats->packets++;
+    stats->bytes += TS_PACKET_SIZE;
+    if (!(packet[3] & 0x30)) /* reserved adaptation field control */
+        return;
+    if (!check_cc(pid, ts->pid_stats_cc[pid], packet))
+        stats->cc_errors++;
+    ts->pid_stats_cc[pid] = packet[3] & 0xf;
+}
+
+#if CONFIG_MPEGTS_DEMUXER
+const AVMpegTSPIDStats *av_mpegts_get_pid_stats(AVFormatContext *s)
+{
+    MpegTSContext *ts;
 
-    return !used && discarded;
+    if (s->iformat != &ff_mpegts_demuxer)
+        return NULL;
+    ts = s->priv_data;
+    return ts->pid_stats;
 }
+#endif
 
 /**
  *  Assemble PES packets out of TS packets, and then call the "section_cb"
@@ -378,23 +530,23 @@ static void mpegts_close_filter(MpegTSContext *ts, MpegTSFilter *filter)
 
 static int analyze(const uint8_t *buf, int size, int packet_size, int *index){
     int stat[TS_MAX_PACKET_SIZE];
-    int i;
-    int x=0;
+    const uint8_t *p = buf, *end = buf + size - 3;
+    int x;
     int best_score=0;
 
     memset(stat, 0, packet_size*sizeof(int));
 
-    for(x=i=0; i<size-3; i++){
-        if(buf[i] == 0x47 && !(buf[i+1] & 0x80) && (buf[i+3] & 0x30)){
+    /* only the sync bytes matter, find them with memchr() */
+    while (p < end && (p = memchr(p, 0x47, end - p))) {
+        if(!(p[1] & 0x80) && (p[3] & 0x30)){
+            x = (p - buf) % packet_size;
             stat[x]++;
             if(stat[x] > best_score){
                 best_score= stat[x];
                 if(index) *index= x;
             }
         }
-
-        x++;
-        if(x == packet_size) x= 0;
+        p++;
     }
 
     return best_score;
@@ -894,7 +1046,14 @@ static int mpegts_push_data(MpegTSFilter *filter,
                 pes->state = MPEGTS_PAYLOAD;
                 pes->data_index = 0;
                 if (pes->stream_type == 0x12 && buf_size > 0) {
-                    int sl_header_bytes = read_sl_header(pes, &pes->sl, p, buf_size);
+                    /* the packet may be read in place without any padding
+                     * for the bit reader */
+                    uint8_t sl_buf[TS_PACKET_SIZE + FF_INPUT_BUFFER_PADDING_SIZE] = { 0 };
+                    int sl_header_bytes;
+
+                    memcpy(sl_buf, p, FFMIN(buf_size, TS_PACKET_SIZE));
+                    sl_header_bytes = read_sl_header(pes, &pes->sl, sl_buf,
+                                                     FFMIN(buf_size, TS_PACKET_SIZE));
                     pes->pes_header_size += sl_header_bytes;
                     p += sl_header_bytes;
                     buf_size -= sl_header_bytes;
@@ -1629,17 +1788,20 @@ static void sdt_cb(MpegTSFilter *filter, const uint8_t *section, int section_len
 }
 
 /* handle one TS packet */
-static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
+/* pos is the position in the stream following the packet */
+static int handle_packet(MpegTSContext *ts, const uint8_t *packet, int64_t pos)
 {
     AVFormatContext *s = ts->stream;
     MpegTSFilter *tss;
-    int len, pid, cc, expected_cc, cc_ok, afc, is_start, is_discontinuity,
-        has_adaptation, has_payload;
+    int len, pid, cc, cc_ok, afc, is_start, has_adaptation, has_payload;
     const uint8_t *p, *p_end;
-    int64_t pos;
 
     pid = AV_RB16(packet + 1) & 0x1fff;
-    if(pid && discard_pid(ts, pid))
+    if (ts->pid_stats)
+        update_pid_stats(ts, pid, packet);
+    if (ts->discard_map_dirty)
+        update_discard_map(ts);
+    if (ts->discard_map[pid >> 5] & (1U << (pid & 31)))
         return 0;
     is_start = packet[1] & 0x40;
     tss = ts->pids[pid];
@@ -1655,28 +1817,21 @@ static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
         return 0;
     has_adaptation = afc & 2;
     has_payload = afc & 1;
-    is_discontinuity = has_adaptation
-                && packet[4] != 0 /* with length > 0 */
-                && (packet[5] & 0x80); /* and discontinuity indicated */
 
     /* continuity check (currently not used) */
     cc = (packet[3] & 0xf);
-    expected_cc = has_payload ? (tss->last_cc + 1) & 0x0f : tss->last_cc;
-    cc_ok = pid == 0x1FFF // null packet PID
-            || is_discontinuity
-            || tss->last_cc < 0
-            || expected_cc == cc;
-
-    tss->last_cc = cc;
+    cc_ok = check_cc(pid, tss->last_cc, packet);
     if (!cc_ok) {
         av_log(ts->stream, AV_LOG_WARNING,
                "Continuity check failed for pid %d expected %d got %d\n",
-               pid, expected_cc, cc);
+               pid, has_payload ? (tss->last_cc + 1) & 0x0f : tss->last_cc,
+               cc);
         if(tss->type == MPEGTS_PES) {
             PESContext *pc = tss->u.pes_filter.opaque;
             pc->flags |= AV_PKT_FLAG_CORRUPT;
         }
     }
+    tss->last_cc = cc;
 
     if (!has_payload)
         return 0;
@@ -1690,7 +1845,6 @@ static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
     if (p >= p_end)
         return 0;
 
-    pos = avio_tell(ts->stream->pb);
     ts->pos47= pos % ts->raw_packet_size;
 
     if (tss->type == MPEGTS_SECTION) {
@@ -1733,35 +1887,38 @@ static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
    get_packet_size() ?) */
 static int mpegts_resync(AVFormatContext *s)
 {
-    AVIOContext *pb = s->pb;
-    int c, i;
+    int ret = ffio_skip_to_byte(s->pb, 0x47, MAX_RESYNC_SIZE);
 
-    for(i = 0;i < MAX_RESYNC_SIZE; i++) {
-        c = avio_r8(pb);
-        if (pb->eof_reached)
-            return -1;
-        if (c == 0x47) {
-            avio_seek(pb, -1, SEEK_CUR);
-            return 0;
-        }
-    }
-    av_log(s, AV_LOG_ERROR, "max resync size reached, could not find sync byte\n");
+    if (ret >= 0)
+        return 0;
+    if (ret == AVERROR_INVALIDDATA)
+        av_log(s, AV_LOG_ERROR, "max resync size reached, could not find sync byte\n");
     /* no sync found */
     return -1;
 }
 
-/* return -1 if error or EOF. Return 0 if OK. */
-static int read_packet(AVFormatContext *s, uint8_t *buf, int raw_packet_size)
+/**
+ * Read a TS packet, in place in the I/O buffer if possible.
+ * finished_reading_packet() must be called once the packet has been used.
+ *
+ * @param buf  buffer of TS_PACKET_SIZE bytes used if the packet cannot be
+ *             read in place
+ * @param data set to the beginning of the packet, valid until the next
+ *             operation on the I/O context
+ * @return 0 on success, a negative value on error or EOF
+ */
+static int read_packet(AVFormatContext *s, uint8_t *buf, int raw_packet_size,
+                       const uint8_t **data)
 {
     AVIOContext *pb = s->pb;
-    int skip, len;
+    int len;
 
     for(;;) {
-        len = avio_read(pb, buf, TS_PACKET_SIZE);
+        len = ffio_read_indirect(pb, buf, TS_PACKET_SIZE, data);
         if (len != TS_PACKET_SIZE)
             return len < 0 ? len : AVERROR_EOF;
         /* check packet sync byte */
-        if (buf[0] != 0x47) {
+        if ((*data)[0] != 0x47) {
             /* find a new packet start */
             avio_seek(pb, -TS_PACKET_SIZE, SEEK_CUR);
             if (mpegts_resync(s) < 0)
@@ -1769,19 +1926,26 @@ static int read_packet(AVFormatContext *s, uint8_t *buf, int raw_packet_size)
             else
                 continue;
         } else {
-            skip = raw_packet_size - TS_PACKET_SIZE;
-            if (skip > 0)
-                avio_skip(pb, skip);
             break;
         }
     }
     return 0;
 }
 
+/* skip the bytes following the TS packet in 192 and 204 byte packets */
+static void finished_reading_packet(AVFormatContext *s, int raw_packet_size)
+{
+    int skip = raw_packet_size - TS_PACKET_SIZE;
+
+    if (skip > 0)
+        avio_skip(s->pb, skip);
+}
+
 static int handle_packets(MpegTSContext *ts, int nb_packets)
 {
     AVFormatContext *s = ts->stream;
-    uint8_t packet[TS_PACKET_SIZE+FF_INPUT_BUFFER_PADDING_SIZE];
+    uint8_t packet[TS_PACKET_SIZE];
+    const uint8_t *data;
     int packet_num, ret = 0;
 
     if (avio_tell(s->pb) != ts->last_pos) {
@@ -1801,19 +1965,22 @@ static int handle_packets(MpegTSContext *ts, int nb_packets)
         }
     }
 
+    check_discard_changes(ts);
+
     ts->stop_parse = 0;
     packet_num = 0;
-    memset(packet + TS_PACKET_SIZE, 0, FF_INPUT_BUFFER_PADDING_SIZE);
     for(;;) {
         if (ts->stop_parse>0)
             break;
         packet_num++;
         if (nb_packets != 0 && packet_num >= nb_packets)
             break;
-        ret = read_packet(s, packet, ts->raw_packet_size);
+        ret = read_packet(s, packet, ts->raw_packet_size, &data);
         if (ret != 0)
             break;
-        ret = handle_packet(ts, packet);
+        ret = handle_packet(ts, data, avio_tell(s->pb) +
+                                      ts->raw_packet_size - TS_PACKET_SIZE);
+        finished_reading_packet(s, ts->raw_packet_size);
         if (ret != 0)
             break;
     }
@@ -1894,6 +2061,17 @@ static int mpegts_read_header(AVFormatContext *s)
     if (s->iformat == &ff_mpegts_demuxer) {
         /* normal demux */
 
+        if (ts->collect_pid_stats) {
+            ts->pid_stats    = av_mallocz(NB_PID_MAX * sizeof(*ts->pid_stats));
+            ts->pid_stats_cc = av_malloc(NB_PID_MAX);
+            if (!ts->pid_stats || !ts->pid_stats_cc) {
+                av_freep(&ts->pid_stats);
+                av_freep(&ts->pid_stats_cc);
+                return AVERROR(ENOMEM);
+            }
+            memset(ts->pid_stats_cc, -1, NB_PID_MAX);
+        }
+
         /* first do a scan to get all the services */
         if (avio_seek(pb, pos, SEEK_SET) < 0 && pb->seekable)
             av_log(s, AV_LOG_ERROR, "Unable to seek back to the start\n");
@@ -1903,6 +2081,11 @@ static int mpegts_read_header(AVFormatContext *s)
         mpegts_open_section_filter(ts, PAT_PID, pat_cb, ts, 1);
 
         handle_packets(ts, s->probesize / ts->raw_packet_size);
+        /* the scanned packets are read again after seeking back */
+        if (ts->pid_stats) {
+            memset(ts->pid_stats, 0, NB_PID_MAX * sizeof(*ts->pid_stats));
+            memset(ts->pid_stats_cc, -1, NB_PID_MAX);
+        }
         /* if could not find service, enable auto_guess */
 
         ts->auto_guess = 1;
@@ -1916,6 +2099,7 @@ static int mpegts_read_header(AVFormatContext *s)
         int64_t pcrs[2], pcr_h;
         int packet_count[2];
         uint8_t packet[TS_PACKET_SIZE];
+        const uint8_t *data;
 
         /* only read packets */
 
@@ -1931,19 +2115,20 @@ static int mpegts_read_header(AVFormatContext *s)
         nb_pcrs = 0;
         nb_packets = 0;
         for(;;) {
-            ret = read_packet(s, packet, ts->raw_packet_size);
+            ret = read_packet(s, packet, ts->raw_packet_size, &data);
             if (ret < 0)
                 return -1;
-            pid = AV_RB16(packet + 1) & 0x1fff;
+            pid = AV_RB16(data + 1) & 0x1fff;
             if ((pcr_pid == -1 || pcr_pid == pid) &&
-                parse_pcr(&pcr_h, &pcr_l, packet) == 0) {
+                parse_pcr(&pcr_h, &pcr_l, data) == 0) {
                 pcr_pid = pid;
                 packet_count[nb_pcrs] = nb_packets;
                 pcrs[nb_pcrs] = pcr_h * 300 + pcr_l;
                 nb_pcrs++;
-                if (nb_pcrs >= 2)
-                    break;
             }
+            finished_reading_packet(s, ts->raw_packet_size);
+            if (nb_pcrs >= 2)
+                break;
             nb_packets++;
         }
 
@@ -1974,15 +2159,19 @@ static int mpegts_raw_read_packet(AVFormatContext *s,
     int64_t pcr_h, next_pcr_h, pos;
     int pcr_l, next_pcr_l;
     uint8_t pcr_buf[12];
+    const uint8_t *data;
 
     if (av_new_packet(pkt, TS_PACKET_SIZE) < 0)
         return AVERROR(ENOMEM);
     pkt->pos= avio_tell(s->pb);
-    ret = read_packet(s, pkt->data, ts->raw_packet_size);
+    ret = read_packet(s, pkt->data, ts->raw_packet_size, &data);
     if (ret < 0) {
         av_free_packet(pkt);
         return ret;
     }
+    if (data != pkt->data)
+        memcpy(pkt->data, data, TS_PACKET_SIZE);
+    finished_reading_packet(s, ts->raw_packet_size);
     if (ts->mpeg2ts_compute_pcr) {
         /* compute exact PCR for each packet */
         if (parse_pcr(&pcr_h, &pcr_l, pkt->data) == 0) {
@@ -2049,6 +2238,9 @@ static int mpegts_read_close(AVFormatContext *s)
     for(i=0;i<NB_PID_MAX;i++)
         if (ts->pids[i]) mpegts_close_filter(ts, ts->pids[i]);
 
+    av_freep(&ts->discard_snapshot);
+    av_freep(&ts->pid_stats);
+    av_freep(&ts->pid_stats_cc);
     return 0;
 }
 
@@ -2141,6 +2333,7 @@ int ff_mpegts_parse_packet(MpegTSContext *ts, AVPacket *pkt,
     len1 = len;
     ts->pkt = pkt;
     ts->stop_parse = 0;
+    check_discard_changes(ts);
     for(;;) {
         if (ts->stop_parse>0)
             break;
@@ -2150,7 +2343,7 @@ int ff_mpegts_parse_packet(MpegTSContext *ts, AVPacket *pkt,
             buf++;
             len--;
         } else {
-            handle_packet(ts, buf);
+            handle_packet(ts, buf, avio_tell(ts->stream->pb));
             buf += TS_PACKET_SIZE;
             len -= TS_PACKET_SIZE;
         }
@@ -2164,6 +2357,7 @@ void ff_mpegts_parse_close(MpegTSContext *ts)
 
     for(i=0;i<NB_PID_MAX;i++)
         av_free(ts->pids[i]);
+    av_free(ts->discard_snapshot);
     av_free(ts);
 }
 
@@ -2178,6 +2372,7 @@ AVInputFormat ff_mpegts_demuxer = {
     .read_seek      = read_seek,
     .read_timestamp = mpegts_get_pcr,
     .flags          = AVFMT_SHOW_IDS | AVFMT_TS_DISCONT,
+    .priv_class     = &mpegts_class,
 };
 
 AVInputFormat ff_mpegtsraw_demuxer = {
@@ -26,6 +26,7 @@
 #include "libavutil/opt.h"
 #include "libavcodec/mpegvideo.h"
 #include "avformat.h"
+#include "avio_internal.h"
 #include "internal.h"
 #include "mpegts.h"
 
@@ -1127,7 +1128,9 @@ static int mpegts_write_packet(AVFormatContext *s, AVPacket *pkt)
         mpegts_write_flush(s);
         return 1;
     } else {
-        return mpegts_write_packet_internal(s, pkt);
+        int ret = mpegts_write_packet_internal(s, pkt);
+        ffio_batch_flush(s->pb);
+        return ret;
     }
 }
 
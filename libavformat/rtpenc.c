@@ -20,6 +20,7 @@
  */
 
 #include "avformat.h"
+#include "avio_internal.h"
 #include "mpegts.h"
 #include "internal.h"
 #include "libavutil/mathematics.h"
@@ -437,7 +438,7 @@ static int rtp_send_ilbc(AVFormatContext *s1, const uint8_t *buf, int size)
     return 0;
 }
 
-static int rtp_write_packet(AVFormatContext *s1, AVPacket *pkt)
+static int rtp_send_packet(AVFormatContext *s1, AVPacket *pkt)
 {
     RTPMuxContext *s = s1->priv_data;
     AVStream *st = s1->streams[0];
@@ -532,6 +533,15 @@ static int rtp_write_packet(AVFormatContext *s1, AVPacket *pkt)
     return 0;
 }
 
+static int rtp_write_packet(AVFormatContext *s1, AVPacket *pkt)
+{
+    int ret = rtp_send_packet(s1, pkt);
+
+    /* all RTP packets of this frame are queued, send them out together */
+    ffio_batch_flush(s1->pb);
+    return ret;
+}
+
 static int rtp_write_trailer(AVFormatContext *s1)
 {
     RTPMuxContext *s = s1->priv_data;
@@ -102,7 +102,7 @@ static av_printf_format(3, 4) void url_add_option(char *buf, int buf_size, const
 static void build_udp_url(char *buf, int buf_size,
                           const char *hostname, int port,
                           int local_port, int ttl,
-                          int max_packet_size, int connect)
+                          int max_packet_size, int connect, int batch_size)
 {
     ff_url_join(buf, buf_size, "udp", NULL, hostname, port, NULL);
     if (local_port >= 0)
@@ -113,6 +113,8 @@ static void build_udp_url(char *buf, int buf_size,
         url_add_option(buf, buf_size, "pkt_size=%d", max_packet_size);
     if (connect)
         url_add_option(buf, buf_size, "connect=1");
+    if (batch_size > 1)
+        url_add_option(buf, buf_size, "batch_size=%d", batch_size);
 }
 
 /**
@@ -123,6 +125,8 @@ static void build_udp_url(char *buf, int buf_size,
  *         'localrtcpport=n'  : set the local rtcp port to n
  *         'pkt_size=n'       : set max packet size
  *         'connect=0/1'      : do a connect() on the UDP socket
+ *         'batch_size=n'     : queue up to n outgoing RTP packets and send
+ *                              them with a single system call
  * deprecated option:
  *         'localport=n'      : set the local port to n
  *
@@ -136,7 +140,7 @@ static int rtp_open(URLContext *h, const char *uri, int flags)
 {
     RTPContext *s = h->priv_data;
     int rtp_port, rtcp_port,
-        ttl, connect,
+        ttl, connect, batch_size,
         local_rtp_port, local_rtcp_port, max_packet_size;
     char hostname[256];
     char buf[1024];
@@ -152,6 +156,7 @@ static int rtp_open(URLContext *h, const char *uri, int flags)
     local_rtcp_port = -1;
     max_packet_size = -1;
     connect = 0;
+    batch_size = 0;
 
     p = strchr(uri, '?');
     if (p) {
@@ -176,11 +181,18 @@ static int rtp_open(URLContext *h, const char *uri, int flags)
         if (av_find_info_tag(buf, sizeof(buf), "connect", p)) {
             connect = strtol(buf, NULL, 10);
         }
+        if (av_find_info_tag(buf, sizeof(buf), "batch_size", p)) {
+            batch_size = strtol(buf, NULL, 10);
+        }
     }
+    /* rtp_read() reads from the sockets directly, and the few RTCP packets
+     * should not be held back */
+    if (!(flags & AVIO_FLAG_WRITE))
+        batch_size = 0;
 
     build_udp_url(buf, sizeof(buf),
                   hostname, rtp_port, local_rtp_port, ttl, max_packet_size,
-                  connect);
+                  connect, batch_size);
     if (ffurl_open(&s->rtp_hd, buf, flags, &h->interrupt_callback, NULL) < 0)
         goto fail;
     if (local_rtp_port>=0 && local_rtcp_port<0)
@@ -188,7 +200,7 @@ static int rtp_open(URLContext *h, const char *uri, int flags)
 
     build_udp_url(buf, sizeof(buf),
                   hostname, rtcp_port, local_rtcp_port, ttl, max_packet_size,
-                  connect);
+                  connect, 0);
     if (ffurl_open(&s->rtcp_hd, buf, flags, &h->interrupt_callback, NULL) < 0)
         goto fail;
 
@@ -276,6 +288,13 @@ static int rtp_write(URLContext *h, const uint8_t *buf, int size)
     return ret;
 }
 
+static int rtp_flush(URLContext *h)
+{
+    RTPContext *s = h->priv_data;
+
+    return ffurl_flush(s->rtp_hd);
+}
+
 static int rtp_close(URLContext *h)
 {
     RTPContext *s = h->priv_data;
@@ -326,6 +345,7 @@ URLProtocol ff_rtp_protocol = {
     .url_read            = rtp_read,
     .url_write           = rtp_write,
     .url_close           = rtp_close,
+    .url_flush           = rtp_flush,
     .url_get_file_handle = rtp_get_file_handle,
     .priv_data_size      = sizeof(RTPContext),
     .flags               = URL_PROTOCOL_FLAG_NETWORK,
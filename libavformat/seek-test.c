@@ -71,13 +71,22 @@ int main(int argc, char **argv)
     /* initialize libavcodec, and register all codecs and formats */
     av_register_all();
 
-    if (argc != 2) {
-        printf("usage: %s input_file\n"
+    if (argc < 2) {
+        printf("usage: %s input_file [option=value ...]\n"
                "\n", argv[0]);
         return 1;
     }
 
     filename = argv[1];
+    for (i = 2; i < argc; i++) {
+        char *value = strchr(argv[i], '=');
+        if (!value) {
+            fprintf(stderr, "invalid option %s\n", argv[i]);
+            return 1;
+        }
+        *value++ = 0;
+        av_dict_set(&format_opts, argv[i], value, 0);
+    }
 
     ret = avformat_open_input(&ic, filename, NULL, &format_opts);
     av_dict_free(&format_opts);
@@ -25,22 +25,32 @@
  */
 
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for recvmmsg() and sendmmsg() */
 
 #include "avformat.h"
 #include "avio_internal.h"
 #include "libavutil/parseutils.h"
+#include "libavutil/fifo.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/avstring.h"
+#include "libavutil/opt.h"
+#include "libavutil/time.h"
 #include "internal.h"
 #include "network.h"
 #include "os_support.h"
 #include "url.h"
 
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 #ifndef IPV6_ADD_MEMBERSHIP
 #define IPV6_ADD_MEMBERSHIP IPV6_JOIN_GROUP
 #define IPV6_DROP_MEMBERSHIP IPV6_LEAVE_GROUP
 #endif
 
 typedef struct {
+    const AVClass *class;
     int udp_fd;
     int ttl;
     int buffer_size;
@@ -50,10 +60,39 @@ typedef struct {
     struct sockaddr_storage dest_addr;
     int dest_addr_len;
     int is_connected;
+
+    /* circular receive buffer */
+    int circular_buffer_size;
+    int overrun_nonfatal;
+    AVFifoBuffer *fifo;
+    int circular_buffer_error;
+    int thread_exit;
+    int64_t bytes_dropped;
+    int packets_dropped;
+    int max_fifo_fill;              ///< highest number of bytes buffered so far
+#if HAVE_PTHREADS
+    pthread_t circular_buffer_thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+
+    /* batched sending and receiving */
+    int batch_size;
+    int batch_slot_size;
+    uint8_t *batch_buf;             ///< batch_size slots of batch_slot_size bytes
+    int *batch_len;
+    int batch_count;                ///< number of datagrams queued or received
+    int batch_pos;                  ///< next received datagram to return
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    struct mmsghdr *msgs;
+    struct iovec *iov;
+#endif
 } UDPContext;
 
 #define UDP_TX_BUF_SIZE 32768
 #define UDP_MAX_PKT_SIZE 65536
+#define UDP_FIFO_PKT_SIZE 188
+#define UDP_MAX_BATCH_SIZE 1024
 
 static void log_net_error(void *ctx, int level, const char* prefix)
 {
@@ -378,6 +417,245 @@ static int udp_get_file_handle(URLContext *h)
     return s->udp_fd;
 }
 
+static int udp_alloc_batch(URLContext *h, int slot_size)
+{
+    UDPContext *s = h->priv_data;
+
+    s->batch_slot_size = slot_size;
+    s->batch_buf = av_malloc(s->batch_size * slot_size);
+    s->batch_len = av_malloc(s->batch_size * sizeof(*s->batch_len));
+    if (!s->batch_buf || !s->batch_len)
+        return AVERROR(ENOMEM);
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    s->msgs = av_malloc(s->batch_size * sizeof(*s->msgs));
+    s->iov  = av_malloc(s->batch_size * sizeof(*s->iov));
+    if (!s->msgs || !s->iov)
+        return AVERROR(ENOMEM);
+#endif
+    return 0;
+}
+
+static void udp_free_batch(UDPContext *s)
+{
+    av_freep(&s->batch_buf);
+    av_freep(&s->batch_len);
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+    av_freep(&s->msgs);
+    av_freep(&s->iov);
+#endif
+}
+
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+static void udp_setup_msgs(UDPContext *s, int count, int sending)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        struct msghdr *hdr = &s->msgs[i].msg_hdr;
+
+        s->iov[i].iov_base = s->batch_buf + i * s->batch_slot_size;
+        s->iov[i].iov_len  = sending ? s->batch_len[i] : s->batch_slot_size;
+        memset(hdr, 0, sizeof(*hdr));
+        hdr->msg_iov    = &s->iov[i];
+        hdr->msg_iovlen = 1;
+        if (sending && !s->is_connected) {
+            hdr->msg_name    = &s->dest_addr;
+            hdr->msg_namelen = s->dest_addr_len;
+        }
+    }
+}
+#endif
+
+/**
+ * Receive into the batch slots, with a single recvmmsg() call if
+ * available and batching was requested, or a single datagram otherwise.
+ * @return the number of datagrams received or an AVERROR code
+ */
+static int udp_recv_batch(URLContext *h)
+{
+    UDPContext *s = h->priv_data;
+    int ret;
+
+#if HAVE_RECVMMSG
+    if (s->batch_size > 1) {
+        int i;
+
+        udp_setup_msgs(s, s->batch_size, 0);
+        ret = recvmmsg(s->udp_fd, s->msgs, s->batch_size, 0, NULL);
+        if (ret < 0)
+            return ff_neterrno();
+        for (i = 0; i < ret; i++) {
+            s->batch_len[i] = s->msgs[i].msg_len;
+            if (s->msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+                av_log(h, AV_LOG_WARNING,
+                       "Datagram truncated to %d bytes, increase pkt_size\n",
+                       s->batch_slot_size);
+        }
+    } else
+#endif
+    {
+        ret = recv(s->udp_fd, s->batch_buf, s->batch_slot_size, 0);
+        if (ret < 0)
+            return ff_neterrno();
+        s->batch_len[0] = ret;
+        ret = 1;
+    }
+    s->batch_count = ret;
+    s->batch_pos   = 0;
+    return ret;
+}
+
+#if HAVE_PTHREADS
+/**
+ * Drain the socket into the circular buffer, so that datagrams are not
+ * lost in the kernel while the reading thread is busy.
+ * Each datagram is stored as its 32-bit length followed by the payload.
+ */
+/* queue a datagram in the circular buffer, called with the mutex held */
+static int circular_buffer_put(URLContext *h, uint8_t *buf, int len)
+{
+    UDPContext *s = h->priv_data;
+    uint8_t tmp[4];
+
+    if (av_fifo_space(s->fifo) < len + 4) {
+        if (!s->packets_dropped++ || !s->overrun_nonfatal)
+            av_log(h, s->overrun_nonfatal ? AV_LOG_WARNING : AV_LOG_ERROR,
+                   "Circular buffer overrun, increase fifo_size%s\n",
+                   s->overrun_nonfatal ? "" :
+                   " or set overrun_nonfatal to drop packets instead");
+        s->bytes_dropped += len;
+        return s->overrun_nonfatal ? 0 : AVERROR(EIO);
+    }
+    AV_WL32(tmp, len);
+    av_fifo_generic_write(s->fifo, tmp, 4, NULL);
+    av_fifo_generic_write(s->fifo, buf, len, NULL);
+    s->max_fifo_fill = FFMAX(s->max_fifo_fill, av_fifo_size(s->fifo));
+    return 0;
+}
+
+static void *circular_buffer_task(void *arg)
+{
+    URLContext *h = arg;
+    UDPContext *s = h->priv_data;
+
+    for (;;) {
+        int i, n, ret;
+
+        ret = ff_network_wait_fd(s->udp_fd, 0);
+        pthread_mutex_lock(&s->mutex);
+        if (s->thread_exit)
+            break;
+        pthread_mutex_unlock(&s->mutex);
+        if (ret == AVERROR(EAGAIN))
+            continue;
+
+        n = udp_recv_batch(h);
+
+        pthread_mutex_lock(&s->mutex);
+        if (n < 0) {
+            if (n != AVERROR(EAGAIN) && n != AVERROR(EINTR)) {
+                s->circular_buffer_error = n;
+                break;
+            }
+            pthread_mutex_unlock(&s->mutex);
+            continue;
+        }
+        for (i = 0; i < n; i++) {
+            ret = circular_buffer_put(h, s->batch_buf + i * s->batch_slot_size,
+                                      s->batch_len[i]);
+            if (ret < 0) {
+                s->circular_buffer_error = ret;
+                goto end;
+            }
+        }
+        pthread_cond_signal(&s->cond);
+        pthread_mutex_unlock(&s->mutex);
+    }
+
+end:
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+    return NULL;
+}
+
+static int circular_buffer_init(URLContext *h)
+{
+    UDPContext *s = h->priv_data;
+
+    s->fifo = av_fifo_alloc(s->circular_buffer_size);
+    if (!s->fifo)
+        return AVERROR(ENOMEM);
+
+    pthread_mutex_init(&s->mutex, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    if (pthread_create(&s->circular_buffer_thread, NULL,
+                       circular_buffer_task, h)) {
+        av_log(h, AV_LOG_ERROR, "pthread_create failed\n");
+        pthread_mutex_destroy(&s->mutex);
+        pthread_cond_destroy(&s->cond);
+        av_fifo_free(s->fifo);
+        s->fifo = NULL;
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
+static int circular_buffer_read(URLContext *h, uint8_t *buf, int size)
+{
+    UDPContext *s = h->priv_data;
+    int ret;
+
+    pthread_mutex_lock(&s->mutex);
+    if (!av_fifo_size(s->fifo) && !s->circular_buffer_error &&
+        !(h->flags & AVIO_FLAG_NONBLOCK)) {
+        /* wake up regularly so that the caller can check for interrupts */
+        int64_t t = av_gettime() + 100000;
+        struct timespec tv = { .tv_sec  =  t / 1000000,
+                               .tv_nsec = (t % 1000000) * 1000 };
+        pthread_cond_timedwait(&s->cond, &s->mutex, &tv);
+    }
+    if (av_fifo_size(s->fifo)) {
+        uint8_t tmp[4];
+        int len;
+
+        av_fifo_generic_read(s->fifo, tmp, 4, NULL);
+        len = ret = AV_RL32(tmp);
+        if (ret > size) {
+            av_log(h, AV_LOG_WARNING,
+                   "Part of datagram lost due to insufficient buffer size\n");
+            ret = size;
+        }
+        av_fifo_generic_read(s->fifo, buf, ret, NULL);
+        av_fifo_drain(s->fifo, len - ret);
+    } else if (s->circular_buffer_error) {
+        ret = s->circular_buffer_error;
+    } else
+        ret = AVERROR(EAGAIN);
+    pthread_mutex_unlock(&s->mutex);
+
+    return ret;
+}
+
+static void circular_buffer_close(URLContext *h)
+{
+    UDPContext *s = h->priv_data;
+
+    pthread_mutex_lock(&s->mutex);
+    s->thread_exit = 1;
+    pthread_mutex_unlock(&s->mutex);
+    pthread_join(s->circular_buffer_thread, NULL);
+    pthread_mutex_destroy(&s->mutex);
+    pthread_cond_destroy(&s->cond);
+
+    av_log(h, s->packets_dropped ? AV_LOG_WARNING : AV_LOG_VERBOSE,
+           "Circular buffer: %d packets (%"PRId64" bytes) dropped, "
+           "%d of %d bytes used at most\n", s->packets_dropped,
+           s->bytes_dropped, s->max_fifo_fill, s->circular_buffer_size);
+
+    av_fifo_free(s->fifo);
+}
+#endif
+
 /* put it in UDP context */
 /* return non zero if error */
 static int udp_open(URLContext *h, const char *uri, int flags)
@@ -430,6 +708,21 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         if (av_find_info_tag(buf, sizeof(buf), "localaddr", p)) {
             av_strlcpy(localaddr, buf, sizeof(localaddr));
         }
+        if (av_find_info_tag(buf, sizeof(buf), "fifo_size", p)) {
+            int64_t units = strtoll(buf, NULL, 10);
+            if (units < 0) {
+                av_log(h, AV_LOG_ERROR, "Invalid fifo_size %s\n", buf);
+                goto fail;
+            }
+            s->circular_buffer_size = FFMIN(units, INT_MAX / UDP_FIFO_PKT_SIZE) *
+                                      UDP_FIFO_PKT_SIZE;
+        }
+        if (av_find_info_tag(buf, sizeof(buf), "overrun_nonfatal", p)) {
+            s->overrun_nonfatal = strtol(buf, NULL, 10);
+        }
+        if (av_find_info_tag(buf, sizeof(buf), "batch_size", p)) {
+            s->batch_size = av_clip(strtol(buf, NULL, 10), 1, UDP_MAX_BATCH_SIZE);
+        }
         if (av_find_info_tag(buf, sizeof(buf), "sources", p))
             include = 1;
         if (include || av_find_info_tag(buf, sizeof(buf), "block", p)) {
@@ -552,10 +845,33 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         av_free(sources[i]);
 
     s->udp_fd = udp_fd;
+
+#if !HAVE_PTHREADS
+    if (s->circular_buffer_size > 0) {
+        av_log(h, AV_LOG_WARNING,
+               "fifo_size is not supported without pthreads, ignoring\n");
+        s->circular_buffer_size = 0;
+    }
+#endif
+    if (is_output)
+        s->circular_buffer_size = 0;
+    if (s->batch_size > 1 || s->circular_buffer_size > 0) {
+        /* without batching the receive thread takes one datagram at a time */
+        if (s->batch_size < 1)
+            s->batch_size = 1;
+        if (udp_alloc_batch(h, s->batch_size > 1 ? h->max_packet_size
+                                                 : UDP_MAX_PKT_SIZE) < 0)
+            goto fail;
+    }
+#if HAVE_PTHREADS
+    if (s->circular_buffer_size > 0 && circular_buffer_init(h) < 0)
+        goto fail;
+#endif
     return 0;
  fail:
     if (udp_fd >= 0)
         closesocket(udp_fd);
+    udp_free_batch(s);
     for (i = 0; i < num_sources; i++)
         av_free(sources[i]);
     return AVERROR(EIO);
@@ -566,26 +882,42 @@ static int udp_read(URLContext *h, uint8_t *buf, int size)
     UDPContext *s = h->priv_data;
     int ret;
 
+#if HAVE_PTHREADS
+    if (s->fifo)
+        return circular_buffer_read(h, buf, size);
+#endif
+
+#if HAVE_RECVMMSG
+    if (s->batch_size > 1 && s->batch_pos < s->batch_count) {
+        uint8_t *slot = s->batch_buf + s->batch_pos * s->batch_slot_size;
+        ret = FFMIN(size, s->batch_len[s->batch_pos]);
+        memcpy(buf, slot, ret);
+        s->batch_pos++;
+        return ret;
+    }
+#endif
+
     if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
         ret = ff_network_wait_fd(s->udp_fd, 0);
         if (ret < 0)
             return ret;
     }
+#if HAVE_RECVMMSG
+    if (s->batch_size > 1) {
+        ret = udp_recv_batch(h);
+        if (ret < 0)
+            return ret;
+        return udp_read(h, buf, size);
+    }
+#endif
     ret = recv(s->udp_fd, buf, size, 0);
     return ret < 0 ? ff_neterrno() : ret;
 }
 
-static int udp_write(URLContext *h, const uint8_t *buf, int size)
+static int udp_send(UDPContext *s, const uint8_t *buf, int size)
 {
-    UDPContext *s = h->priv_data;
     int ret;
 
-    if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
-        ret = ff_network_wait_fd(s->udp_fd, 1);
-        if (ret < 0)
-            return ret;
-    }
-
     if (!s->is_connected) {
         ret = sendto (s->udp_fd, buf, size, 0,
                       (struct sockaddr *) &s->dest_addr,
@@ -596,23 +928,119 @@ static int udp_write(URLContext *h, const uint8_t *buf, int size)
     return ret < 0 ? ff_neterrno() : ret;
 }
 
+/**
+ * Send out all queued datagrams, with as few sendmmsg() calls as possible
+ * if available, or one at a time otherwise.
+ */
+static int udp_flush(URLContext *h)
+{
+    UDPContext *s = h->priv_data;
+    int sent = 0, ret = 0;
+
+    if (s->batch_size <= 1 || !s->batch_count)
+        return 0;
+
+#if HAVE_SENDMMSG
+    udp_setup_msgs(s, s->batch_count, 1);
+#endif
+    while (sent < s->batch_count) {
+#if HAVE_SENDMMSG
+        ret = sendmmsg(s->udp_fd, s->msgs + sent, s->batch_count - sent, 0);
+        if (ret < 0)
+            ret = ff_neterrno();
+#else
+        ret = udp_send(s, s->batch_buf + sent * s->batch_slot_size,
+                       s->batch_len[sent]);
+        if (ret >= 0)
+            ret = 1;
+#endif
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR(EINTR)) {
+            if (ff_check_interrupt(&h->interrupt_callback)) {
+                ret = AVERROR_EXIT;
+                break;
+            }
+            ret = ff_network_wait_fd(s->udp_fd, 1);
+            if (ret < 0 && ret != AVERROR(EAGAIN))
+                break;
+            continue;
+        }
+        if (ret < 0)
+            break;
+        sent += ret;
+    }
+    /* datagrams that could not be sent are dropped, like with udp_write() */
+    s->batch_count = 0;
+    return ret < 0 ? ret : 0;
+}
+
+static int udp_write(URLContext *h, const uint8_t *buf, int size)
+{
+    UDPContext *s = h->priv_data;
+    int ret;
+
+    if (s->batch_size > 1 && size <= s->batch_slot_size) {
+        memcpy(s->batch_buf + s->batch_count * s->batch_slot_size, buf, size);
+        s->batch_len[s->batch_count++] = size;
+        if (s->batch_count == s->batch_size &&
+            (ret = udp_flush(h)) < 0)
+            return ret;
+        return size;
+    }
+    /* datagrams larger than a slot bypass the queue, keeping the order */
+    if (s->batch_count && (ret = udp_flush(h)) < 0)
+        return ret;
+
+    if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
+        ret = ff_network_wait_fd(s->udp_fd, 1);
+        if (ret < 0)
+            return ret;
+    }
+
+    return udp_send(s, buf, size);
+}
+
 static int udp_close(URLContext *h)
 {
     UDPContext *s = h->priv_data;
 
+    if (h->flags & AVIO_FLAG_WRITE)
+        udp_flush(h);
+#if HAVE_PTHREADS
+    if (s->fifo)
+        circular_buffer_close(h);
+#endif
     if (s->is_multicast && (h->flags & AVIO_FLAG_READ))
         udp_leave_multicast_group(s->udp_fd, (struct sockaddr *)&s->dest_addr);
     closesocket(s->udp_fd);
+    udp_free_batch(s);
     return 0;
 }
 
+#define OFFSET(x) offsetof(UDPContext, x)
+#define RO AV_OPT_FLAG_READONLY
+static const AVOption options[] = {
+    { "packets_dropped", "datagrams dropped because the circular buffer was full", OFFSET(packets_dropped), AV_OPT_TYPE_INT,   { .dbl = 0 }, 0, INT_MAX,   RO },
+    { "bytes_dropped",   "bytes dropped because the circular buffer was full",     OFFSET(bytes_dropped),   AV_OPT_TYPE_INT64, { .dbl = 0 }, 0, INT64_MAX, RO },
+    { "max_fifo_fill",   "highest number of bytes held in the circular buffer",    OFFSET(max_fifo_fill),   AV_OPT_TYPE_INT,   { .dbl = 0 }, 0, INT_MAX,   RO },
+    { NULL }
+};
+
+static const AVClass udp_class = {
+    .class_name = "udp",
+    .item_name  = av_default_item_name,
+    .option     = options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 URLProtocol ff_udp_protocol = {
     .name                = "udp",
     .url_open            = udp_open,
     .url_read            = udp_read,
     .url_write           = udp_write,
     .url_close           = udp_close,
+    .url_flush           = udp_flush,
     .url_get_file_handle = udp_get_file_handle,
     .priv_data_size      = sizeof(UDPContext),
+    .priv_data_class     = &udp_class,
     .flags               = URL_PROTOCOL_FLAG_NETWORK,
 };
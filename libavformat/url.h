@@ -86,6 +86,11 @@ typedef struct URLProtocol {
     const AVClass *priv_data_class;
     int flags;
     int (*url_check)(URLContext *h, int mask);
+    /**
+     * Send out any data that the protocol has held back, e.g. datagrams
+     * queued for a batched send.
+     */
+    int (*url_flush)(URLContext *h);
 } URLProtocol;
 
 /**
@@ -201,6 +206,14 @@ int64_t ffurl_size(URLContext *h);
  */
 int ffurl_get_file_handle(URLContext *h);
 
+/**
+ * Send out data the protocol has queued instead of writing it immediately.
+ *
+ * @return a negative value if an error condition occurred, 0
+ * otherwise
+ */
+int ffurl_flush(URLContext *h);
+
 /**
  * Signal the URLContext that we are done reading or writing the stream.
  *
@@ -1035,6 +1035,128 @@ static void free_packet_buffer(AVPacketList **pkt_buf, AVPacketList **pkt_buf_en
     *pkt_buf_end = NULL;
 }
 
+/* stable sort of index entries by timestamp, tmp holds nb entries */
+static void sort_index_entries(AVIndexEntry *entries, AVIndexEntry *tmp, int nb)
+{
+    int width, i;
+
+    for (width = 1; width < nb; width *= 2) {
+        for (i = 0; i < nb; i += 2 * width) {
+            int a = i, a_end = FFMIN(i + width, nb);
+            int b = a_end, b_end = FFMIN(i + 2 * width, nb), j = i;
+
+            while (a < a_end && b < b_end)
+                tmp[j++] = entries[b].timestamp < entries[a].timestamp ?
+                           entries[b++] : entries[a++];
+            while (a < a_end)
+                tmp[j++] = entries[a++];
+            while (b < b_end)
+                tmp[j++] = entries[b++];
+        }
+        memcpy(entries, tmp, nb * sizeof(*entries));
+    }
+}
+
+/* append e to entries, replacing the last entry if it has the same
+ * timestamp as ff_add_index_entry() does */
+static void merge_index_entry(AVIndexEntry *entries, int *nb,
+                              const AVIndexEntry *e)
+{
+    AVIndexEntry *last = *nb ? &entries[*nb - 1] : NULL;
+
+    if (last && last->timestamp == e->timestamp) {
+        int distance = e->min_distance;
+        if (last->pos == e->pos && distance < last->min_distance)
+            distance = last->min_distance;
+        *last = *e;
+        last->min_distance = distance;
+    } else {
+        entries[(*nb)++] = *e;
+    }
+}
+
+/**
+ * Merge the pending entries of the generic index into the index.
+ * On allocation failure, they are dropped.
+ */
+static void flush_index_entries(AVStream *st)
+{
+    AVIndexEntry *pending = st->pending_index_entries;
+    AVIndexEntry *entries = st->index_entries, *merged;
+    int nb_pending = st->nb_pending_index_entries, nb = 0, i = 0, j = 0;
+    int nb_entries = st->nb_index_entries;
+
+    if (!nb_pending)
+        return;
+    st->nb_pending_index_entries = 0;
+
+    if ((unsigned)nb_entries + nb_pending >= UINT_MAX / sizeof(*merged))
+        return;
+    merged = av_malloc((nb_entries + nb_pending) * sizeof(*merged));
+    if (!merged)
+        return;
+    /* the merged buffer is large enough to serve as sorting space */
+    sort_index_entries(pending, merged, nb_pending);
+
+    /* the entries of the index were added before the pending ones */
+    while (i < nb_entries && j < nb_pending) {
+        if (pending[j].timestamp < entries[i].timestamp)
+            merge_index_entry(merged, &nb, &pending[j++]);
+        else
+            merge_index_entry(merged, &nb, &entries[i++]);
+    }
+    while (i < nb_entries)
+        merge_index_entry(merged, &nb, &entries[i++]);
+    while (j < nb_pending)
+        merge_index_entry(merged, &nb, &pending[j++]);
+
+    av_free(st->index_entries);
+    st->index_entries                = merged;
+    st->nb_index_entries             = nb;
+    st->index_entries_allocated_size = (nb_entries + nb_pending) * sizeof(*merged);
+}
+
+/**
+ * Add a keyframe to the generic index. Entries which do not go at the end
+ * of the index are queued and merged into it all at once, instead of
+ * moving the end of the index for each of them.
+ */
+static void add_generic_index_entry(AVFormatContext *s, AVStream *st,
+                                    int64_t pos, int64_t timestamp)
+{
+    AVIndexEntry *entries;
+
+    ff_reduce_index(s, st->index);
+
+    if (!st->nb_index_entries ||
+        timestamp >= st->index_entries[st->nb_index_entries - 1].timestamp) {
+        ff_add_index_entry(&st->index_entries, &st->nb_index_entries,
+                           &st->index_entries_allocated_size, pos,
+                           timestamp, 0, 0, AVINDEX_KEYFRAME);
+        return;
+    }
+
+    /* merging costs a pass over the index, do it once it doubled at most */
+    if (st->nb_pending_index_entries >= FFMAX(st->nb_index_entries, 1024))
+        flush_index_entries(st);
+
+    if ((unsigned)st->nb_pending_index_entries + 1 >= UINT_MAX / sizeof(AVIndexEntry))
+        return;
+    entries = av_fast_realloc(st->pending_index_entries,
+                              &st->pending_index_entries_allocated_size,
+                              (st->nb_pending_index_entries + 1) *
+                              sizeof(AVIndexEntry));
+    if (!entries)
+        return;
+    st->pending_index_entries = entries;
+    entries += st->nb_pending_index_entries++;
+    entries->pos          = pos;
+    entries->timestamp    = timestamp;
+    entries->size         = 0;
+    entries->min_distance = 0;
+    entries->flags        = AVINDEX_KEYFRAME;
+}
+
 /**
  * Parse a packet, add all split parts to parse_queue
  *
@@ -1102,11 +1224,9 @@ static int parse_packet(AVFormatContext *s, AVPacket *pkt, int stream_index)
         compute_pkt_fields(s, st, st->parser, &out_pkt);
 
         if ((s->iformat->flags & AVFMT_GENERIC_INDEX) &&
-            out_pkt.flags & AV_PKT_FLAG_KEY) {
-            ff_reduce_index(s, st->index);
-            av_add_index_entry(st, st->parser->frame_offset, out_pkt.dts,
-                               0, 0, AVINDEX_KEYFRAME);
-        }
+            out_pkt.flags & AV_PKT_FLAG_KEY)
+            add_generic_index_entry(s, st, st->parser->frame_offset,
+                                    out_pkt.dts);
 
         if (out_pkt.data == pkt->data && out_pkt.size == pkt->size) {
             out_pkt.destruct = pkt->destruct;
@@ -1212,10 +1332,8 @@ static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
             *pkt = cur_pkt;
             compute_pkt_fields(s, st, NULL, pkt);
             if ((s->iformat->flags & AVFMT_GENERIC_INDEX) &&
-                (pkt->flags & AV_PKT_FLAG_KEY) && pkt->dts != AV_NOPTS_VALUE) {
-                ff_reduce_index(s, st->index);
-                av_add_index_entry(st, pkt->pos, pkt->dts, 0, 0, AVINDEX_KEYFRAME);
-            }
+                (pkt->flags & AV_PKT_FLAG_KEY) && pkt->dts != AV_NOPTS_VALUE)
+                add_generic_index_entry(s, st, pkt->pos, pkt->dts);
             got_packet = 1;
         } else if (st->discard < AVDISCARD_ALL) {
             if ((ret = parse_packet(s, &cur_pkt, cur_pkt.stream_index)) < 0)
@@ -1374,8 +1492,11 @@ void ff_reduce_index(AVFormatContext *s, int stream_index)
     AVStream *st= s->streams[stream_index];
     unsigned int max_entries= s->max_index_size / sizeof(AVIndexEntry);
 
-    if((unsigned)st->nb_index_entries >= max_entries){
+    if((unsigned)st->nb_index_entries + st->nb_pending_index_entries >= max_entries){
         int i;
+        flush_index_entries(st);
+        if ((unsigned)st->nb_index_entries < max_entries)
+            return;
         for(i=0; 2*i<st->nb_index_entries; i++)
             st->index_entries[i]= st->index_entries[2*i];
         st->nb_index_entries= i;
@@ -1431,6 +1552,7 @@ int ff_add_index_entry(AVIndexEntry **index_entries,
 int av_add_index_entry(AVStream *st,
                        int64_t pos, int64_t timestamp, int size, int distance, int flags)
 {
+    flush_index_entries(st);
     return ff_add_index_entry(&st->index_entries, &st->nb_index_entries,
                               &st->index_entries_allocated_size, pos,
                               timestamp, size, distance, flags);
@@ -1473,6 +1595,7 @@ int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
 int av_index_search_timestamp(AVStream *st, int64_t wanted_timestamp,
                               int flags)
 {
+    flush_index_entries(st);
     return ff_index_search_timestamp(st->index_entries, st->nb_index_entries,
                                      wanted_timestamp, flags);
 }
@@ -2668,6 +2791,7 @@ void avformat_free_context(AVFormatContext *s)
             av_free_packet(&st->attached_pic);
         av_dict_free(&st->metadata);
         av_free(st->index_entries);
+        av_free(st->pending_index_entries);
         av_free(st->codec->extradata);
         av_free(st->codec->subtitle_header);
         av_free(st->codec);
@@ -4015,3 +4139,10 @@ const struct AVCodecTag *avformat_get_riff_audio_tags(void)
 {
     return ff_codec_wav_tags;
 }
+
+#if !CONFIG_MPEGTS_DEMUXER
+const AVMpegTSPIDStats *av_mpegts_get_pid_stats(AVFormatContext *s)
+{
+    return NULL;
+}
+#endif
@@ -253,6 +253,24 @@ int avresample_convert(AVAudioResampleContext *avr, void **output,
  */
 int avresample_get_delay(AVAudioResampleContext *avr);
 
+/**
+ * Return the number of output samples available after converting
+ * in_nb_samples more input samples.
+ *
+ * This includes the samples already in the output FIFO and takes the current
+ * state of the resampler into account, so an output buffer of this size is
+ * large enough for the next avresample_convert() call to not store any
+ * samples in the output FIFO.
+ *
+ * @see avresample_convert()
+ *
+ * @param avr            audio resample context
+ * @param in_nb_samples  number of input samples for the next conversion
+ * @return               number of output samples or AVERROR(EINVAL) if it
+ *                       does not fit in an int
+ */
+int avresample_get_out_samples(AVAudioResampleContext *avr, int in_nb_samples);
+
 /**
  * Return the number of available samples in the output FIFO.
  *
@@ -19,11 +19,13 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
 #include "libavutil/common.h"
 #include "libavutil/libm.h"
 #include "libavutil/log.h"
 #include "internal.h"
 #include "audio_data.h"
+#include "resample.h"
 
 struct ResampleContext {
     AVAudioResampleContext *avr;
@@ -46,6 +48,8 @@ struct ResampleContext {
     void (*resample_one)(struct ResampleContext *c, int no_filter, void *dst0,
                          int dst_index, const void *src0, int src_size,
                          int index, int frac);
+    resample_dot_func *filter_dot;
+    int dot_len;
 };
 
 
@@ -68,6 +72,21 @@ struct ResampleContext {
 #include "resample_template.c"
 
 
+void ff_audio_resample_set_dot_func(ResampleContext *c, enum AVSampleFormat fmt,
+                                    int len_align, const char *descr,
+                                    resample_dot_func *dot_func)
+{
+    int len = c->filter_length / len_align * len_align;
+
+    if (fmt == c->avr->internal_sample_fmt && len) {
+        c->filter_dot = dot_func;
+        c->dot_len    = len;
+        av_log(c->avr, AV_LOG_DEBUG, "resample: found function: [fmt=%s] "
+               "%s, %d of %d taps\n", av_get_sample_fmt_name(fmt), descr,
+               len, c->filter_length);
+    }
+}
+
 /* 0th order modified bessel function of the first kind. */
 static double bessel(double x)
 {
@@ -192,6 +211,9 @@ ResampleContext *ff_audio_resample_init(AVAudioResampleContext *avr)
         break;
     }
 
+    if (ARCH_X86)
+        ff_audio_resample_init_x86(c);
+
     felem_size = av_get_bytes_per_sample(avr->internal_sample_fmt);
     c->filter_bank = av_mallocz(c->filter_length * (phase_count + 1) * felem_size);
     if (!c->filter_bank)
@@ -317,6 +339,46 @@ reinit_fail:
     return ret;
 }
 
+/* number of n >= 0 for which index + (frac + n * incr) / src_incr < limit */
+static int64_t count_steps(int64_t limit, int64_t index, int64_t frac,
+                           int64_t incr, int64_t src_incr)
+{
+    int64_t q = limit - index, r;
+
+    if (q <= 0)
+        return 0;
+    if (incr <= 0)
+        return INT64_MAX;
+    /* ceil((q * src_incr - frac) / incr), without overflowing */
+    r = q % incr * src_incr - frac;
+    return q / incr * src_incr + (r > 0 ? (r + incr - 1) / incr : -(-r / incr));
+}
+
+/* number of samples resample() outputs for src_size input samples */
+static int resample_out_samples(ResampleContext *c, int src_size)
+{
+    int64_t limit, n, distance = c->compensation_distance;
+    int64_t index = c->index;
+    int64_t frac  = c->frac;
+
+    if (!distance && c->filter_length == 1 && c->phase_shift == 0)
+        return av_clip((src_size - 1 - index) * c->src_incr / c->dst_incr,
+                       0, INT_MAX);
+
+    if ((index >> c->phase_shift) <= -src_size)
+        return 0;
+    limit = (int64_t)(src_size - c->filter_length + 1) << c->phase_shift;
+    n     = count_steps(limit, index, frac, c->dst_incr, c->src_incr);
+    if (distance && n > distance) {
+        /* continue from the end of the compensation with the ideal rate */
+        index += (frac + distance * c->dst_incr) / c->src_incr;
+        frac   = (frac + distance * c->dst_incr) % c->src_incr;
+        n      = distance + count_steps(limit, index, frac, c->ideal_dst_incr,
+                                        c->src_incr);
+    }
+    return FFMIN(n, INT_MAX);
+}
+
 static int resample(ResampleContext *c, void *dst, const void *src,
                     int *consumed, int src_size, int dst_size, int update_ctx)
 {
@@ -327,9 +389,6 @@ static int resample(ResampleContext *c, void *dst, const void *src,
     int dst_incr      = c->dst_incr / c->src_incr;
     int compensation_distance = c->compensation_distance;
 
-    if (!dst != !src)
-        return AVERROR(EINVAL);
-
     if (compensation_distance == 0 && c->filter_length == 1 &&
         c->phase_shift == 0) {
         int64_t index2 = ((int64_t)index) << 32;
@@ -338,13 +397,9 @@ static int resample(ResampleContext *c, void *dst, const void *src,
                                (src_size-1-index) * (int64_t)c->src_incr /
                                c->dst_incr);
 
-        if (dst) {
-            for(dst_index = 0; dst_index < dst_size; dst_index++) {
-                c->resample_one(c, 1, dst, dst_index, src, 0, index2 >> 32, 0);
-                index2 += incr;
-            }
-        } else {
-            dst_index = dst_size;
+        for(dst_index = 0; dst_index < dst_size; dst_index++) {
+            c->resample_one(c, 1, dst, dst_index, src, 0, index2 >> 32, 0);
+            index2 += incr;
         }
         index += dst_index * dst_incr;
         index += (frac + dst_index * (int64_t)dst_incr_frac) / c->src_incr;
@@ -357,8 +412,7 @@ static int resample(ResampleContext *c, void *dst, const void *src,
                 -sample_index >= src_size)
                 break;
 
-            if (dst)
-                c->resample_one(c, 0, dst, dst_index, src, src_size, index, frac);
+            c->resample_one(c, 0, dst, dst_index, src, src_size, index, frac);
 
             frac  += dst_incr_frac;
             index += dst_incr;
@@ -416,10 +470,8 @@ int ff_audio_resample(ResampleContext *c, AudioData *dst, AudioData *src,
     }
 
     /* calculate output size and reallocate output buffer if needed */
-    /* TODO: try to calculate this without the dummy resample() run */
     if (!dst->read_only && dst->allow_realloc) {
-        out_samples = resample(c, NULL, NULL, NULL, c->buffer->nb_samples,
-                               INT_MAX, 0);
+        out_samples = resample_out_samples(c, c->buffer->nb_samples);
         ret = ff_audio_data_realloc(dst, out_samples);
         if (ret < 0) {
             av_log(c->avr, AV_LOG_ERROR, "error reallocating output\n");
@@ -456,3 +508,23 @@ int avresample_get_delay(AVAudioResampleContext *avr)
 
     return avr->resample->buffer->nb_samples;
 }
+
+int avresample_get_out_samples(AVAudioResampleContext *avr, int in_nb_samples)
+{
+    int64_t samples = avresample_available(avr);
+    int delay;
+
+    if (in_nb_samples < 0)
+        return AVERROR(EINVAL);
+    if (!avr->resample_needed || !avr->resample) {
+        samples += in_nb_samples;
+    } else {
+        delay = avr->resample->buffer->nb_samples;
+        if (in_nb_samples > INT_MAX - delay)
+            return AVERROR(EINVAL);
+        samples += resample_out_samples(avr->resample, delay + in_nb_samples);
+    }
+    if (samples > INT_MAX)
+        return AVERROR(EINVAL);
+    return samples;
+}
@@ -26,6 +26,16 @@
 
 typedef struct ResampleContext ResampleContext;
 
+/**
+ * Compute the inner product of len source samples and filter taps.
+ *
+ * The samples and taps are in the internal sample format. The result is
+ * stored in val with the accumulator type of that format: int32_t for s16p,
+ * int64_t for s32p, float for fltp and double for dblp.
+ */
+typedef void (resample_dot_func)(void *val, const void *src,
+                                 const void *filter, int len);
+
 /**
  * Allocate and initialize a ResampleContext.
  *
@@ -37,6 +47,22 @@ typedef struct ResampleContext ResampleContext;
  */
 ResampleContext *ff_audio_resample_init(AVAudioResampleContext *avr);
 
+/**
+ * Set the filter inner product function if the sample format matches.
+ *
+ * The function is used for the largest multiple of len_align filter taps,
+ * the remaining taps are added in C.
+ *
+ * @param c          ResampleContext
+ * @param fmt        internal sample format
+ * @param len_align  number of taps the function handles at a time
+ * @param descr      function type description (e.g. "SSE2")
+ * @param dot_func   inner product function pointer
+ */
+void ff_audio_resample_set_dot_func(ResampleContext *c, enum AVSampleFormat fmt,
+                                    int len_align, const char *descr,
+                                    resample_dot_func *dot_func);
+
 /**
  * Free a ResampleContext.
  *
@@ -67,4 +93,8 @@ void ff_audio_resample_free(ResampleContext **c);
 int ff_audio_resample(ResampleContext *c, AudioData *dst, AudioData *src,
                       int *consumed);
 
+/* arch-specific initialization functions */
+
+void ff_audio_resample_init_x86(ResampleContext *c);
+
 #endif /* AVRESAMPLE_RESAMPLE_H */
@@ -68,16 +68,28 @@ static void SET_TYPE(resample_one)(ResampleContext *c, int no_filter,
             for (i = 0; i < c->filter_length; i++)
                 val += src[FFABS(sample_index + i) % src_size] *
                        (FELEM2)filter[i];
-        } else if (c->linear) {
-            FELEM2 v2 = 0;
-            for (i = 0; i < c->filter_length; i++) {
-                val += src[abs(sample_index + i)] * (FELEM2)filter[i];
-                v2  += src[abs(sample_index + i)] * (FELEM2)filter[i + c->filter_length];
-            }
-            val += (v2 - val) * (FELEML)frac / c->src_incr;
         } else {
-            for (i = 0; i < c->filter_length; i++)
-                val += src[sample_index + i] * (FELEM2)filter[i];
+            src += sample_index;
+            i    = 0;
+            if (c->filter_dot) {
+                c->filter_dot(&val, src, filter, c->dot_len);
+                i = c->dot_len;
+            }
+            for (; i < c->filter_length; i++)
+                val += src[i] * (FELEM2)filter[i];
+
+            if (c->linear) {
+                FELEM2 v2 = 0;
+                filter += c->filter_length;
+                i       = 0;
+                if (c->filter_dot) {
+                    c->filter_dot(&v2, src, filter, c->dot_len);
+                    i = c->dot_len;
+                }
+                for (; i < c->filter_length; i++)
+                    v2 += src[i] * (FELEM2)filter[i];
+                val += (v2 - val) * (FELEML)frac / c->src_incr;
+            }
         }
 
         OUT(dst[dst_index], val);
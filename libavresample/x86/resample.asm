@@ -0,0 +1,177 @@
+;******************************************************************************
+;* x86 optimized resampling
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "x86inc.asm"
+%include "x86util.asm"
+
+SECTION_TEXT
+
+;-----------------------------------------------------------------------------
+; void ff_resample_dot_s16(int32_t *val, const int16_t *src,
+;                          const int16_t *filter, int len);
+;
+; len must be a multiple of 4. The products are summed with wraparound in
+; 32 bits, like the C version.
+;-----------------------------------------------------------------------------
+
+INIT_XMM sse2
+cglobal resample_dot_s16, 4,4,3, val, src, filter, len
+    movsxdifnidn lenq, lend
+    pxor          m0, m0
+    add         lenq, lenq
+    test        lend, 8
+    jz .main
+    movq          m0, [srcq]
+    movq          m1, [filterq]
+    pmaddwd       m0, m1
+    add         srcq, 8
+    add      filterq, 8
+    sub         lenq, 8
+.main:
+    add         srcq, lenq
+    add      filterq, lenq
+    neg         lenq
+    jz .end
+.loop:
+    movu          m1, [srcq+lenq]
+    movu          m2, [filterq+lenq]
+    pmaddwd       m1, m2
+    paddd         m0, m1
+    add         lenq, mmsize
+    jl .loop
+.end:
+    movhlps       m1, m0
+    paddd         m0, m1
+    pshuflw       m1, m0, 0x4e
+    paddd         m0, m1
+    movd      [valq], m0
+    RET
+
+;-----------------------------------------------------------------------------
+; void ff_resample_dot_s32(int64_t *val, const int32_t *src,
+;                          const int32_t *filter, int len);
+;
+; len must be a multiple of 4.
+;-----------------------------------------------------------------------------
+
+INIT_XMM sse4
+cglobal resample_dot_s32, 4,4,5, val, src, filter, len
+    movsxdifnidn lenq, lend
+    pxor          m0, m0
+    shl         lenq, 2
+    add         srcq, lenq
+    add      filterq, lenq
+    neg         lenq
+.loop:
+    movu          m1, [srcq+lenq]
+    movu          m2, [filterq+lenq]
+    pshufd        m3, m1, 0xf5
+    pshufd        m4, m2, 0xf5
+    pmuldq        m1, m2
+    pmuldq        m3, m4
+    paddq         m0, m1
+    paddq         m0, m3
+    add         lenq, mmsize
+    jl .loop
+    movhlps       m1, m0
+    paddq         m0, m1
+    movq      [valq], m0
+    RET
+
+;-----------------------------------------------------------------------------
+; void ff_resample_dot_flt(float *val, const float *src, const float *filter,
+;                          int len);
+;
+; len must be a multiple of mmsize / 4.
+;-----------------------------------------------------------------------------
+
+%macro RESAMPLE_DOT_FLT 0
+cglobal resample_dot_flt, 4,4,3, val, src, filter, len
+    movsxdifnidn lenq, lend
+    xorps         m0, m0
+    shl         lenq, 2
+    add         srcq, lenq
+    add      filterq, lenq
+    neg         lenq
+.loop:
+    movu          m1, [srcq+lenq]
+    movu          m2, [filterq+lenq]
+    mulps         m1, m2
+    addps         m0, m1
+    add         lenq, mmsize
+    jl .loop
+%if mmsize == 32
+    vextractf128 xmm1, m0, 1
+    addps       xmm0, xmm1
+%endif
+    movhlps     xmm1, xmm0
+    addps       xmm0, xmm1
+    movss       xmm1, xmm0
+    shufps      xmm0, xmm0, 1
+    addss       xmm0, xmm1
+    movss     [valq], xmm0
+    RET
+%endmacro
+
+INIT_XMM sse
+RESAMPLE_DOT_FLT
+%if HAVE_AVX
+INIT_YMM avx
+RESAMPLE_DOT_FLT
+%endif
+
+;-----------------------------------------------------------------------------
+; void ff_resample_dot_dbl(double *val, const double *src,
+;                          const double *filter, int len);
+;
+; len must be a multiple of mmsize / 8.
+;-----------------------------------------------------------------------------
+
+%macro RESAMPLE_DOT_DBL 0
+cglobal resample_dot_dbl, 4,4,3, val, src, filter, len
+    movsxdifnidn lenq, lend
+    xorpd         m0, m0
+    shl         lenq, 3
+    add         srcq, lenq
+    add      filterq, lenq
+    neg         lenq
+.loop:
+    movu          m1, [srcq+lenq]
+    movu          m2, [filterq+lenq]
+    mulpd         m1, m2
+    addpd         m0, m1
+    add         lenq, mmsize
+    jl .loop
+%if mmsize == 32
+    vextractf128 xmm1, m0, 1
+    addpd       xmm0, xmm1
+%endif
+    movhlps     xmm1, xmm0
+    addsd       xmm0, xmm1
+    movsd     [valq], xmm0
+    RET
+%endmacro
+
+INIT_XMM sse2
+RESAMPLE_DOT_DBL
+%if HAVE_AVX
+INIT_YMM avx
+RESAMPLE_DOT_DBL
+%endif
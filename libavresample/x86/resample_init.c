@@ -0,0 +1,62 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/cpu.h"
+#include "libavresample/resample.h"
+
+extern void ff_resample_dot_s16_sse2(void *val, const void *src,
+                                     const void *filter, int len);
+extern void ff_resample_dot_s32_sse4(void *val, const void *src,
+                                     const void *filter, int len);
+extern void ff_resample_dot_flt_sse (void *val, const void *src,
+                                     const void *filter, int len);
+extern void ff_resample_dot_flt_avx (void *val, const void *src,
+                                     const void *filter, int len);
+extern void ff_resample_dot_dbl_sse2(void *val, const void *src,
+                                     const void *filter, int len);
+extern void ff_resample_dot_dbl_avx (void *val, const void *src,
+                                     const void *filter, int len);
+
+av_cold void ff_audio_resample_init_x86(ResampleContext *c)
+{
+#if HAVE_YASM
+    int mm_flags = av_get_cpu_flags();
+
+    if (mm_flags & AV_CPU_FLAG_SSE && HAVE_SSE) {
+        ff_audio_resample_set_dot_func(c, AV_SAMPLE_FMT_FLTP, 4, "SSE",
+                                       ff_resample_dot_flt_sse);
+    }
+    if (mm_flags & AV_CPU_FLAG_SSE2 && HAVE_SSE) {
+        ff_audio_resample_set_dot_func(c, AV_SAMPLE_FMT_S16P, 4, "SSE2",
+                                       ff_resample_dot_s16_sse2);
+        ff_audio_resample_set_dot_func(c, AV_SAMPLE_FMT_DBLP, 2, "SSE2",
+                                       ff_resample_dot_dbl_sse2);
+    }
+    if (mm_flags & AV_CPU_FLAG_SSE4 && HAVE_SSE) {
+        ff_audio_resample_set_dot_func(c, AV_SAMPLE_FMT_S32P, 4, "SSE4",
+                                       ff_resample_dot_s32_sse4);
+    }
+    if (mm_flags & AV_CPU_FLAG_AVX && HAVE_AVX) {
+        ff_audio_resample_set_dot_func(c, AV_SAMPLE_FMT_FLTP, 8, "AVX",
+                                       ff_resample_dot_flt_avx);
+        ff_audio_resample_set_dot_func(c, AV_SAMPLE_FMT_DBLP, 4, "AVX",
+                                       ff_resample_dot_dbl_avx);
+    }
+#endif
+}
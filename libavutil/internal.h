@@ -47,6 +47,12 @@
 #endif
 #endif
 
+/**
+ * Upper bound for automatically selected thread counts. It only guards
+ * against absurd numbers of CPUs reported by the system.
+ */
+#define FF_MAX_AUTO_THREADS 256
+
 #ifndef INT_BIT
 #    define INT_BIT (CHAR_BIT * sizeof(int))
 #endif
@@ -277,6 +277,7 @@ typedef struct AVOption {
 #define AV_OPT_FLAG_AUDIO_PARAM     8
 #define AV_OPT_FLAG_VIDEO_PARAM     16
 #define AV_OPT_FLAG_SUBTITLE_PARAM  32
+#define AV_OPT_FLAG_READONLY        64  ///< the option can only be read, e.g. a statistic exported by the object
 //FIXME think about enc-audio, ... style flags
 
     /**
@@ -0,0 +1,156 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Slice threading for sws_scale()
+ */
+
+#include <pthread.h>
+
+#include "libavutil/mem.h"
+#include "swscale_internal.h"
+
+typedef struct SliceWorker {
+    struct SwsThreadContext *t;
+    pthread_t thread;
+    int jobnr;                      ///< index of the slice context run by this worker
+} SliceWorker;
+
+typedef struct SwsThreadContext {
+    SwsContext *c;
+    SliceWorker *workers;           ///< worker 0 is the thread calling sws_scale()
+    int nb_workers;
+
+    void (*func)(SwsContext *c, void *arg, int jobnr);
+    void *arg;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  work_cond;      ///< signalled when new jobs are started
+    pthread_cond_t  done_cond;      ///< signalled when the last job finishes
+    int generation;                 ///< incremented for each ff_sws_execute() call
+    int jobs_left;
+    int done;
+} SwsThreadContext;
+
+static void *worker(void *arg)
+{
+    SliceWorker *w = arg;
+    SwsThreadContext *t = w->t;
+    int generation = 0;
+
+    pthread_mutex_lock(&t->lock);
+    for (;;) {
+        while (t->generation == generation && !t->done)
+            pthread_cond_wait(&t->work_cond, &t->lock);
+        if (t->done)
+            break;
+        generation = t->generation;
+        pthread_mutex_unlock(&t->lock);
+
+        t->func(t->c->slice_ctx[w->jobnr], t->arg, w->jobnr);
+
+        pthread_mutex_lock(&t->lock);
+        if (!--t->jobs_left)
+            pthread_cond_signal(&t->done_cond);
+    }
+    pthread_mutex_unlock(&t->lock);
+
+    return NULL;
+}
+
+void ff_sws_execute(SwsContext *c,
+                    void (*func)(SwsContext *c, void *arg, int jobnr),
+                    void *arg)
+{
+    SwsThreadContext *t = c->thread;
+
+    pthread_mutex_lock(&t->lock);
+    t->func      = func;
+    t->arg       = arg;
+    t->jobs_left = t->nb_workers - 1;
+    t->generation++;
+    pthread_cond_broadcast(&t->work_cond);
+    pthread_mutex_unlock(&t->lock);
+
+    func(c->slice_ctx[0], arg, 0);
+
+    pthread_mutex_lock(&t->lock);
+    while (t->jobs_left)
+        pthread_cond_wait(&t->done_cond, &t->lock);
+    pthread_mutex_unlock(&t->lock);
+}
+
+void ff_sws_free_threads(SwsContext *c)
+{
+    SwsThreadContext *t = c->thread;
+    int i;
+
+    if (!t)
+        return;
+
+    pthread_mutex_lock(&t->lock);
+    t->done = 1;
+    pthread_cond_broadcast(&t->work_cond);
+    pthread_mutex_unlock(&t->lock);
+
+    for (i = 1; i < t->nb_workers; i++)
+        pthread_join(t->workers[i].thread, NULL);
+
+    pthread_mutex_destroy(&t->lock);
+    pthread_cond_destroy(&t->work_cond);
+    pthread_cond_destroy(&t->done_cond);
+    av_free(t->workers);
+    av_freep(&c->thread);
+}
+
+int ff_sws_init_threads(SwsContext *c)
+{
+    SwsThreadContext *t;
+    int i;
+
+    t = av_mallocz(sizeof(*t));
+    if (!t)
+        return AVERROR(ENOMEM);
+    t->workers = av_mallocz(sizeof(*t->workers) * c->nb_slice_ctx);
+    if (!t->workers) {
+        av_free(t);
+        return AVERROR(ENOMEM);
+    }
+
+    t->c = c;
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->work_cond, NULL);
+    pthread_cond_init(&t->done_cond, NULL);
+    c->thread = t;
+
+    t->nb_workers = 1;
+    for (i = 1; i < c->nb_slice_ctx; i++) {
+        SliceWorker *w = &t->workers[i];
+
+        w->t     = t;
+        w->jobnr = i;
+        if (pthread_create(&w->thread, NULL, worker, w)) {
+            ff_sws_free_threads(c);
+            return AVERROR(ENOMEM);
+        }
+        t->nb_workers++;
+    }
+
+    return 0;
+}
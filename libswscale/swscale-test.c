@@ -31,6 +31,9 @@
 #include "libavutil/crc.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/lfg.h"
+#include "libavutil/opt.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/time.h"
 #include "swscale.h"
 
 /* HACK Duplicated from swscale_internal.h.
@@ -66,6 +69,42 @@ static uint64_t getSSD(uint8_t *src1, uint8_t *src2, int stride1,
     return ssd;
 }
 
+/* Get a context for the conversion under test, using slice threading
+ * if threads is set. */
+static struct SwsContext *get_context(int srcW, int srcH,
+                                      enum PixelFormat srcFormat,
+                                      int dstW, int dstH,
+                                      enum PixelFormat dstFormat,
+                                      int flags, int threads)
+{
+    const int *coeffs = sws_getCoefficients(SWS_CS_DEFAULT);
+    struct SwsContext *c;
+
+    if (!threads)
+        return sws_getContext(srcW, srcH, srcFormat, dstW, dstH, dstFormat,
+                              flags, NULL, NULL, NULL);
+
+    if (!(c = sws_alloc_context()))
+        return NULL;
+
+    av_opt_set_int(c, "srcw",       srcW,      0);
+    av_opt_set_int(c, "srch",       srcH,      0);
+    av_opt_set_int(c, "src_format", srcFormat, 0);
+    av_opt_set_int(c, "dstw",       dstW,      0);
+    av_opt_set_int(c, "dsth",       dstH,      0);
+    av_opt_set_int(c, "dst_format", dstFormat, 0);
+    av_opt_set_int(c, "sws_flags",  flags,     0);
+    av_opt_set_int(c, "threads",    threads,   0);
+    sws_setColorspaceDetails(c, coeffs, 0, coeffs, 0, 0, 1 << 16, 1 << 16);
+
+    if (sws_init_context(c, NULL, NULL) < 0) {
+        sws_freeContext(c);
+        return NULL;
+    }
+
+    return c;
+}
+
 struct Results {
     uint64_t ssdY;
     uint64_t ssdU;
@@ -79,7 +118,7 @@ struct Results {
 static int doTest(uint8_t *ref[4], int refStride[4], int w, int h,
                   enum PixelFormat srcFormat, enum PixelFormat dstFormat,
                   int srcW, int srcH, int dstW, int dstH, int flags,
-                  struct Results *r)
+                  int threads, struct Results *r)
 {
     static enum PixelFormat cur_srcFormat;
     static int cur_srcW, cur_srcH;
@@ -146,8 +185,8 @@ static int doTest(uint8_t *ref[4], int refStride[4], int w, int h,
         }
     }
 
-    dstContext = sws_getContext(srcW, srcH, srcFormat, dstW, dstH, dstFormat,
-                                flags, NULL, NULL, NULL);
+    dstContext = get_context(srcW, srcH, srcFormat, dstW, dstH, dstFormat,
+                             flags, threads);
     if (!dstContext) {
         fprintf(stderr, "Failed to get %s ---> %s\n",
                 av_pix_fmt_descriptors[srcFormat].name,
@@ -233,7 +272,7 @@ end:
 
 static void selfTest(uint8_t *ref[4], int refStride[4], int w, int h,
                      enum PixelFormat srcFormat_in,
-                     enum PixelFormat dstFormat_in)
+                     enum PixelFormat dstFormat_in, int threads)
 {
     const int flags[] = { SWS_FAST_BILINEAR, SWS_BILINEAR, SWS_BICUBIC,
                           SWS_X, SWS_POINT, SWS_AREA, 0 };
@@ -269,7 +308,7 @@ static void selfTest(uint8_t *ref[4], int refStride[4], int w, int h,
                         res = doTest(ref, refStride, w, h,
                                      srcFormat, dstFormat,
                                      srcW, srcH, dstW[i], dstH[j], flags[k],
-                                     NULL);
+                                     threads, NULL);
             if (dstFormat_in != PIX_FMT_NONE)
                 break;
         }
@@ -280,7 +319,7 @@ static void selfTest(uint8_t *ref[4], int refStride[4], int w, int h,
 
 static int fileTest(uint8_t *ref[4], int refStride[4], int w, int h, FILE *fp,
                     enum PixelFormat srcFormat_in,
-                    enum PixelFormat dstFormat_in)
+                    enum PixelFormat dstFormat_in, int threads)
 {
     char buf[256];
 
@@ -323,9 +362,62 @@ static int fileTest(uint8_t *ref[4], int refStride[4], int w, int h, FILE *fp,
         doTest(ref, refStride, w, h,
                srcFormat, dstFormat,
                srcW, srcH, dstW, dstH, flags,
-               &r);
+               threads, &r);
+    }
+
+    return 0;
+}
+
+// time the conversion of a random picture
+static int bench(enum PixelFormat srcFormat, enum PixelFormat dstFormat,
+                 int srcW, int srcH, int dstW, int dstH, int flags, int threads)
+{
+    uint8_t *src[4] = { 0 }, *dst[4] = { 0 };
+    int srcStride[4], dstStride[4];
+    struct SwsContext *c;
+    AVLFG rand;
+    int64_t start, elapsed;
+    int i, size, frames = 0;
+
+    size = av_image_alloc(src, srcStride, srcW, srcH, srcFormat, 16);
+    if (size < 0 || av_image_alloc(dst, dstStride, dstW, dstH, dstFormat, 16) < 0) {
+        perror("Malloc");
+        av_freep(&src[0]);
+        return -1;
+    }
+    av_lfg_init(&rand, 1);
+    for (i = 0; i < size; i++)
+        src[0][i] = av_lfg_get(&rand);
+
+    c = get_context(srcW, srcH, srcFormat, dstW, dstH, dstFormat, flags,
+                    threads);
+    if (!c) {
+        fprintf(stderr, "Failed to get %s ---> %s\n",
+                av_pix_fmt_descriptors[srcFormat].name,
+                av_pix_fmt_descriptors[dstFormat].name);
+        av_freep(&src[0]);
+        av_freep(&dst[0]);
+        return -1;
     }
 
+    sws_scale(c, (const uint8_t * const *)src, srcStride, 0, srcH, dst, dstStride);
+    start = av_gettime();
+    do {
+        sws_scale(c, (const uint8_t * const *)src, srcStride, 0, srcH,
+                  dst, dstStride);
+        frames++;
+        elapsed = av_gettime() - start;
+    } while (elapsed < 2000000 || frames < 10);
+
+    printf("%s %dx%d -> %s %dx%d flags=%d threads=%d: %d frames, %.3f ms/frame\n",
+           av_pix_fmt_descriptors[srcFormat].name, srcW, srcH,
+           av_pix_fmt_descriptors[dstFormat].name, dstW, dstH,
+           flags, threads, frames, elapsed / 1000.0 / frames);
+
+    sws_freeContext(c);
+    av_freep(&src[0]);
+    av_freep(&dst[0]);
+
     return 0;
 }
 
@@ -347,6 +439,8 @@ int main(int argc, char **argv)
     AVLFG rand;
     int res = -1;
     int i;
+    int threads = 0;
+    int bench_w = 0, bench_h = 0, bench_dst_w = 0, bench_dst_h = 0;
 
     if (!rgb_data || !data)
         return -1;
@@ -372,7 +466,8 @@ int main(int argc, char **argv)
                 fprintf(stderr, "could not open '%s'\n", argv[i + 1]);
                 goto error;
             }
-            res = fileTest(src, stride, W, H, fp, srcFormat, dstFormat);
+            res = fileTest(src, stride, W, H, fp, srcFormat, dstFormat,
+                           threads);
             fclose(fp);
             goto end;
         } else if (!strcmp(argv[i], "-src")) {
@@ -381,6 +476,18 @@ int main(int argc, char **argv)
                 fprintf(stderr, "invalid pixel format %s\n", argv[i + 1]);
                 return -1;
             }
+        } else if (!strcmp(argv[i], "-threads")) {
+            threads = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "-bench")) {
+            if (av_parse_video_size(&bench_w, &bench_h, argv[i + 1]) < 0) {
+                fprintf(stderr, "invalid size %s\n", argv[i + 1]);
+                return -1;
+            }
+        } else if (!strcmp(argv[i], "-bench_dst")) {
+            if (av_parse_video_size(&bench_dst_w, &bench_dst_h, argv[i + 1]) < 0) {
+                fprintf(stderr, "invalid size %s\n", argv[i + 1]);
+                return -1;
+            }
         } else if (!strcmp(argv[i], "-dst")) {
             dstFormat = av_get_pix_fmt(argv[i + 1]);
             if (dstFormat == PIX_FMT_NONE) {
@@ -394,7 +501,17 @@ bad_option:
         }
     }
 
-    selfTest(src, stride, W, H, srcFormat, dstFormat);
+    if (bench_w) {
+        res = bench(srcFormat != PIX_FMT_NONE ? srcFormat : PIX_FMT_YUV420P,
+                    dstFormat != PIX_FMT_NONE ? dstFormat : PIX_FMT_RGB24,
+                    bench_w, bench_h,
+                    bench_dst_w ? bench_dst_w : bench_w,
+                    bench_dst_h ? bench_dst_h : bench_h,
+                    SWS_BICUBIC, threads);
+        goto error;
+    }
+
+    selfTest(src, stride, W, H, srcFormat, dstFormat, threads);
 end:
     res = 0;
 error:
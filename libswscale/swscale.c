@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "libavutil/atomic.h"
 #include "libavutil/avutil.h"
 #include "libavutil/bswap.h"
 #include "libavutil/cpu.h"
@@ -322,6 +323,7 @@ static int swScale(SwsContext *c, const uint8_t *src[],
     const int srcW                   = c->srcW;
     const int dstW                   = c->dstW;
     const int dstH                   = c->dstH;
+    const int dstSliceEnd            = c->dstSliceY + c->dstSliceH;
     const int chrDstW                = c->chrDstW;
     const int chrSrcW                = c->chrSrcW;
     const int lumXInc                = c->lumXInc;
@@ -409,7 +411,7 @@ static int swScale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = c->dstSliceY;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -419,7 +421,7 @@ static int swScale(SwsContext *c, const uint8_t *src[],
     }
     lastDstY = dstY;
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstSliceEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         uint8_t *dest[4]  = {
             dst[0] + dstStride[0] * dstY,
@@ -738,3 +740,62 @@ SwsFunc ff_getSwsFunc(SwsContext *c)
 
     return swScale;
 }
+
+#if HAVE_PTHREADS
+typedef struct SliceArgs {
+    const uint8_t **src;
+    const int *srcStride;
+    uint8_t **dst;
+    const int *dstStride;
+    volatile int lines;             ///< destination lines output so far
+} SliceArgs;
+
+static void scale_slice(SwsContext *c, void *arg, int jobnr)
+{
+    SliceArgs *a = arg;
+    const uint8_t *src[4] = { a->src[0], a->src[1], a->src[2], a->src[3] };
+    uint8_t *dst[4]       = { a->dst[0], a->dst[1], a->dst[2], a->dst[3] };
+    int srcStride[4], dstStride[4];
+    int i, lines;
+
+    for (i = 0; i < 4; i++) {
+        srcStride[i] = a->srcStride[i];
+        dstStride[i] = a->dstStride[i];
+    }
+
+    if (c->swScale == swScale) {
+        /* the whole source is passed, only the lines needed by the
+         * vertical filters of the band are scaled horizontally */
+        lines = swScale(c, src, srcStride, 0, c->srcH, dst, dstStride);
+    } else {
+        /* unscaled converters get the source lines of their band */
+        for (i = 0; i < 4; i++) {
+            int shift = (i == 1 || i == 2) ? c->chrSrcVSubSample : 0;
+            if (src[i] && !(i == 1 && usePal(c->srcFormat)))
+                src[i] += (c->dstSliceY >> shift) * srcStride[i];
+        }
+        lines = c->swScale(c, src, srcStride, c->dstSliceY, c->dstSliceH,
+                           dst, dstStride);
+    }
+
+    avpriv_atomic_int_add_and_fetch(&a->lines, lines);
+}
+
+int ff_sws_scale_slices(SwsContext *c, const uint8_t *src[], int srcStride[],
+                        uint8_t *dst[], int dstStride[])
+{
+    SliceArgs args = { src, srcStride, dst, dstStride, 0 };
+    int i;
+
+    if (usePal(c->srcFormat)) {
+        for (i = 0; i < c->nb_slice_ctx; i++) {
+            memcpy(c->slice_ctx[i]->pal_yuv, c->pal_yuv, sizeof(c->pal_yuv));
+            memcpy(c->slice_ctx[i]->pal_rgb, c->pal_rgb, sizeof(c->pal_rgb));
+        }
+    }
+
+    ff_sws_execute(c, scale_slice, &args);
+
+    return args.lines;
+}
+#endif /* HAVE_PTHREADS */
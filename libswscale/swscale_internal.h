@@ -521,6 +521,21 @@ typedef struct SwsContext {
     void (*chrConvertRange)(int16_t *dst1, int16_t *dst2, int width);
 
     int needs_hcscale; ///< Set if there are chroma planes to be converted.
+
+    int dstSliceY;                ///< First destination line output by swScale().
+    int dstSliceH;                ///< Number of destination lines output by swScale().
+
+    /**
+     * @name Slice threading.
+     * Whole frames may be scaled by several threads, each of them producing
+     * a band of destination lines with its own context.
+     */
+    //@{
+    int nb_threads;               ///< Number of threads requested by the user.
+    struct SwsContext **slice_ctx; ///< Contexts scaling the bands, one per thread.
+    int nb_slice_ctx;             ///< Number of bands, 0 if threading is not used.
+    struct SwsThreadContext *thread;
+    //@}
 } SwsContext;
 //FIXME check init (where 0)
 
@@ -670,4 +685,25 @@ void ff_sws_init_output_funcs(SwsContext *c,
 void ff_sws_init_swScale_altivec(SwsContext *c);
 void ff_sws_init_swScale_mmx(SwsContext *c);
 
+/**
+ * Start the threads running the slice contexts of c.
+ */
+int ff_sws_init_threads(SwsContext *c);
+void ff_sws_free_threads(SwsContext *c);
+
+/**
+ * Call func once for each slice context of c, in parallel, and wait for
+ * all the calls to return.
+ */
+void ff_sws_execute(SwsContext *c,
+                    void (*func)(SwsContext *c, void *arg, int jobnr),
+                    void *arg);
+
+/**
+ * Scale a whole frame with the slice contexts of c, each of them producing
+ * its band of destination lines.
+ */
+int ff_sws_scale_slices(SwsContext *c, const uint8_t *src[], int srcStride[],
+                        uint8_t *dst[], int dstStride[]);
+
 #endif /* SWSCALE_SWSCALE_INTERNAL_H */
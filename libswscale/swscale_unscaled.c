@@ -30,6 +30,7 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/cpu.h"
 #include "libavutil/avutil.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/bswap.h"
 #include "libavutil/pixdesc.h"
@@ -283,7 +284,7 @@ static int packed_16bpc_bswap(SwsContext *c, const uint8_t *src[],
     int i, j;
     int srcstr = srcStride[0] >> 1;
     int dststr = dstStride[0] >> 1;
-    uint16_t       *dstPtr =       (uint16_t *) dst[0];
+    uint16_t       *dstPtr =       (uint16_t *) (dst[0] + dstStride[0] * srcSliceY);
     const uint16_t *srcPtr = (const uint16_t *) src[0];
     int min_stride         = FFMIN(srcstr, dststr);
 
@@ -1003,6 +1004,29 @@ static int check_image_pointers(uint8_t *data[4], enum PixelFormat pix_fmt,
     return 1;
 }
 
+/**
+ * Check if a whole frame can be split between the slice threads.
+ * The bands are written concurrently, so the SIMD code writing past the
+ * end of the lines must not reach the next line.
+ */
+static int can_scale_slices(SwsContext *c, const int dstStride[4])
+{
+    int linesizes[4], i;
+
+    /* the chroma upsampling of yvu9 needs the neighbouring lines and the
+     * SIMD rgb24toyv12 handles the last lines of each call with C code,
+     * which does not round the same way */
+    if (c->swScale == yvu9ToYv12Wrapper || c->swScale == bgr24ToYv12Wrapper)
+        return 0;
+
+    av_image_fill_linesizes(linesizes, c->dstFormat, FFALIGN(c->dstW, 16));
+    for (i = 0; i < 4; i++)
+        if (linesizes[i] > dstStride[i])
+            return 0;
+
+    return 1;
+}
+
 /**
  * swscale wrapper, so we don't need to export the SwsContext.
  * Assumes planar YUV to be in YUV order instead of YVU.
@@ -1116,6 +1140,10 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
         if (srcSliceY + srcSliceH == c->srcH)
             c->sliceDir = 0;
 
+        if (HAVE_PTHREADS && c->nb_slice_ctx && srcSliceH == c->srcH &&
+            can_scale_slices(c, dstStride2))
+            return ff_sws_scale_slices(c, src2, srcStride2, dst2, dstStride2);
+
         return c->swScale(c, src2, srcStride2, srcSliceY, srcSliceH, dst2,
                           dstStride2);
     } else {
@@ -752,6 +752,13 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
                              int srcRange, const int table[4], int dstRange,
                              int brightness, int contrast, int saturation)
 {
+    int i;
+
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange,
+                                 table, dstRange, brightness, contrast,
+                                 saturation);
+
     memcpy(c->srcColorspaceTable, inv_table, sizeof(int) * 4);
     memcpy(c->dstColorspaceTable, table, sizeof(int) * 4);
 
@@ -824,8 +831,8 @@ SwsContext *sws_alloc_context(void)
     return c;
 }
 
-av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
-                             SwsFilter *dstFilter)
+static av_cold int context_init(SwsContext *c, SwsFilter *srcFilter,
+                                SwsFilter *dstFilter)
 {
     int i;
     int usesVFilter, usesHFilter;
@@ -1235,6 +1242,85 @@ fail: // FIXME replace things by appropriate error codes
     return -1;
 }
 
+static av_cold int init_slice_contexts(SwsContext *c, SwsFilter *srcFilter,
+                                       SwsFilter *dstFilter)
+{
+    /* Destination bands are multiples of 8 chroma lines, so that they start
+     * on a chroma line and line-based dithering patterns are not shifted. */
+    int align     = 8 << FFMAX(c->chrSrcVSubSample, c->chrDstVSubSample);
+    int nb_units  = (c->dstH + align - 1) / align;
+    int i, ret;
+    int nb_slices = FFMIN(c->nb_threads, nb_units);
+
+    if (nb_slices <= 1 || c->vChrDrop)
+        return 0;
+
+    c->slice_ctx = av_mallocz(sizeof(*c->slice_ctx) * nb_slices);
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_slices; i++) {
+        SwsContext *s = sws_alloc_context();
+        if (!s)
+            return AVERROR(ENOMEM);
+        c->slice_ctx[i] = s;
+        c->nb_slice_ctx++;
+
+        s->srcW      = c->srcW;
+        s->srcH      = c->srcH;
+        s->dstW      = c->dstW;
+        s->dstH      = c->dstH;
+        s->srcFormat = c->srcFormat;
+        s->dstFormat = c->dstFormat;
+        s->flags     = c->flags & ~SWS_PRINT_INFO;
+        s->param[0]  = c->param[0];
+        s->param[1]  = c->param[1];
+        sws_setColorspaceDetails(s, c->srcColorspaceTable, c->srcRange,
+                                 c->dstColorspaceTable, c->dstRange,
+                                 c->brightness, c->contrast, c->saturation);
+        if ((ret = context_init(s, srcFilter, dstFilter)) < 0)
+            return ret;
+
+        s->dstSliceY = nb_units * i / nb_slices * align;
+        s->dstSliceH = FFMIN(nb_units * (i + 1) / nb_slices * align,
+                             c->dstH) - s->dstSliceY;
+    }
+
+    return ff_sws_init_threads(c);
+}
+
+av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
+                             SwsFilter *dstFilter)
+{
+    int ret;
+
+    /* the J formats and the colorspace details are only handled by
+     * sws_getContext(), do it here for contexts set up with AVOptions */
+    if (handle_jpeg(&c->srcFormat))
+        c->srcRange = 1;
+    if (handle_jpeg(&c->dstFormat))
+        c->dstRange = 1;
+    if (!c->contrast && !c->saturation)
+        sws_setColorspaceDetails(c, ff_yuv2rgb_coeffs[SWS_CS_DEFAULT],
+                                 c->srcRange,
+                                 ff_yuv2rgb_coeffs[SWS_CS_DEFAULT],
+                                 c->dstRange, 0, 1 << 16, 1 << 16);
+
+    c->dstSliceY = 0;
+    c->dstSliceH = c->dstH;
+
+    if ((ret = context_init(c, srcFilter, dstFilter)) < 0)
+        return ret;
+
+    if (HAVE_PTHREADS && c->nb_threads > 1 &&
+        (ret = init_slice_contexts(c, srcFilter, dstFilter)) < 0) {
+        av_log(c, AV_LOG_ERROR, "Could not initialize slice threading\n");
+        return ret;
+    }
+
+    return 0;
+}
+
 #if FF_API_SWS_GETCONTEXT
 SwsContext *sws_getContext(int srcW, int srcH, enum PixelFormat srcFormat,
                            int dstW, int dstH, enum PixelFormat dstFormat,
@@ -1588,6 +1674,12 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    if (HAVE_PTHREADS)
+        ff_sws_free_threads(c);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+
     if (c->lumPixBuf) {
         for (i = 0; i < c->vLumBufSize; i++)
             av_freep(&c->lumPixBuf[i]);
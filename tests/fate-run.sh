@@ -145,6 +145,21 @@ enc_dec(){
     tests/tiny_psnr $srcfile $decfile $cmp_unit $cmp_shift
 }
 
+# write a mov file with the given options, then read it back and seek in it
+# with the mov lazy_index option set to $1
+movindex(){
+    lazy_index=$1
+    shift
+    movfile="${outdir}/${test}.mov"
+    cleanfiles=$movfile
+    tmovfile=$(target_path $movfile)
+    avconv -f image2 -vcodec pgmyuv -i $(target_path tests/vsynth1/%02d.pgm) \
+        -ar 44100 -f s16le -i $(target_path tests/data/asynth1.sw)          \
+        $ENC_OPTS $FLAGS -t 1 -qscale 10 "$@" -f mov -y $tmovfile || return
+    framecrc -lazy_index $lazy_index -i $tmovfile -c copy || return
+    run libavformat/seek-test $tmovfile lazy_index=$lazy_index
+}
+
 regtest(){
     t="${test#$2-}"
     ref=${base}/ref/$2/$t
@@ -36,7 +36,27 @@ fate-filter-yadif-mode0: CMD = framecrc -flags bitexact -idct simple -i $(SAMPLE
 FATE_YADIF += fate-filter-yadif-mode1
 fate-filter-yadif-mode1: CMD = framecrc -flags bitexact -idct simple -i $(SAMPLES)/mpeg2/mpeg2_field_encoding.ts -vf yadif=1
 
+FATE_YADIF += fate-filter-yadif-mode0-frame-threads
+fate-filter-yadif-mode0-frame-threads: CMD = framecrc -flags bitexact -idct simple -i $(SAMPLES)/mpeg2/mpeg2_field_encoding.ts -vf yadif=0 -filter_threads 2 -filter_frame_threads
+fate-filter-yadif-mode0-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-yadif-mode0
+
+FATE_YADIF += fate-filter-yadif-mode1-frame-threads
+fate-filter-yadif-mode1-frame-threads: CMD = framecrc -flags bitexact -idct simple -i $(SAMPLES)/mpeg2/mpeg2_field_encoding.ts -vf yadif=1 -filter_threads 2 -filter_frame_threads
+fate-filter-yadif-mode1-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-yadif-mode1
+
 FATE_FILTER-$(CONFIG_YADIF_FILTER) += $(FATE_YADIF)
 
 FATE_SAMPLES_AVCONV += $(FATE_FILTER-yes)
 fate-filter: $(FATE_FILTER-yes)
+
+# the filters of a chain running on their own threads must give the same
+# output as when they run one after another
+FATE_FILTER_CHAIN = fate-filter-chain fate-filter-chain-frame-threads
+$(FATE_FILTER_CHAIN): $(VREF)
+$(FATE_FILTER_CHAIN): CMD = framecrc -f image2 -vcodec pgmyuv -i $(TARGET_PATH)/tests/vsynth1/%02d.pgm -vf unsharp,scale=200:150,transpose,unsharp=7:7:-1.5 $(FILTER_OPTS) -sws_flags +accurate_rnd+bitexact
+fate-filter-chain: FILTER_OPTS = -filter_threads 1
+fate-filter-chain-frame-threads: FILTER_OPTS = -filter_threads 4 -filter_frame_threads
+fate-filter-chain-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-chain
+
+FATE_AVCONV += $(FATE_FILTER_CHAIN)
+fate-filter: $(FATE_FILTER_CHAIN)
@@ -38,5 +38,18 @@ fate-vc1_sa10143: CMD = framecrc -i $(SAMPLES)/vc1/SA10143.vc1
 FATE_VC1 += fate-vc1-ism
 fate-vc1-ism: CMD = framecrc -i $(SAMPLES)/isom/vc1-wmapro.ism -an
 
+# frame threaded decoding must be bit-exact with the single threaded one
+define FATE_VC1_FRAME_THREADS
+FATE_VC1 += fate-vc1_$(1)-frame-threads
+fate-vc1_$(1)-frame-threads: CMD = framecrc -i $(SAMPLES)/vc1/$(2).vc1
+fate-vc1_$(1)-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/vc1_$(1)
+fate-vc1_$(1)-frame-threads: THREADS = 4
+fate-vc1_$(1)-frame-threads: THREAD_TYPE = frame
+endef
+
+$(eval $(call FATE_VC1_FRAME_THREADS,sa10091,SA10091))
+$(eval $(call FATE_VC1_FRAME_THREADS,sa20021,SA20021))
+$(eval $(call FATE_VC1_FRAME_THREADS,sa10143,SA10143))
+
 FATE_SAMPLES_AVCONV += $(FATE_VC1)
 fate-vc1: $(FATE_VC1)
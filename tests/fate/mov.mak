@@ -0,0 +1,34 @@
+# The lazy index of the mov demuxer must give the same packets and seek
+# results as the full index, so the lazy tests use the references of the
+# full index tests.
+define FATE_MOV_INDEX
+FATE_MOV += fate-mov-index-$(1) fate-mov-lazy-$(1)
+fate-mov-index-$(1): CMD = movindex 0 $(2)
+fate-mov-lazy-$(1):  CMD = movindex 1 $(2)
+fate-mov-lazy-$(1):  REF = $(SRC_PATH)/tests/ref/fate/mov-index-$(1)
+endef
+
+# stss, ctts and an edit list, compressed audio
+$(eval $(call FATE_MOV_INDEX,ctts,-c:v mpeg4 -bf 2 -c:a mp2))
+# stps for the open GOPs, audio read in chunks
+$(eval $(call FATE_MOV_INDEX,stps,-c:v mpeg2video -bf 2 -g 6 -c:a pcm_s16le))
+# fragments, which always get a full index
+$(eval $(call FATE_MOV_INDEX,frag,-c:v mpeg4 -g 6 -c:a pcm_s16be -movflags frag_keyframe))
+
+$(FATE_MOV): $(AREF) $(VREF) libavformat/seek-test$(EXESUF)
+
+FATE_AVCONV += $(FATE_MOV)
+
+define FATE_MOV_LAZY_SAMPLE
+FATE_MOV_SAMPLES += fate-mov-lazy-$(1)
+fate-mov-lazy-$(1): CMD = framecrc -lazy_index 1 $(2)
+fate-mov-lazy-$(1): REF = $(SRC_PATH)/tests/ref/fate/$(1)
+endef
+
+$(eval $(call FATE_MOV_LAZY_SAMPLE,svq3,-i $(SAMPLES)/svq3/Vertical400kbit.sorenson3.mov -t 6 -an))
+$(eval $(call FATE_MOV_LAZY_SAMPLE,h264-interlace-crop,-i $(SAMPLES)/h264/interlaced_crop.mp4 -vframes 3))
+$(eval $(call FATE_MOV_LAZY_SAMPLE,vc1-ism,-i $(SAMPLES)/isom/vc1-wmapro.ism -an))
+
+FATE_SAMPLES_AVCONV += $(FATE_MOV_SAMPLES)
+
+fate-mov: $(FATE_MOV) $(FATE_MOV_SAMPLES)
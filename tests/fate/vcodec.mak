@@ -105,7 +105,8 @@ FATE_MPEG2 = mpeg2                                                      \
              mpeg2-ilace                                                \
              mpeg2-ivlc-qprd                                            \
              mpeg2-thread                                               \
-             mpeg2-thread-ivlc
+             mpeg2-thread-ivlc                                          \
+             mpeg2-thread-32
 
 FATE_VCODEC += $(FATE_MPEG2)
 
@@ -135,6 +136,10 @@ fate-vsynth%-mpeg2-thread:       ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
                                            -threads 2 -slices 2
 fate-vsynth%-mpeg2-thread-ivlc:  ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
                                            -intra_vlc 1 -threads 2 -slices 2
+fate-vsynth%-mpeg2-thread-32:    ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
+                                           -threads 32
+fate-vsynth%-mpeg2-thread-32:    THREADS = 32
+fate-vsynth%-mpeg2-thread-32:    THREAD_TYPE = slice
 
 FATE_VCODEC += mpeg4
 fate-vsynth%-mpeg4:              ENCOPTS = -qscale 10 -flags +mv4 -mbd bits
@@ -168,6 +173,12 @@ fate-vsynth%-mpeg4-thread:       ENCOPTS = -b 500k -flags +mv4+aic         \
                                            -mbd bits -ps 200 -bf 2         \
                                            -threads 2 -slices 2
 
+FATE_VCODEC += mpeg4-thread-32
+fate-vsynth%-mpeg4-thread-32:    ENCOPTS = -b 500k -flags +mv4+aic -mbd bits \
+                                           -bf 2 -threads 32
+fate-vsynth%-mpeg4-thread-32:    THREADS = 32
+fate-vsynth%-mpeg4-thread-32:    THREAD_TYPE = frame
+
 FATE_VCODEC += mpeg4-error
 fate-vsynth%-mpeg4-error:        ENCOPTS = -qscale 7 -flags +mv4+aic    \
                                            -data_partitioning 1 -mbd rd \
@@ -67,6 +67,7 @@ do_lavfi_pixfmts "hflip"   ""
 do_lavfi_pixfmts "null"    ""
 do_lavfi_pixfmts "pad"     "500:400:20:20"
 do_lavfi_pixfmts "scale"   "200:100"
+do_lavfi_pixfmts "transpose" ""
 do_lavfi_pixfmts "vflip"   ""
 
 if [ -n "$do_pixdesc" ]; then
@@ -0,0 +1,139 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the cost of resampling many streams in small frames, e.g.
+ *   avresample_bench -s 32 -f 64 -r 48000 44100
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/audioconvert.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/samplefmt.h"
+#include "libavutil/time.h"
+#include "libavresample/avresample.h"
+
+static int usage(const char *argv0, int ret)
+{
+    fprintf(stderr, "%s [-s streams] [-f frame_size] [-n frames] "
+            "[-l filter_size] [-r in_rate out_rate]\n", argv0);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int streams = 32, frame_size = 64, frames = 20000, filter_size = 16;
+    int in_rate = 48000, out_rate = 44100;
+    int ret = 1, out_size = 0, i, j;
+    int64_t in_total = 0, out_total = 0, start_time, end_time;
+    AVAudioResampleContext **avr;
+    int16_t *in = NULL, *out = NULL;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            streams = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            frame_size = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+            filter_size = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-r") && i + 2 < argc) {
+            in_rate  = atoi(argv[++i]);
+            out_rate = atoi(argv[++i]);
+        } else {
+            return usage(argv[0], 1);
+        }
+    }
+    if (streams <= 0 || frame_size <= 0 || frames <= 0 || filter_size <= 0 ||
+        in_rate <= 0 || out_rate <= 0)
+        return usage(argv[0], 1);
+
+    avr = av_mallocz(streams * sizeof(*avr));
+    in  = av_malloc(frame_size * 2 * sizeof(*in));
+    if (!avr || !in)
+        goto end;
+    for (i = 0; i < frame_size * 2; i++)
+        in[i] = (i * 997) & 0x3fff;
+
+    for (i = 0; i < streams; i++) {
+        if (!(avr[i] = avresample_alloc_context()))
+            goto end;
+        av_opt_set_int(avr[i], "in_channel_layout",  AV_CH_LAYOUT_STEREO, 0);
+        av_opt_set_int(avr[i], "out_channel_layout", AV_CH_LAYOUT_STEREO, 0);
+        av_opt_set_int(avr[i], "in_sample_fmt",      AV_SAMPLE_FMT_S16,   0);
+        av_opt_set_int(avr[i], "out_sample_fmt",     AV_SAMPLE_FMT_S16,   0);
+        av_opt_set_int(avr[i], "in_sample_rate",     in_rate,             0);
+        av_opt_set_int(avr[i], "out_sample_rate",    out_rate,            0);
+        av_opt_set_int(avr[i], "filter_size",        filter_size,         0);
+        if (avresample_open(avr[i]) < 0) {
+            fprintf(stderr, "Unable to open the resampler\n");
+            goto end;
+        }
+    }
+
+    start_time = av_gettime();
+    for (j = 0; j < frames; j++) {
+        for (i = 0; i < streams; i++) {
+            int nb_samples = avresample_get_out_samples(avr[i], frame_size);
+
+            if (nb_samples < 0)
+                goto end;
+            if (nb_samples > out_size) {
+                av_free(out);
+                out_size = nb_samples;
+                out = av_malloc(out_size * 2 * sizeof(*out));
+                if (!out)
+                    goto end;
+            }
+            nb_samples = avresample_convert(avr[i], (void **)&out, 0,
+                                            out_size, (void **)&in, 0,
+                                            frame_size);
+            if (nb_samples < 0 || avresample_available(avr[i])) {
+                fprintf(stderr, "Conversion error\n");
+                goto end;
+            }
+            out_total += nb_samples;
+        }
+        in_total += frame_size;
+    }
+    end_time = av_gettime();
+
+    printf("%d streams, %d frames of %d samples, %d -> %d Hz: "
+           "%"PRId64" -> %"PRId64" samples per stream in %.3f s, "
+           "%.0f frames/s\n",
+           streams, frames, frame_size, in_rate, out_rate,
+           in_total, out_total / streams, (end_time - start_time) / 1000000.0,
+           (double)frames * streams * 1000000 / FFMAX(end_time - start_time, 1));
+    ret = 0;
+
+end:
+    if (avr)
+        for (i = 0; i < streams; i++)
+            avresample_free(&avr[i]);
+    av_free(avr);
+    av_free(in);
+    av_free(out);
+    return ret;
+}
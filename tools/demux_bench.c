@@ -0,0 +1,174 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the throughput of a demuxer alone, without decoding, e.g.
+ *   demux_bench -n 10 input.ts
+ * Only the av_read_frame() loop following avformat_find_stream_info() is
+ * timed.
+ * With -p, only the given program is kept and the other ones are discarded.
+ * With -s, the per PID statistics of an MPEG-TS input are printed.
+ * With -o, an option is passed to the demuxer, e.g. -o lazy_index=1.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libavutil/dict.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+
+/* discard every stream and program but the given program */
+static void keep_program(AVFormatContext *ic, int id)
+{
+    int i, j;
+
+    for (i = 0; i < ic->nb_streams; i++)
+        ic->streams[i]->discard = AVDISCARD_ALL;
+    for (i = 0; i < ic->nb_programs; i++) {
+        AVProgram *p = ic->programs[i];
+
+        if (p->id != id) {
+            p->discard = AVDISCARD_ALL;
+            continue;
+        }
+        for (j = 0; j < p->nb_stream_indexes; j++)
+            ic->streams[p->stream_index[j]]->discard = AVDISCARD_DEFAULT;
+    }
+}
+
+static void print_pid_stats(AVFormatContext *ic)
+{
+    const AVMpegTSPIDStats *stats = av_mpegts_get_pid_stats(ic);
+    int pid;
+
+    if (!stats)
+        return;
+    for (pid = 0; pid < 8192; pid++)
+        if (stats[pid].packets)
+            printf("pid %4d: %"PRIu64" packets, %"PRIu64" bytes, "
+                   "%"PRIu64" continuity errors\n", pid, stats[pid].packets,
+                   stats[pid].bytes, stats[pid].cc_errors);
+}
+
+static int usage(const char *argv0, int ret)
+{
+    fprintf(stderr, "%s [-n runs] [-f format] [-p program] [-s] "
+            "[-o option=value] input\n", argv0);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int runs = 1, program = -1, pid_stats = 0, run, ret, i;
+    const char *input = NULL;
+    AVInputFormat *fmt = NULL;
+    AVDictionary *fmt_opts = NULL;
+    int64_t packets = 0, bytes = 0, in_bytes = 0, start_time, wall_time = 0;
+    int64_t open_time = 0;
+    clock_t start_cpu, cpu_time = 0;
+    double wall, cpu;
+    char errbuf[50];
+
+    av_register_all();
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            if (!(fmt = av_find_input_format(argv[++i]))) {
+                fprintf(stderr, "Unknown input format %s\n", argv[i]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+            program = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-s")) {
+            pid_stats = 1;
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            char *val = strchr(argv[++i], '=');
+            if (!val)
+                return usage(argv[0], 1);
+            *val++ = 0;
+            av_dict_set(&fmt_opts, argv[i], val, 0);
+        } else if (!input) {
+            input = argv[i];
+        } else {
+            return usage(argv[0], 1);
+        }
+    }
+    if (!input || runs <= 0)
+        return usage(argv[0], 1);
+
+    for (run = 0; run < runs; run++) {
+        AVFormatContext *ic = NULL;
+        AVDictionary *opts = NULL;
+        AVPacket pkt;
+
+        av_dict_copy(&opts, fmt_opts, 0);
+        if (pid_stats)
+            av_dict_set(&opts, "pid_stats", "1", 0);
+        start_time = av_gettime();
+        ret = avformat_open_input(&ic, input, fmt, &opts);
+        open_time += av_gettime() - start_time;
+        av_dict_free(&opts);
+        if (ret < 0) {
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            fprintf(stderr, "Unable to open %s: %s\n", input, errbuf);
+            return 1;
+        }
+        if (avformat_find_stream_info(ic, NULL) < 0) {
+            fprintf(stderr, "Unable to find the stream parameters\n");
+            avformat_close_input(&ic);
+            return 1;
+        }
+        if (program >= 0)
+            keep_program(ic, program);
+
+        start_time = av_gettime();
+        start_cpu  = clock();
+        while (av_read_frame(ic, &pkt) >= 0) {
+            packets++;
+            bytes += pkt.size;
+            av_free_packet(&pkt);
+        }
+        wall_time += av_gettime() - start_time;
+        cpu_time  += clock() - start_cpu;
+
+        if (!run) {
+            printf("%s: %d streams, %s\n", input, ic->nb_streams,
+                   ic->iformat->name);
+            if (pid_stats)
+                print_pid_stats(ic);
+        }
+        in_bytes += avio_size(ic->pb);
+        avformat_close_input(&ic);
+    }
+    av_dict_free(&fmt_opts);
+    cpu  = (double)cpu_time / CLOCKS_PER_SEC;
+    wall = wall_time / 1000000.0;
+
+    printf("%d runs: opened in %.3f s, %"PRId64" packets, %"PRId64" bytes "
+           "of payload in %.3f s (%.3f s cpu): %.0f pkt/s, %.1f MB/s of input\n",
+           runs, open_time / 1000000.0, packets, bytes, wall, cpu,
+           wall > 0 ? packets / wall : 0,
+           wall > 0 ? in_bytes / wall / (1 << 20) : 0);
+    return 0;
+}
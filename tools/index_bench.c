@@ -0,0 +1,153 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the cost of building a large generic index out of order, e.g.
+ *   index_bench -n 10000000
+ * The input is a virtual GSM file of n keyframes. Its second half is read
+ * first, then its first half, whose entries all go before the existing ones.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/dict.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+
+#define BLOCK_SIZE 33
+
+typedef struct VirtualFile {
+    int64_t pos, size;
+} VirtualFile;
+
+static int read_zeros(void *opaque, uint8_t *buf, int size)
+{
+    VirtualFile *f = opaque;
+
+    size = FFMIN(size, f->size - f->pos);
+    memset(buf, 0, size);
+    f->pos += size;
+    return size;
+}
+
+static int64_t seek_file(void *opaque, int64_t offset, int whence)
+{
+    VirtualFile *f = opaque;
+
+    if (whence == AVSEEK_SIZE)
+        return f->size;
+    if (whence != SEEK_SET || offset < 0 || offset > f->size)
+        return AVERROR(EINVAL);
+    return f->pos = offset;
+}
+
+/* read packets until end of file or a packet starting at end */
+static int64_t read_until(AVFormatContext *ic, int64_t end)
+{
+    AVPacket pkt;
+    int64_t packets = 0;
+
+    while (av_read_frame(ic, &pkt) >= 0) {
+        int64_t pos = pkt.pos;
+
+        av_free_packet(&pkt);
+        if (pos >= end)
+            break;
+        packets++;
+    }
+    return packets;
+}
+
+static int usage(const char *argv0, int ret)
+{
+    fprintf(stderr, "%s [-n entries]\n", argv0);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int entries = 10000000, ret = 1, i;
+    VirtualFile file = { 0 };
+    AVFormatContext *ic = NULL;
+    AVIOContext *pb;
+    AVDictionary *opts = NULL;
+    uint8_t *buf;
+    int64_t t0, t1, t2, t3, packets;
+    char indexmem[32];
+
+    av_register_all();
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            entries = atoi(argv[++i]);
+        } else {
+            return usage(argv[0], 1);
+        }
+    }
+    if (entries < 2)
+        return usage(argv[0], 1);
+
+    file.size = (int64_t)entries * BLOCK_SIZE;
+    if (!(buf = av_malloc(32768)))
+        return 1;
+    pb = avio_alloc_context(buf, 32768, 0, &file, read_zeros, NULL, seek_file);
+    if (!pb || !(ic = avformat_alloc_context())) {
+        av_free(buf);
+        av_free(pb);
+        return 1;
+    }
+    ic->pb = pb;
+    /* room for every entry, so that none is dropped */
+    snprintf(indexmem, sizeof(indexmem), "%"PRId64,
+             (int64_t)entries * 2 * sizeof(AVIndexEntry));
+    av_dict_set(&opts, "indexmem", indexmem, 0);
+    if (avformat_open_input(&ic, NULL, av_find_input_format("gsm"),
+                            &opts) < 0) {
+        fprintf(stderr, "Unable to open the virtual input\n");
+        goto end;
+    }
+
+    t0 = av_gettime();
+    if (av_seek_frame(ic, -1, entries / 2 * BLOCK_SIZE, AVSEEK_FLAG_BYTE) < 0)
+        goto end;
+    packets = read_until(ic, file.size);
+    t1 = av_gettime();
+    if (av_seek_frame(ic, -1, 0, AVSEEK_FLAG_BYTE) < 0)
+        goto end;
+    packets += read_until(ic, entries / 2 * BLOCK_SIZE);
+    t2 = av_gettime();
+    /* the first search merges what is left to merge */
+    i = av_index_search_timestamp(ic->streams[0], entries - 1, 0);
+    t3 = av_gettime();
+
+    printf("%"PRId64" packets, last entry %d: second half in order %.3f s, "
+           "first half before it %.3f s, final search %.3f s\n",
+           packets, i, (t1 - t0) / 1000000.0, (t2 - t1) / 1000000.0,
+           (t3 - t2) / 1000000.0);
+    ret = 0;
+
+end:
+    av_dict_free(&opts);
+    avformat_close_input(&ic);
+    av_freep(&pb->buffer);
+    av_free(pb);
+    return ret;
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the datagram rate of a packet protocol, with the same packet
+ * size on both ends, e.g. over loopback:
+ *   udpbench recv "udp://127.0.0.1:1234?batch_size=32" &
+ *   udpbench send "udp://127.0.0.1:1234?batch_size=32"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libavutil/intreadwrite.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+
+static int64_t last_activity;
+
+static int idle_timeout(void *opaque)
+{
+    return last_activity && av_gettime() - last_activity > AV_TIME_BASE;
+}
+
+static int usage(const char *argv0, int ret)
+{
+    fprintf(stderr, "%s [-n packets] [-s size] send|recv url\n", argv0);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int packets = 1000000, size = 1316, count = 0, ret, i;
+    const char *mode = NULL, *url = NULL;
+    AVIOInterruptCB int_cb = { idle_timeout, NULL };
+    AVIOContext *pb;
+    uint8_t *buf;
+    int64_t start_time = 0, end_time;
+    clock_t start_cpu = 0;
+    double wall, cpu;
+    char errbuf[50];
+
+    av_register_all();
+    avformat_network_init();
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            packets = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            size = atoi(argv[++i]);
+        } else if (!mode) {
+            mode = argv[i];
+        } else if (!url) {
+            url = argv[i];
+        } else {
+            return usage(argv[0], 1);
+        }
+    }
+    if (!url || size <= 0 || (strcmp(mode, "send") && strcmp(mode, "recv")))
+        return usage(argv[0], 1);
+
+    ret = avio_open2(&pb, url,
+                     !strcmp(mode, "send") ? AVIO_FLAG_WRITE : AVIO_FLAG_READ,
+                     &int_cb, NULL);
+    if (ret) {
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        fprintf(stderr, "Unable to open %s: %s\n", url, errbuf);
+        return 1;
+    }
+    buf = av_mallocz(size);
+    if (!buf) {
+        avio_close(pb);
+        return 1;
+    }
+
+    if (!strcmp(mode, "send")) {
+        start_time = av_gettime();
+        start_cpu  = clock();
+        for (count = 0; count < packets && !pb->error; count++) {
+            AV_WB32(buf, count);
+            avio_write(pb, buf, size);
+            avio_flush(pb);
+        }
+        avio_close(pb);
+        end_time = av_gettime();
+    } else {
+        end_time = 0;
+        while (count < packets) {
+            if (avio_read(pb, buf, size) <= 0)
+                break;
+            end_time = last_activity = av_gettime();
+            if (!count++) {
+                start_time = end_time;
+                start_cpu  = clock();
+            }
+        }
+        avio_close(pb);
+        /* the first datagram only starts the clock */
+        count = FFMAX(count - 1, 0);
+    }
+    cpu  = (double)(clock() - start_cpu) / CLOCKS_PER_SEC;
+    wall = (end_time - start_time) / 1000000.0;
+
+    printf("%d packets of %d bytes in %.3f s (%.3f s cpu): "
+           "%.0f pkt/s, %.0f pkt/s per core\n",
+           count, size, wall, cpu,
+           wall > 0 ? count / wall : 0, cpu > 0 ? count / cpu : 0);
+
+    av_free(buf);
+    avformat_network_deinit();
+    return 0;
+}